@@ -0,0 +1,458 @@
+/**
+ * The purpose of this hpp file is to define the ChildMap class, a compact
+ * map from a key character to a child node. It replaces the per-node
+ * unordered_map of the MultiWay Trie with the node layouts of the
+ * Adaptive Radix Tree, picked automatically by the number of children:
+ *
+ *   Node4    up to 4 children, sorted keys and pointers in one block
+ *            (the block starts at 1 and 2 slots, most nodes have a single
+ *            child)
+ *   Node16   up to 16 children, the same sorted arrays
+ *   Node48   up to 48 children, a 256 byte index from the key to one of
+ *            48 child slots
+ *   Node256  a table of 256 pointers indexed directly by the key byte
+ *
+ * A map grows into the next layout when it is full and shrinks back when
+ * erase() leaves it mostly empty. Iteration is always in increasing
+ * (unsigned) key order. Node4 and Node16 compare all their keys at once
+ * with SSE2 when the compiler targets it, and search with a scalar loop
+ * otherwise or when CHILD_MAP_SCALAR is defined (meson configure
+ * -Dchild_map_simd=false). The storage comes from the NodeArena of the
+ * owning trie, which also frees it, so a ChildMap has no destructor of
+ * its own.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: std::memmove doc, Leis et al. "The Adaptive Radix Tree:
+ *          ARTful Indexing for Main-Memory Databases", Intel intrinsics
+ *          guide (_mm_cmpeq_epi8, _mm_movemask_epi8)
+ */
+#ifndef CHILD_MAP_HPP
+#define CHILD_MAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <utility>
+#include "NodeArena.hpp"
+
+#if defined(__SSE2__) && !defined(CHILD_MAP_SCALAR)
+#define CHILD_MAP_SSE2
+#include <emmintrin.h>
+#endif
+
+template <typename Node>
+class ChildMap {
+  private:
+    //the most children of each layout
+    static const unsigned int NODE4_MAX = 4;
+    static const unsigned int NODE16_MAX = 16;
+    static const unsigned int NODE48_MAX = 48;
+    //number of slots in the index of a Node48 and the table of a Node256,
+    //one for every possible byte
+    static const unsigned int DENSE_SIZE = 256;
+
+    //erase() moves to the next smaller layout once the count is down to
+    //these, a little below that layout's size so that erasing and adding
+    //one child does not move the map back and forth
+    static const unsigned int SHRINK_TO_NODE4 = 3;
+    static const unsigned int SHRINK_TO_NODE16 = 12;
+    static const unsigned int SHRINK_TO_NODE48 = 40;
+
+    /** How the block is laid out */
+    enum Layout : uint8_t {
+        //Node4 and Node16: capacity keys then capacity pointers
+        SORTED,
+        //Node48: 256 slot numbers (0 for none) then 48 pointers
+        INDEXED,
+        //Node256: 256 pointers
+        DENSE
+    };
+
+    void* block;
+    //number of children stored
+    uint16_t count;
+    //number of children the block can hold before growing
+    uint16_t capacity;
+    Layout layout;
+
+    /* Returns the offset of the pointer array inside a sorted block of the
+     * given capacity, the key bytes rounded up to pointer alignment.
+     */
+    static size_t ptrOffset( unsigned int cap ) {
+        return ( cap + sizeof(Node*) - 1 ) / sizeof(Node*) * sizeof(Node*);
+    }
+
+    /* Returns the number of bytes a block of the given layout and
+     * capacity takes up.
+     */
+    static size_t blockBytes( Layout lay, unsigned int cap ) {
+        if( lay == DENSE ) {
+            return DENSE_SIZE * sizeof(Node*);
+        }
+        if( lay == INDEXED ) {
+            return DENSE_SIZE + NODE48_MAX * sizeof(Node*);
+        }
+        return ptrOffset( cap ) + cap * sizeof(Node*);
+    }
+
+    unsigned char* keys() const { return (unsigned char*) block; }
+
+    //the slot numbers of a Node48, key k's child is in slot index()[k]-1
+    unsigned char* index() const { return (unsigned char*) block; }
+
+    Node** ptrs() const {
+        if( layout == DENSE ) {
+            return (Node**) block;
+        }
+        if( layout == INDEXED ) {
+            return (Node**) ( (char*) block + DENSE_SIZE );
+        }
+        return (Node**) ( (char*) block + ptrOffset( capacity ) );
+    }
+
+    /* Returns the position of key in the sorted key array, -1 if it is
+     * not there. With SSE2 every key is compared in one instruction and
+     * the unused ones are masked off, so there is no loop branch to
+     * mispredict: a Node16 loads its 16 key bytes, a Node4 the 8 bytes
+     * its keys are padded to.
+     */
+    int search( unsigned char key ) const {
+
+#ifdef CHILD_MAP_SSE2
+        //an empty map has no block to load from
+        if( count == 0 ) {
+            return -1;
+        }
+        __m128i all = capacity == NODE16_MAX
+                          ? _mm_loadu_si128( (const __m128i*) block )
+                          : _mm_loadl_epi64( (const __m128i*) block );
+        __m128i hits = _mm_cmpeq_epi8( all, _mm_set1_epi8( (char) key ) );
+        unsigned int mask = _mm_movemask_epi8( hits ) &
+                            ( ( 1u << count ) - 1 );
+        return mask == 0 ? -1 : __builtin_ctz( mask );
+#else
+        unsigned char* k = keys();
+        for( unsigned int i = 0; i < count && k[i] <= key; i++ ) {
+            if( k[i] == key ) {
+                return i;
+            }
+        }
+        return -1;
+#endif
+
+    }
+
+    /* Returns the position of key in the sorted key array, or the
+     * position it would be inserted at if it is not there.
+     */
+    unsigned int lowerBound( unsigned char key ) const {
+        unsigned char* k = keys();
+        unsigned int i = 0;
+        while( i < count && k[i] < key ) {
+            i++;
+        }
+        return i;
+    }
+
+    /* Copies every child into a new block of the given layout and
+     * capacity and gives the old block back. The children are read in key
+     * order, so a sorted block comes out sorted.
+     *
+     * Parameter: lay - the layout of the new block
+     * Parameter: cap - the capacity of the new block
+     * Parameter: arena - the arena both blocks come from
+     */
+    void relayout( Layout lay, unsigned int cap, NodeArena & arena ) {
+
+        unsigned char oldKeys[DENSE_SIZE];
+        Node* oldPtrs[DENSE_SIZE];
+        unsigned int n = 0;
+        for( iterator it = begin(); it != end(); ++it ) {
+            oldKeys[n] = (unsigned char) it->first;
+            oldPtrs[n] = it->second;
+            n++;
+        }
+        void* oldBlock = block;
+        size_t oldBytes = bytes();
+
+        block = arena.allocate( blockBytes( lay, cap ) );
+        layout = lay;
+        capacity = cap;
+        if( lay == DENSE ) {
+            std::memset( block, 0, DENSE_SIZE * sizeof(Node*) );
+            for( unsigned int i = 0; i < n; i++ ) {
+                ptrs()[oldKeys[i]] = oldPtrs[i];
+            }
+        } else if( lay == INDEXED ) {
+            std::memset( block, 0, DENSE_SIZE );
+            for( unsigned int i = 0; i < n; i++ ) {
+                index()[oldKeys[i]] = i + 1;
+                ptrs()[i] = oldPtrs[i];
+            }
+        } else if( n > 0 ) {
+            //memcpy must not be handed a null pointer even for zero bytes
+            std::memcpy( keys(), oldKeys, n );
+            std::memcpy( ptrs(), oldPtrs, n * sizeof(Node*) );
+        }
+
+        if( oldBlock != nullptr ) {
+            arena.release( oldBlock, oldBytes );
+        }
+
+    }
+
+    /* Moves the children into the next bigger layout: the sorted arrays
+     * double up to 4, then jump to 16, then to a Node48 and a Node256.
+     *
+     * Parameter: arena - the arena the blocks come from
+     */
+    void grow( NodeArena & arena ) {
+
+        if( layout == INDEXED ) {
+            relayout( DENSE, DENSE_SIZE, arena );
+        } else if( capacity == NODE16_MAX ) {
+            relayout( INDEXED, NODE48_MAX, arena );
+        } else if( capacity == NODE4_MAX ) {
+            relayout( SORTED, NODE16_MAX, arena );
+        } else {
+            relayout( SORTED, capacity == 0 ? 1 : capacity * 2, arena );
+        }
+
+    }
+
+  public:
+    /** Iterates over the (key, child) pairs in increasing key order */
+    class iterator {
+      private:
+        const ChildMap* map;
+        //index into the sorted arrays, or the key byte of a Node48 or
+        //Node256
+        unsigned int pos;
+        //the pair the iterator currently points at
+        std::pair<char, Node*> entry;
+
+        /* Skips empty slots of an indexed or dense block and loads the
+         * current pair
+         */
+        void settle() {
+            if( map->layout == DENSE ) {
+                Node** table = map->ptrs();
+                while( pos < DENSE_SIZE && table[pos] == nullptr ) {
+                    pos++;
+                }
+                if( pos < DENSE_SIZE ) {
+                    entry = std::pair<char, Node*>( (char) pos, table[pos] );
+                }
+            } else if( map->layout == INDEXED ) {
+                unsigned char* slot = map->index();
+                while( pos < DENSE_SIZE && slot[pos] == 0 ) {
+                    pos++;
+                }
+                if( pos < DENSE_SIZE ) {
+                    entry = std::pair<char, Node*>(
+                        (char) pos, map->ptrs()[slot[pos] - 1] );
+                }
+            } else if( pos < map->count ) {
+                entry = std::pair<char, Node*>( (char) map->keys()[pos],
+                                                map->ptrs()[pos] );
+            }
+        }
+
+      public:
+        iterator( const ChildMap* map, unsigned int pos )
+            : map(map), pos(pos) {
+            settle();
+        }
+
+        const std::pair<char, Node*> & operator*() const { return entry; }
+
+        const std::pair<char, Node*> * operator->() const { return &entry; }
+
+        iterator & operator++() {
+            pos++;
+            settle();
+            return *this;
+        }
+
+        iterator operator++( int ) {
+            iterator old = *this;
+            ++(*this);
+            return old;
+        }
+
+        bool operator==( const iterator & other ) const {
+            return pos == other.pos;
+        }
+
+        bool operator!=( const iterator & other ) const {
+            return pos != other.pos;
+        }
+    };
+
+    ChildMap() : block(nullptr), count(0), capacity(0), layout(SORTED) {}
+
+    ChildMap( const ChildMap & other ) = delete;
+    ChildMap & operator=( const ChildMap & other ) = delete;
+
+    /* Returns the child stored under key, nullptr if there is none.
+     *
+     * Parameter: key - the character of the edge to the child
+     */
+    Node* find( char key ) const {
+
+        unsigned char k = (unsigned char) key;
+        if( layout == DENSE ) {
+            return ptrs()[k];
+        }
+        if( layout == INDEXED ) {
+            unsigned char slot = index()[k];
+            return slot == 0 ? nullptr : ptrs()[slot - 1];
+        }
+        int i = search( k );
+        return i < 0 ? nullptr : ptrs()[i];
+
+    }
+
+    /* Adds child under key. The key must not be in the map already.
+     *
+     * Parameter: key - the character of the edge to the child
+     * Parameter: child - the node the edge leads to
+     * Parameter: arena - the arena the map's storage comes from
+     */
+    void insert( char key, Node* child, NodeArena & arena ) {
+
+        unsigned char k = (unsigned char) key;
+        if( count == capacity ) {
+            grow( arena );
+        }
+
+        if( layout == DENSE ) {
+            ptrs()[k] = child;
+        } else if( layout == INDEXED ) {
+            ptrs()[count] = child;
+            index()[k] = count + 1;
+        } else {
+            //shift the bigger keys over to keep both arrays sorted
+            unsigned int i = lowerBound( k );
+            std::memmove( keys() + i + 1, keys() + i, count - i );
+            std::memmove( ptrs() + i + 1, ptrs() + i,
+                          ( count - i ) * sizeof(Node*) );
+            keys()[i] = k;
+            ptrs()[i] = child;
+        }
+        count++;
+
+    }
+
+    /* Adds child under key, which must be bigger than every key already
+     * in the map, so nothing has to be searched or shifted. This is the
+     * case when words arrive in sorted order.
+     *
+     * Parameter: key - the character of the edge to the child
+     * Parameter: child - the node the edge leads to
+     * Parameter: arena - the arena the map's storage comes from
+     */
+    void append( char key, Node* child, NodeArena & arena ) {
+
+        if( layout != SORTED || count == capacity ) {
+            insert( key, child, arena );
+            return;
+        }
+        keys()[count] = (unsigned char) key;
+        ptrs()[count] = child;
+        count++;
+
+    }
+
+    /* Points the edge under key, which must be in the map, at a new child.
+     *
+     * Parameter: key - the character of the edge to the child
+     * Parameter: child - the node the edge leads to from now on
+     */
+    void replace( char key, Node* child ) {
+
+        unsigned char k = (unsigned char) key;
+        if( layout == DENSE ) {
+            ptrs()[k] = child;
+        } else if( layout == INDEXED ) {
+            ptrs()[index()[k] - 1] = child;
+        } else {
+            ptrs()[search( k )] = child;
+        }
+
+    }
+
+    /* Removes the child under key and returns true, or returns false if
+     * there is none. A map left mostly empty moves to a smaller layout,
+     * and an empty one gives its block back.
+     *
+     * Parameter: key - the character of the edge to the child
+     * Parameter: arena - the arena the map's storage comes from
+     */
+    bool erase( char key, NodeArena & arena ) {
+
+        unsigned char k = (unsigned char) key;
+        if( find( key ) == nullptr ) {
+            return false;
+        }
+
+        if( layout == DENSE ) {
+            ptrs()[k] = nullptr;
+        } else if( layout == INDEXED ) {
+            //fill the hole with the last slot so the slots stay packed
+            unsigned char slot = index()[k];
+            index()[k] = 0;
+            if( slot != count ) {
+                ptrs()[slot - 1] = ptrs()[count - 1];
+                for( unsigned int j = 0; j < DENSE_SIZE; j++ ) {
+                    if( index()[j] == count ) {
+                        index()[j] = slot;
+                        break;
+                    }
+                }
+            }
+        } else {
+            unsigned int i = search( k );
+            std::memmove( keys() + i, keys() + i + 1, count - i - 1 );
+            std::memmove( ptrs() + i, ptrs() + i + 1,
+                          ( count - i - 1 ) * sizeof(Node*) );
+        }
+        count--;
+
+        if( count == 0 ) {
+            arena.release( block, bytes() );
+            block = nullptr;
+            capacity = 0;
+            layout = SORTED;
+        } else if( layout == DENSE && count <= SHRINK_TO_NODE48 ) {
+            relayout( INDEXED, NODE48_MAX, arena );
+        } else if( layout == INDEXED && count <= SHRINK_TO_NODE16 ) {
+            relayout( SORTED, NODE16_MAX, arena );
+        } else if( capacity == NODE16_MAX && count <= SHRINK_TO_NODE4 ) {
+            relayout( SORTED, NODE4_MAX, arena );
+        }
+        return true;
+
+    }
+
+    /* Returns the number of children in the map */
+    unsigned int size() const { return count; }
+
+    /* Returns true if the map holds no children */
+    bool empty() const { return count == 0; }
+
+    /* Returns the number of heap bytes the map's storage takes up */
+    size_t bytes() const {
+        return block == nullptr ? 0 : blockBytes( layout, capacity );
+    }
+
+    iterator begin() const { return iterator( this, 0 ); }
+
+    iterator end() const {
+        return iterator( this, layout == SORTED ? count : DENSE_SIZE );
+    }
+};
+
+#endif  // CHILD_MAP_HPP
@@ -0,0 +1,173 @@
+/**
+ * The purpose of this cpp file is to provide implementation for the
+ * methods of the CompletionCursor class. A level's ranked words and its
+ * frontier together cover the whole subtree of its prefix, and every
+ * ranked word comes before everything in the frontier. Keeping only the
+ * words and entries under one more character keeps both of those true,
+ * so a child level is a filtered copy of its parent's.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: std::push_heap doc
+ */
+#include "CompletionCursor.hpp"
+#include <algorithm>
+
+/* Starts a cursor on the empty prefix of trie
+ *
+ * Parameter: trie - the dictionary to complete from
+ */
+CompletionCursor::CompletionCursor( const DictionaryTrie & trie )
+    : trie(trie) {
+
+    Level start;
+    start.node = trie.root;
+    start.frontier.push_back(
+        CompletionEntry{ trie.root->maxFreq, "", trie.root } );
+    levels.push_back( std::move( start ) );
+
+}
+
+/* Types one more character. Returns false if no word starts with the
+ * new prefix, in which case topK() is empty until enough characters
+ * are popped again.
+ *
+ * Parameter: c - the character typed
+ */
+bool CompletionCursor::push( char c ) {
+
+    unsigned int depth = prefix.size();
+    prefix.push_back( c );
+    levels.push_back( Level() );
+    Level & parent = levels[levels.size() - 2];
+    Level & child = levels.back();
+
+    child.node = parent.node == nullptr ? nullptr :
+                                          parent.node->children.find( c );
+    if( child.node == nullptr ) {
+        return false;
+    }
+
+    //the parent's final words that go on with c stay final and in order
+    for( const string & word : parent.ranked ) {
+        if( word.size() > depth && word[depth] == c ) {
+            child.ranked.push_back( word );
+        }
+    }
+
+    //so does what is left of its frontier under c. The only entry that
+    //can be as short as the parent's prefix is the parent's own word or
+    //its unexpanded node, which stands for the child's node here
+    for( const CompletionEntry & entry : parent.frontier ) {
+
+        if( entry.word.size() > depth ) {
+            if( entry.word[depth] == c ) {
+                child.frontier.push_back( entry );
+            }
+        } else if( entry.node != nullptr ) {
+            child.frontier.push_back(
+                CompletionEntry{ child.node->maxFreq, prefix, child.node } );
+        }
+
+    }
+    std::make_heap( child.frontier.begin(), child.frontier.end(),
+                    DictionaryTrie::CompareEntry() );
+    return true;
+
+}
+
+/* Removes the last character typed, like a backspace. Returns false
+ * if the prefix was already empty.
+ */
+bool CompletionCursor::pop() {
+
+    if( prefix.empty() ) {
+        return false;
+    }
+    prefix.pop_back();
+    levels.pop_back();
+    return true;
+
+}
+
+/* Returns the same list as predictCompletions() on the current prefix
+ *
+ * Parameter: k - the max length of the list of predictions
+ */
+vector<string> CompletionCursor::topK( unsigned int k ) {
+
+    Level & level = levels.back();
+    if( level.node == nullptr || k == 0 ) {
+        return vector<string>();
+    }
+
+    //the trie's own cache already has the answer
+    if( k <= trie.topKSize ) {
+
+        vector<string> completionList;
+        const vector<MWTNode*> & cached =
+            trie.topKLists[level.node->topKSlot];
+        for( unsigned int i = 0; i < k && i < cached.size(); i++ ) {
+            completionList.push_back( trie.wordTable[cached[i]->wordId] );
+        }
+        return completionList;
+
+    }
+
+    rank( level, k );
+    unsigned int count = std::min( (size_t) k, level.ranked.size() );
+    return vector<string>( level.ranked.begin(),
+                           level.ranked.begin() + count );
+
+}
+
+/* Returns the prefix typed so far */
+const string & CompletionCursor::text() const {
+
+    return prefix;
+
+}
+
+/* Runs the best-first search of level until it has ranked k words or
+ * run out of words.
+ *
+ * Parameter: level - the level to rank words for
+ * Parameter: k - the number of words wanted
+ */
+void CompletionCursor::rank( Level & level, unsigned int k ) {
+
+    DictionaryTrie::CompareEntry compare;
+    vector<CompletionEntry> & frontier = level.frontier;
+
+    //the same search as predictCompletions(), on a heap that is kept
+    while( level.ranked.size() < k && !frontier.empty() ) {
+
+        std::pop_heap( frontier.begin(), frontier.end(), compare );
+        CompletionEntry entry = std::move( frontier.back() );
+        frontier.pop_back();
+
+        if( entry.node == nullptr ) {
+            level.ranked.push_back( std::move( entry.word ) );
+            continue;
+        }
+
+        if( entry.node->isEnd ) {
+            frontier.push_back(
+                CompletionEntry{ entry.node->freq, entry.word, nullptr } );
+            std::push_heap( frontier.begin(), frontier.end(), compare );
+        }
+
+        auto iterator = entry.node->children.begin();
+        while( iterator != entry.node->children.end() ) {
+            string word = entry.word + iterator->first;
+            MWTNode* child = DictionaryTrie::skipChain( iterator->second,
+                                                        word );
+            frontier.push_back( CompletionEntry{ child->maxFreq,
+                                                 std::move( word ), child } );
+            std::push_heap( frontier.begin(), frontier.end(), compare );
+            iterator++;
+        }
+
+    }
+
+}
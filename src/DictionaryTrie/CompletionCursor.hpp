@@ -0,0 +1,86 @@
+/**
+ * The purpose of this hpp file is to define the CompletionCursor class, a
+ * typing session over a DictionaryTrie. The cursor follows the prefix one
+ * character at a time and keeps, for every prefix typed so far, the words
+ * it has already ranked and the best-first frontier that is still left.
+ * A longer prefix starts from the part of its parent's work that lies
+ * under it, rather than from the prefix node, and a backspace goes back to
+ * the work already done for the shorter prefix.
+ *
+ * The cursor reads the trie it was made from, so the trie has to outlive
+ * it and must not be changed while the cursor is in use.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources:
+ */
+#ifndef COMPLETION_CURSOR_HPP
+#define COMPLETION_CURSOR_HPP
+
+#include <string>
+#include <vector>
+#include "DictionaryTrie.hpp"
+
+using namespace std;
+
+class CompletionCursor {
+  private:
+    typedef DictionaryTrie::MWTNode MWTNode;
+    typedef DictionaryTrie::CompletionEntry CompletionEntry;
+
+    /** The search state of one typed prefix */
+    struct Level {
+        //the prefix's node, nullptr if no word starts with the prefix
+        MWTNode* node;
+        //the prefix's first words in output order, these are final
+        vector<string> ranked;
+        //a heap of the words and subtrees that are left to rank
+        vector<CompletionEntry> frontier;
+    };
+
+    //the trie being typed into
+    const DictionaryTrie & trie;
+    //the characters typed so far
+    string prefix;
+    //the state of every prefix of the typed text, the empty one first
+    vector<Level> levels;
+
+    /* Runs the best-first search of level until it has ranked k words or
+     * run out of words.
+     *
+     * Parameter: level - the level to rank words for
+     * Parameter: k - the number of words wanted
+     */
+    void rank( Level & level, unsigned int k );
+
+  public:
+    /* Starts a cursor on the empty prefix of trie
+     *
+     * Parameter: trie - the dictionary to complete from
+     */
+    CompletionCursor( const DictionaryTrie & trie );
+
+    /* Types one more character. Returns false if no word starts with the
+     * new prefix, in which case topK() is empty until enough characters
+     * are popped again.
+     *
+     * Parameter: c - the character typed
+     */
+    bool push( char c );
+
+    /* Removes the last character typed, like a backspace. Returns false
+     * if the prefix was already empty.
+     */
+    bool pop();
+
+    /* Returns the same list as predictCompletions() on the current prefix
+     *
+     * Parameter: k - the max length of the list of predictions
+     */
+    vector<string> topK( unsigned int k );
+
+    /* Returns the prefix typed so far */
+    const string & text() const;
+};
+
+#endif  // COMPLETION_CURSOR_HPP
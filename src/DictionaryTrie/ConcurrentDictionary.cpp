@@ -0,0 +1,188 @@
+/**
+ * The purpose of this cpp file is to provide implementation for the
+ * methods of the ConcurrentDictionary class and its Reader. All atomics
+ * use the default sequentially consistent ordering, which is what makes
+ * the epoch argument in reclaimLocked() hold.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: std::atomic doc, Fraser "Practical lock-freedom" (epochs)
+ */
+#include "ConcurrentDictionary.hpp"
+#include <thread>
+
+/* Creates the wrapper serving initial, which it takes ownership of.
+ *
+ * Parameter: initial - the first trie to serve, allocated with new
+ */
+ConcurrentDictionary::ConcurrentDictionary( DictionaryTrie* initial ) {
+
+    current.store( initial );
+    globalEpoch.store( 1 );
+    for( unsigned int i = 0; i < MAX_READERS; i++ ) {
+        slots[i].epoch.store( 0 );
+        slots[i].taken.store( false );
+    }
+    publishCount = 0;
+
+}
+
+/* Makes next the trie every new query is served from and retires the
+ * old one. next must not be changed after it is published. Takes
+ * ownership of next.
+ *
+ * Parameter: next - the new trie, allocated with new
+ */
+void ConcurrentDictionary::publish( DictionaryTrie* next ) {
+
+    lock_guard<mutex> guard( writerLock );
+
+    //a reader that sees the new epoch loads current after this exchange,
+    //so only readers from older epochs can still hold the old trie
+    const DictionaryTrie* old = current.exchange( next );
+    uint64_t epoch = globalEpoch.fetch_add( 1 ) + 1;
+    retired.push_back( Retired{ old, epoch } );
+    publishCount++;
+
+    reclaimLocked();
+
+}
+
+/* Deletes every retired trie no reader can still be using. publish()
+ * already does this; call it to free memory sooner after readers
+ * finish.
+ */
+void ConcurrentDictionary::reclaim() {
+
+    lock_guard<mutex> guard( writerLock );
+    reclaimLocked();
+
+}
+
+/* Deletes every retired trie no reader can still be using. The caller
+ * holds writerLock.
+ */
+void ConcurrentDictionary::reclaimLocked() {
+
+    //the oldest epoch any reader is in right now
+    uint64_t oldest = UINT64_MAX;
+    for( unsigned int i = 0; i < MAX_READERS; i++ ) {
+        uint64_t epoch = slots[i].epoch.load();
+        if( epoch != 0 && epoch < oldest ) {
+            oldest = epoch;
+        }
+    }
+
+    unsigned int kept = 0;
+    for( unsigned int i = 0; i < retired.size(); i++ ) {
+        if( retired[i].epoch <= oldest ) {
+            delete retired[i].trie;
+        } else {
+            retired[kept] = retired[i];
+            kept++;
+        }
+    }
+    retired.resize( kept );
+
+}
+
+/* Returns the number of retired tries still waiting for readers */
+unsigned int ConcurrentDictionary::pendingReclaim() {
+
+    lock_guard<mutex> guard( writerLock );
+    return retired.size();
+
+}
+
+/* Returns the number of tries published so far */
+uint64_t ConcurrentDictionary::publishes() {
+
+    lock_guard<mutex> guard( writerLock );
+    return publishCount;
+
+}
+
+/* Deletes the current trie and every retired one. No Reader may be
+ * alive at this point.
+ */
+ConcurrentDictionary::~ConcurrentDictionary() {
+
+    for( unsigned int i = 0; i < retired.size(); i++ ) {
+        delete retired[i].trie;
+    }
+    delete current.load();
+
+}
+
+/* Registers with owner, waiting if every slot is taken */
+ConcurrentDictionary::Reader::Reader( ConcurrentDictionary & owner )
+    : owner(&owner), slot(nullptr) {
+
+    while( slot == nullptr ) {
+        for( unsigned int i = 0; i < MAX_READERS && slot == nullptr; i++ ) {
+            bool expected = false;
+            if( owner.slots[i].taken.compare_exchange_strong( expected,
+                                                              true ) ) {
+                slot = &owner.slots[i];
+            }
+        }
+        if( slot == nullptr ) {
+            std::this_thread::yield();
+        }
+    }
+
+}
+
+/* Announces the current epoch and returns the trie to query */
+const DictionaryTrie* ConcurrentDictionary::Reader::enter() const {
+
+    slot->epoch.store( owner->globalEpoch.load() );
+    return owner->current.load();
+
+}
+
+/* Leaves the epoch, the trie may be reclaimed after this */
+void ConcurrentDictionary::Reader::exit() const {
+
+    slot->epoch.store( 0 );
+
+}
+
+/* Same as DictionaryTrie::find() on the current trie */
+bool ConcurrentDictionary::Reader::find( const string & word ) const {
+
+    bool found = enter()->find( word );
+    exit();
+    return found;
+
+}
+
+/* Same as DictionaryTrie::predictCompletions() on the current trie */
+vector<string> ConcurrentDictionary::Reader::predictCompletions(
+    const string & prefix, unsigned int numCompletions ) const {
+
+    vector<string> completions =
+        enter()->predictCompletions( prefix, numCompletions );
+    exit();
+    return completions;
+
+}
+
+/* Same as DictionaryTrie::predictUnderscores() on the current trie */
+vector<string> ConcurrentDictionary::Reader::predictUnderscores(
+    const string & pattern, unsigned int numCompletions ) const {
+
+    vector<string> matches =
+        enter()->predictUnderscores( pattern, numCompletions );
+    exit();
+    return matches;
+
+}
+
+/* Gives the slot back */
+ConcurrentDictionary::Reader::~Reader() {
+
+    slot->epoch.store( 0 );
+    slot->taken.store( false );
+
+}
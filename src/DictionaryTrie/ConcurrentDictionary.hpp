@@ -0,0 +1,141 @@
+/**
+ * The purpose of this hpp file is to define the ConcurrentDictionary
+ * class, a read-mostly wrapper that lets many threads query a
+ * DictionaryTrie while a writer replaces it. Readers never take a lock:
+ * they announce the current epoch in a slot of their own, load the
+ * pointer to the current (immutable) trie and query it. A writer builds
+ * a whole new trie on the side and publishes it with one atomic
+ * exchange. The old trie is retired and only deleted once every reader
+ * that could still be using it has left its epoch (epoch-based
+ * reclamation), so publishing never makes a reader wait.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: std::atomic doc, Fraser "Practical lock-freedom" (epochs)
+ */
+#ifndef CONCURRENT_DICTIONARY_HPP
+#define CONCURRENT_DICTIONARY_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "DictionaryTrie.hpp"
+
+using namespace std;
+
+class ConcurrentDictionary {
+  private:
+    //the most readers that can be registered at the same time
+    static const unsigned int MAX_READERS = 256;
+
+    /** A reader's announcement, padded to its own cache line so readers
+     *  do not slow each other down
+     */
+    struct alignas(64) ReaderSlot {
+        //epoch the reader entered with, 0 while it is not reading
+        atomic<uint64_t> epoch;
+        //does a Reader own this slot
+        atomic<bool> taken;
+    };
+
+    /** A replaced trie waiting for its readers to leave */
+    struct Retired {
+        const DictionaryTrie* trie;
+        //readers that entered at this epoch or later cannot see trie
+        uint64_t epoch;
+    };
+
+    //the trie readers are served from
+    atomic<const DictionaryTrie*> current;
+    //bumped on every publish, starts at 1 so 0 can mean "not reading"
+    atomic<uint64_t> globalEpoch;
+    ReaderSlot slots[MAX_READERS];
+
+    //serializes writers, readers never touch it
+    mutex writerLock;
+    vector<Retired> retired;
+    //number of tries published so far
+    uint64_t publishCount;
+
+    /* Deletes every retired trie no reader can still be using. The caller
+     * holds writerLock.
+     */
+    void reclaimLocked();
+
+  public:
+    /** A registered reader. Each thread that queries should use its own
+     *  Reader; the queries on it are lock-free and wait-free with respect
+     *  to writers.
+     */
+    class Reader {
+      private:
+        ConcurrentDictionary* owner;
+        ReaderSlot* slot;
+
+        /* Announces the current epoch and returns the trie to query */
+        const DictionaryTrie* enter() const;
+
+        /* Leaves the epoch, the trie may be reclaimed after this */
+        void exit() const;
+
+      public:
+        /* Registers with owner, waiting if every slot is taken */
+        explicit Reader( ConcurrentDictionary & owner );
+
+        Reader( const Reader & other ) = delete;
+        Reader & operator=( const Reader & other ) = delete;
+
+        /* Same as DictionaryTrie::find() on the current trie */
+        bool find( const string & word ) const;
+
+        /* Same as DictionaryTrie::predictCompletions() on the current trie */
+        vector<string> predictCompletions( const string & prefix,
+                                           unsigned int numCompletions ) const;
+
+        /* Same as DictionaryTrie::predictUnderscores() on the current trie */
+        vector<string> predictUnderscores( const string & pattern,
+                                           unsigned int numCompletions ) const;
+
+        /* Gives the slot back */
+        ~Reader();
+    };
+
+    /* Creates the wrapper serving initial, which it takes ownership of.
+     *
+     * Parameter: initial - the first trie to serve, allocated with new
+     */
+    explicit ConcurrentDictionary( DictionaryTrie* initial );
+
+    ConcurrentDictionary( const ConcurrentDictionary & other ) = delete;
+    ConcurrentDictionary & operator=( const ConcurrentDictionary & other ) =
+        delete;
+
+    /* Makes next the trie every new query is served from and retires the
+     * old one. next must not be changed after it is published. Takes
+     * ownership of next.
+     *
+     * Parameter: next - the new trie, allocated with new
+     */
+    void publish( DictionaryTrie* next );
+
+    /* Deletes every retired trie no reader can still be using. publish()
+     * already does this; call it to free memory sooner after readers
+     * finish.
+     */
+    void reclaim();
+
+    /* Returns the number of retired tries still waiting for readers */
+    unsigned int pendingReclaim();
+
+    /* Returns the number of tries published so far */
+    uint64_t publishes();
+
+    /* Deletes the current trie and every retired one. No Reader may be
+     * alive at this point.
+     */
+    ~ConcurrentDictionary();
+};
+
+#endif  // CONCURRENT_DICTIONARY_HPP
@@ -0,0 +1,98 @@
+/**
+ * The purpose of this cpp file is to provide implementation for the
+ * backend factory of the Dictionary interface.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: getenv(3) man page
+ */
+#include "Dictionary.hpp"
+#include <cstdlib>
+#include "DictionaryTrie.hpp"
+#include "RadixTrie.hpp"
+#include "TernarySearchTree.hpp"
+
+/* Creates an empty dictionary on the given backend
+ *
+ * Parameter: backend - the data structure to build on
+ */
+unique_ptr<Dictionary> Dictionary::create( DictionaryBackend backend ) {
+
+    if( backend == DictionaryBackend::TST ) {
+        return unique_ptr<Dictionary>( new TernarySearchTree() );
+    }
+    if( backend == DictionaryBackend::RADIX ) {
+        return unique_ptr<Dictionary>( new RadixTrie() );
+    }
+    return unique_ptr<Dictionary>( new DictionaryTrie() );
+
+}
+
+/* Returns the counters of the last query made on the calling thread, on
+ * any backend. They are all zero unless the library was built with
+ * DICTIONARY_TRIE_STATS, see QueryStats::ENABLED.
+ */
+const QueryStats & Dictionary::lastQueryStats() {
+
+#ifdef DICTIONARY_TRIE_STATS
+    return currentQueryStats;
+#else
+    static const QueryStats none;
+    return none;
+#endif
+
+}
+
+/* Sets backend to the one named ("mwt", "tst" or "radix") and returns
+ * true, or returns false if name is not a backend.
+ *
+ * Parameter: name - the name of the backend
+ * Parameter: backend - set to the named backend
+ */
+bool Dictionary::parseBackend( const string & name,
+                               DictionaryBackend & backend ) {
+
+    if( name == "mwt" ) {
+        backend = DictionaryBackend::MWT;
+        return true;
+    }
+    if( name == "tst" ) {
+        backend = DictionaryBackend::TST;
+        return true;
+    }
+    if( name == "radix" ) {
+        backend = DictionaryBackend::RADIX;
+        return true;
+    }
+    return false;
+
+}
+
+/* Returns the name of backend, as parseBackend() reads it
+ *
+ * Parameter: backend - the backend to name
+ */
+const char* Dictionary::backendName( DictionaryBackend backend ) {
+
+    if( backend == DictionaryBackend::TST ) {
+        return "tst";
+    }
+    return backend == DictionaryBackend::RADIX ? "radix" : "mwt";
+
+}
+
+/* Returns the backend named by the DICTIONARY_BACKEND environment
+ * variable (mwt, tst or radix), so a program can be run on any backend
+ * without being changed. The multiway trie if it is not set or not a
+ * backend.
+ */
+DictionaryBackend Dictionary::defaultBackend() {
+
+    DictionaryBackend backend = DictionaryBackend::MWT;
+    const char* name = getenv( "DICTIONARY_BACKEND" );
+    if( name != nullptr ) {
+        parseBackend( name, backend );
+    }
+    return backend;
+
+}
@@ -0,0 +1,113 @@
+/**
+ * The purpose of this hpp file is to define the Dictionary interface, the
+ * operations every dictionary backend answers the same way: insert, find,
+ * predictCompletions and predictUnderscores. DictionaryTrie (a multiway
+ * trie), TernarySearchTree and RadixTrie implement it, and
+ * Dictionary::create() builds any of them, so a program can pick its
+ * backend at run time. The backend specific extras (caches, snapshots,
+ * batches, cursors) stay on DictionaryTrie.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: getenv(3) man page
+ */
+#ifndef DICTIONARY_HPP
+#define DICTIONARY_HPP
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "QueryStats.hpp"
+
+using namespace std;
+
+/** The data structures a Dictionary can be built on */
+enum class DictionaryBackend {
+    //DictionaryTrie, a multiway trie
+    MWT,
+    //TernarySearchTree
+    TST,
+    //RadixTrie, a path compressed trie
+    RADIX
+};
+
+class Dictionary {
+  public:
+    virtual ~Dictionary() {}
+
+    /* Inserts word with the given frequency and returns true, or returns
+     * false if the word is empty or already in the dictionary.
+     *
+     * Parameter: word - the word to insert
+     * Parameter: freq - the frequency of the word
+     */
+    virtual bool insert( string_view word, unsigned int freq ) = 0;
+
+    /* Returns true if word is in the dictionary
+     *
+     * Parameter: word - the word to look for
+     */
+    virtual bool find( string word ) const = 0;
+
+    /* Returns up to numCompletions words that start with prefix, from
+     * high to low frequency and lexicographically among equal ones.
+     *
+     * Parameter: prefix - the prefix of the words to return
+     * Parameter: numCompletions - the max length of the list of predictions
+     */
+    virtual vector<string> predictCompletions(
+        string prefix, unsigned int numCompletions ) const = 0;
+
+    /* Returns up to numCompletions words of the same length as pattern
+     * that match it, an underscore matching any one character, ordered
+     * like predictCompletions().
+     *
+     * Parameter: pattern - a word that contains underscores as wildcard chars
+     * Parameter: numCompletions - the max length of the list of predictions
+     */
+    virtual vector<string> predictUnderscores(
+        string pattern, unsigned int numCompletions ) const = 0;
+
+    /* Returns the number of bytes used by the nodes of the dictionary */
+    virtual size_t memoryBytes() const = 0;
+
+    /* Returns the number of nodes in the dictionary */
+    virtual size_t nodeCount() const = 0;
+
+    /* Returns the counters of the last query made on the calling thread,
+     * on any backend. They are all zero unless the library was built with
+     * DICTIONARY_TRIE_STATS, see QueryStats::ENABLED.
+     */
+    static const QueryStats & lastQueryStats();
+
+    /* Creates an empty dictionary on the given backend
+     *
+     * Parameter: backend - the data structure to build on
+     */
+    static unique_ptr<Dictionary> create( DictionaryBackend backend );
+
+    /* Sets backend to the one named ("mwt", "tst" or "radix") and returns
+     * true, or returns false if name is not a backend.
+     *
+     * Parameter: name - the name of the backend
+     * Parameter: backend - set to the named backend
+     */
+    static bool parseBackend( const string & name,
+                              DictionaryBackend & backend );
+
+    /* Returns the name of backend, as parseBackend() reads it
+     *
+     * Parameter: backend - the backend to name
+     */
+    static const char* backendName( DictionaryBackend backend );
+
+    /* Returns the backend named by the DICTIONARY_BACKEND environment
+     * variable (mwt, tst or radix), so a program can be run on any
+     * backend without being changed. The multiway trie if it is not set
+     * or not a backend.
+     */
+    static DictionaryBackend defaultBackend();
+};
+
+#endif  // DICTIONARY_HPP
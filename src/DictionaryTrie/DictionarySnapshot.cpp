@@ -0,0 +1,393 @@
+/**
+ * The purpose of this cpp file is to provide implementation for the
+ * methods of the DictionarySnapshot class, the read-only query engine
+ * that works directly on an mmapped snapshot file. The queries follow the
+ * same rules as the ones in DictionaryTrie so both give the same answers.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: mmap(2) man page, std::priority_queue doc
+ */
+#include "DictionarySnapshot.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <queue>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+/** An entry in the best-first completion queue, see DictionaryTrie */
+struct SnapshotEntry {
+    //the word's frequency or the subtree's max frequency
+    unsigned int freq;
+    //the word, or the path leading to the subtree
+    string word;
+    //the subtree to expand
+    uint32_t node;
+    //is this a finished word rather than a subtree
+    bool isWord;
+};
+
+/** Pops the highest frequency first, then the smallest word, then a
+ *  finished word before the subtree with the same path.
+ */
+struct CompareSnapshotEntry {
+    bool operator()( const SnapshotEntry & e1,
+                     const SnapshotEntry & e2 ) const {
+        if( e1.freq != e2.freq ) {
+            return e1.freq < e2.freq;
+        }
+        int cmp = e1.word.compare(e2.word);
+        if( cmp != 0 ) {
+            return cmp > 0;
+        }
+        return !e1.isWord && e2.isWord;
+    }
+};
+
+/* Returns true if p1 should come before p2 in the results: higher
+ * frequency first, then lexicographically.
+ */
+bool compareFreq( const pair<string, unsigned int> & p1,
+                  const pair<string, unsigned int> & p2 ) {
+    if( p1.second == p2.second ) {
+        return p1.first.compare(p2.first) < 0;
+    }
+    return p2.second < p1.second;
+}
+
+}  // namespace
+
+/* Creates a snapshot with nothing open */
+DictionarySnapshot::DictionarySnapshot() {
+
+    image = nullptr;
+    imageSize = 0;
+    header = nullptr;
+    nodes = nullptr;
+    keys = nullptr;
+
+}
+
+/* Maps the snapshot file and checks its header and the child range of
+ * every node. Returns false if the file cannot be mapped or is not a
+ * snapshot this build can read.
+ *
+ * Parameter: fileName - the file written by writeSnapshot()
+ */
+bool DictionarySnapshot::open( const string & fileName ) {
+
+    close();
+
+    int fd = ::open( fileName.c_str(), O_RDONLY );
+    if( fd < 0 ) {
+        return false;
+    }
+    struct stat info;
+    if( fstat( fd, &info ) != 0 ||
+        (size_t) info.st_size < sizeof(SnapshotHeader) ) {
+        ::close( fd );
+        return false;
+    }
+
+    //the mapping stays valid after the descriptor is closed
+    void* mapped = mmap( nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+    ::close( fd );
+    if( mapped == MAP_FAILED ) {
+        return false;
+    }
+    image = (const char*) mapped;
+    imageSize = info.st_size;
+    header = (const SnapshotHeader*) image;
+
+    //make sure the image is one we wrote and all of it is in the file,
+    //without adding to an offset that could wrap around
+    if( memcmp( header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC) ) != 0 ||
+        header->version != SNAPSHOT_VERSION ||
+        header->byteOrder != SNAPSHOT_BYTE_ORDER ||
+        header->nodeCount == 0 ||
+        header->nodesOffset % sizeof(uint64_t) != 0 ||
+        header->nodesOffset > imageSize ||
+        header->nodeCount > ( imageSize - header->nodesOffset ) /
+                            sizeof(SnapshotNode) ||
+        header->keysOffset > imageSize ||
+        header->nodeCount > imageSize - header->keysOffset ) {
+        close();
+        return false;
+    }
+    nodes = (const SnapshotNode*) ( image + header->nodesOffset );
+    keys = (const uint8_t*) ( image + header->keysOffset );
+
+    //the queries index nodes and keys straight from the file, so every
+    //child range has to be in the arrays. Children always come after
+    //their parent, which also rules out cycles.
+    uint64_t nodeCount = header->nodeCount;
+    for( uint64_t i = 0; i < nodeCount; i++ ) {
+        if( nodes[i].childCount != 0 &&
+            ( nodes[i].firstChild <= i ||
+              nodes[i].firstChild + (uint64_t) nodes[i].childCount >
+                  nodeCount ) ) {
+            close();
+            return false;
+        }
+    }
+    return true;
+
+}
+
+/* Unmaps the file, if one is open */
+void DictionarySnapshot::close() {
+
+    if( image != nullptr ) {
+        munmap( (void*) image, imageSize );
+    }
+    image = nullptr;
+    imageSize = 0;
+    header = nullptr;
+    nodes = nullptr;
+    keys = nullptr;
+
+}
+
+/* Returns true if fileName starts with the snapshot magic
+ *
+ * Parameter: fileName - the file to check
+ */
+bool DictionarySnapshot::isSnapshot( const string & fileName ) {
+
+    ifstream in;
+    in.open( fileName, ios::binary );
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    if( !in.read( magic, sizeof(magic) ) ) {
+        return false;
+    }
+    return memcmp( magic, SNAPSHOT_MAGIC, sizeof(magic) ) == 0;
+
+}
+
+/* Returns the number of words in the open snapshot */
+unsigned int DictionarySnapshot::size() const {
+
+    return header == nullptr ? 0 : header->wordCount;
+
+}
+
+/* Returns the index of the child of node under key, or 0 if there is
+ * none (the root is never anybody's child).
+ *
+ * Parameter: node - the index of the parent node
+ * Parameter: key - the character of the edge to the child
+ */
+uint32_t DictionarySnapshot::child( uint32_t node, char key ) const {
+
+    //children are sorted by key, so binary search their key bytes
+    const uint8_t* first = keys + nodes[node].firstChild;
+    const uint8_t* last = first + nodes[node].childCount;
+    const uint8_t* found = std::lower_bound( first, last, (uint8_t) key );
+    if( found == last || *found != (uint8_t) key ) {
+        return 0;
+    }
+    return nodes[node].firstChild + ( found - first );
+
+}
+
+/* Returns the index of the node that prefix leads to, 0 with found set
+ * to false if the prefix is not in the snapshot.
+ *
+ * Parameter: prefix - the characters to walk down
+ * Parameter: found - set to whether the walk succeeded
+ */
+uint32_t DictionarySnapshot::walk( const string & prefix,
+                                   bool & found ) const {
+
+    found = false;
+    if( header == nullptr ) {
+        return 0;
+    }
+    uint32_t node = 0;
+    for( unsigned int i = 0; i < prefix.size(); i++ ) {
+        node = child( node, prefix[i] );
+        if( node == 0 ) {
+            return 0;
+        }
+    }
+    found = true;
+    return node;
+
+}
+
+/* Same as DictionaryTrie::find() */
+bool DictionarySnapshot::find( const string & word ) const {
+
+    bool found;
+    uint32_t node = walk( word, found );
+    return found && word.size() > 0 && nodes[node].isEnd;
+
+}
+
+/* Same as DictionaryTrie::predictCompletions() */
+vector<string> DictionarySnapshot::predictCompletions(
+    const string & prefix, unsigned int numCompletions ) const {
+
+    vector<string> completionList = vector<string>();
+    bool found;
+    uint32_t start = walk( prefix, found );
+    if( !found || numCompletions == 0 ) {
+        return completionList;
+    }
+
+    priority_queue<SnapshotEntry, vector<SnapshotEntry>, CompareSnapshotEntry>
+        frontier;
+    frontier.push( SnapshotEntry{ nodes[start].maxFreq, prefix, start,
+                                  false } );
+
+    while( completionList.size() < numCompletions && !frontier.empty() ) {
+
+        SnapshotEntry entry = frontier.top();
+        frontier.pop();
+
+        if( entry.isWord ) {
+            completionList.push_back( entry.word );
+            continue;
+        }
+
+        const SnapshotNode & node = nodes[entry.node];
+        if( node.isEnd ) {
+            frontier.push( SnapshotEntry{ node.freq, entry.word, entry.node,
+                                          true } );
+        }
+        for( uint32_t c = node.firstChild;
+             c < node.firstChild + node.childCount; c++ ) {
+
+            //jump down a chain of single children with no word, which
+            //holds the same words, instead of copying the path each step
+            string word = entry.word + (char) keys[c];
+            uint32_t next = c;
+            while( !nodes[next].isEnd && nodes[next].childCount == 1 ) {
+                next = nodes[next].firstChild;
+                word.push_back( (char) keys[next] );
+            }
+            frontier.push( SnapshotEntry{ nodes[next].maxFreq,
+                                          std::move( word ), next, false } );
+
+        }
+
+    }
+
+    return completionList;
+
+}
+
+/* Same as DictionaryTrie::predictUnderscores() */
+vector<string> DictionarySnapshot::predictUnderscores(
+    const string & pattern, unsigned int numCompletions ) const {
+
+    vector<string> wildCardList = vector<string>();
+    if( header == nullptr || numCompletions == 0 ) {
+        return wildCardList;
+    }
+
+    //the best numCompletions matches, worst on top
+    MatchHeap matches( compareFreq );
+    getPatterns( matches, numCompletions, pattern );
+
+    //the heap pops the worst match first, so fill the list from the back
+    wildCardList.resize( matches.size() );
+    for( unsigned int i = matches.size(); i > 0; i-- ) {
+        wildCardList[i-1] = matches.top().first;
+        matches.pop();
+    }
+    return wildCardList;
+
+}
+
+/* Helper method for predictUnderscores() which walks down the
+ * snapshot with an explicit stack, following the pattern's character
+ * at each position or every child if it is an underscore, and keeps the
+ * best numCompletions matches. Subtrees whose maxFreq cannot beat the
+ * worst of them are skipped.
+ *
+ * Parameter: matches - the best matches found so far
+ * Parameter: numCompletions - the most matches to keep
+ * Parameter: pattern - the pattern with underscores
+ */
+void DictionarySnapshot::getPatterns( MatchHeap & matches,
+                                      unsigned int numCompletions,
+                                      const string & pattern ) const {
+
+    //the pattern with its underscores filled in down to the current node
+    string filled = pattern;
+    vector<PatternFrame> stack;
+    uint32_t node = 0;
+    unsigned int pos = 0;
+    bool alive = true;
+
+    while( true ) {
+
+        //follow the pattern's characters until an underscore or a dead end
+        while( alive ) {
+
+            //skip the subtree if even its best word would not make the cut
+            if( matches.size() == numCompletions &&
+                nodes[node].maxFreq < matches.top().second ) {
+                break;
+            }
+
+            if( pos == pattern.size() ) {
+                if( nodes[node].isEnd ) {
+                    pair<string, unsigned int> match( filled,
+                                                      nodes[node].freq );
+                    if( matches.size() < numCompletions ) {
+                        matches.push( match );
+                    } else if( compareFreq( match, matches.top() ) ) {
+                        matches.pop();
+                        matches.push( match );
+                    }
+                }
+                break;
+            }
+
+            if( pattern[pos] == '_' ) {
+                stack.push_back( PatternFrame{ pos, nodes[node].firstChild,
+                                               nodes[node].firstChild +
+                                               nodes[node].childCount } );
+                break;
+            }
+
+            node = child( node, pattern[pos] );
+            alive = node != 0;
+            pos++;
+
+        }
+
+        if( stack.empty() ) {
+            break;
+        }
+
+        //fill in the next child's key for the deepest underscore
+        PatternFrame & top = stack.back();
+        if( top.next == top.end ) {
+            stack.pop_back();
+            alive = false;
+            continue;
+        }
+        node = top.next;
+        filled[top.pos] = (char) keys[node];
+        pos = top.pos + 1;
+        alive = true;
+        top.next++;
+
+    }
+
+}
+
+/* Unmaps the file */
+DictionarySnapshot::~DictionarySnapshot() {
+
+    close();
+
+}
@@ -0,0 +1,172 @@
+/**
+ * The purpose of this hpp file is to define the DictionarySnapshot class,
+ * a read-only query engine over the binary image that
+ * DictionaryTrie::writeSnapshot() produces. The image uses node indices
+ * instead of pointers, so it is position independent: the snapshot just
+ * mmaps the file and answers find(), predictCompletions() and
+ * predictUnderscores() straight from the mapped pages, without building
+ * a single node. Processes that open the same file share its pages in
+ * the page cache.
+ *
+ * File layout (native byte order):
+ *   SnapshotHeader
+ *   SnapshotNode[nodeCount]  in breadth-first order, so the children of a
+ *                            node are the consecutive indices
+ *                            firstChild .. firstChild + childCount - 1,
+ *                            sorted by key
+ *   uint8_t keys[nodeCount]  the character on the edge into each node
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: mmap(2) man page, std::priority_queue doc
+ */
+#ifndef DICTIONARY_SNAPSHOT_HPP
+#define DICTIONARY_SNAPSHOT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/** The fixed-size header at the start of a snapshot file */
+struct SnapshotHeader {
+    //always SNAPSHOT_MAGIC
+    char magic[8];
+    //always SNAPSHOT_VERSION
+    uint32_t version;
+    //always SNAPSHOT_BYTE_ORDER, written in the writer's byte order
+    uint32_t byteOrder;
+    //number of nodes, the root is node 0
+    uint32_t nodeCount;
+    //number of words stored
+    uint32_t wordCount;
+    //offsets of the node array and the key array from the file start
+    uint64_t nodesOffset;
+    uint64_t keysOffset;
+};
+
+/** One trie node of a snapshot file */
+struct SnapshotNode {
+    //frequency of the word ending here, if isEnd
+    uint32_t freq;
+    //the highest frequency of any word in this node's subtree
+    uint32_t maxFreq;
+    //index of the first child, children are consecutive
+    uint32_t firstChild;
+    //number of children
+    uint16_t childCount;
+    //is it the last letter of a word
+    uint8_t isEnd;
+    uint8_t unused;
+};
+
+static const char SNAPSHOT_MAGIC[8] = {'D', 'T', 'S', 'N', 'A', 'P', 0, 0};
+static const uint32_t SNAPSHOT_VERSION = 1;
+static const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+class DictionarySnapshot {
+  private:
+    //the mapped file and its size, nullptr when nothing is open
+    const char* image;
+    size_t imageSize;
+    //views into the image
+    const SnapshotHeader* header;
+    const SnapshotNode* nodes;
+    const uint8_t* keys;
+
+    /* Returns the index of the child of node under key, or 0 if there is
+     * none (the root is never anybody's child).
+     *
+     * Parameter: node - the index of the parent node
+     * Parameter: key - the character of the edge to the child
+     */
+    uint32_t child( uint32_t node, char key ) const;
+
+    /* Returns the index of the node that prefix leads to, 0 with found set
+     * to false if the prefix is not in the snapshot.
+     *
+     * Parameter: prefix - the characters to walk down
+     * Parameter: found - set to whether the walk succeeded
+     */
+    uint32_t walk( const string & prefix, bool & found ) const;
+
+    /** An underscore on the explicit stack of getPatterns() and the
+     *  children still to try for it
+     */
+    struct PatternFrame {
+        //the position of the underscore in the pattern
+        unsigned int pos;
+        //the next child to try and the one after the last
+        uint32_t next;
+        uint32_t end;
+    };
+
+    /** The matches of predictUnderscores(), kept to the best K. The
+     *  worst match is on top so it can be replaced.
+     */
+    typedef priority_queue<pair<string, unsigned int>,
+                           vector<pair<string, unsigned int>>,
+                           bool (*)( const pair<string, unsigned int> &,
+                                     const pair<string, unsigned int> & )>
+        MatchHeap;
+
+    /* Helper method for predictUnderscores() which walks down the
+     * snapshot with an explicit stack, following the pattern's character
+     * at each position or every child if it is an underscore, and keeps
+     * the best numCompletions matches. Subtrees whose maxFreq cannot beat
+     * the worst of them are skipped.
+     *
+     * Parameter: matches - the best matches found so far
+     * Parameter: numCompletions - the most matches to keep
+     * Parameter: pattern - the pattern with underscores
+     */
+    void getPatterns( MatchHeap & matches, unsigned int numCompletions,
+                      const string & pattern ) const;
+
+  public:
+    /* Creates a snapshot with nothing open */
+    DictionarySnapshot();
+
+    DictionarySnapshot( const DictionarySnapshot & other ) = delete;
+    DictionarySnapshot & operator=( const DictionarySnapshot & other ) = delete;
+
+    /* Maps the snapshot file and checks its header and the child range
+     * of every node. Returns false if the file cannot be mapped or is not
+     * a snapshot this build can read.
+     *
+     * Parameter: fileName - the file written by writeSnapshot()
+     */
+    bool open( const string & fileName );
+
+    /* Unmaps the file, if one is open */
+    void close();
+
+    /* Returns true if fileName starts with the snapshot magic
+     *
+     * Parameter: fileName - the file to check
+     */
+    static bool isSnapshot( const string & fileName );
+
+    /* Returns the number of words in the open snapshot */
+    unsigned int size() const;
+
+    /* Same as DictionaryTrie::find() */
+    bool find( const string & word ) const;
+
+    /* Same as DictionaryTrie::predictCompletions() */
+    vector<string> predictCompletions( const string & prefix,
+                                       unsigned int numCompletions ) const;
+
+    /* Same as DictionaryTrie::predictUnderscores() */
+    vector<string> predictUnderscores( const string & pattern,
+                                       unsigned int numCompletions ) const;
+
+    /* Unmaps the file */
+    ~DictionarySnapshot();
+};
+
+#endif  // DICTIONARY_SNAPSHOT_HPP
@@ -8,66 +8,94 @@
  * Author: Christian Kouris 
  * Email: ckouris@ucsd.edu
  * Sources: auto (C++) Microsoft Docs, cplusplus reference unordered_map,
- *          std::vector doc, std::pair doc, std::sort doc, string docs
+ *          std::vector doc, std::pair doc, std::sort doc, string docs,
+ *          std::priority_queue doc
  */
 #include "DictionaryTrie.hpp"
 #include <iostream>
 #include <algorithm>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <unordered_set>
+#include "DictionarySnapshot.hpp"
+#include "Utf8.hpp"
+#include "WildcardPattern.hpp"
+#include "WorkStealingPool.hpp"
 
 /* Default constructor for the DictionaryTrie class which is a MultiWay
  * Trie. The constructor will create a root MWTNode.
  */
 DictionaryTrie::DictionaryTrie() {
 
-    root = new MWTNode();
+    root = newNode();
+    topKSize = 0;
+    bulkActive = false;
+    bulkFellBack = false;
+    utf8 = false;
+    batchThreads = 0;
+    resultCapacity = 0;
+    resultStats = ResultCacheStats{ 0, 0, 0, 0, 0 };
 
 }
 
 /* Insterts a new node into the MWT using the information of "word" and
  * "freq" and returns true if successful. If the string is already in the
- * MWT, the function inserts noting and returns false.
+ * MWT, the function inserts noting and returns false. The word is
+ * taken as a view, so loaders can pass slices of their read buffer.
+ * In UTF-8 mode a word that is not valid UTF-8 is refused too.
  *
  * Parameter: word - the word string we are inserting into the MWT
  * Parameter: freq - the frequency of the word
  */
-bool DictionaryTrie::insert(string word, unsigned int freq) { 
+bool DictionaryTrie::insert(string_view word, unsigned int freq) { 
 
+    if( word.size() < 1 ) {
+        return false;
+    }
+    if( utf8 && !validUtf8( word ) ) {
+        return false;
+    }
     MWTNode* currNode = root;
    
     //loop through all of the letters in word sans the final one
     for( unsigned int i = 0; i < word.size()-1; i++ ) {
 
-        //search for the letter in the current node's hash map
-        //if the letter doesn't exist add it to the hash map
-        if( currNode->hashMap.find(word[i]) == currNode->hashMap.end() ) {
+        //search for the letter in the current node's children
+        //if the letter doesn't exist add it to the children
+        MWTNode* nextNode = currNode->children.find(word[i]);
+        if( nextNode == nullptr ) {
             
-            MWTNode* newNode = new MWTNode();
-            currNode->hashMap.emplace(word[i], newNode);
-            currNode = newNode;
-
-        } else {
-    
-        //if it exists, go to it
-        currNode = currNode->hashMap.find(word[i])->second;
+            nextNode = newNode();
+            currNode->children.insert(word[i], nextNode, arena);
 
         }
+    
+        //go to the (possibly new) node
+        currNode = nextNode;
 
     }
 
     //now do this for the last letter, but if it's already in, return false
     //case 1: final letter node does not exist
-    if( currNode->hashMap.find(word[word.size()-1]) == 
-        currNode->hashMap.end() ) {
+    MWTNode* finalLetter = currNode->children.find(word[word.size()-1]);
+    if( finalLetter == nullptr ) {
         
-        MWTNode* newNode = new MWTNode();
-        newNode->isEnd = true;
-        newNode->freq = freq;
-        currNode->hashMap.emplace(word[word.size()-1], newNode);
+        finalLetter = newNode();
+        finalLetter->isEnd = true;
+        finalLetter->freq = freq;
+        currNode->children.insert(word[word.size()-1], finalLetter, arena);
+        raisePathBounds( word, freq );
+        if( topKSize > 0 ) {
+            repairTopK( word );
+        }
+        invalidateResults( word );
         return true;
 
     } 
 
-    MWTNode* finalLetter = currNode->hashMap.find(word[word.size()-1])->second;
     //case 2: final letter node exists but is not an end node
     if (finalLetter->isEnd == false ) {
         
@@ -75,6 +103,11 @@ bool DictionaryTrie::insert(string word, unsigned int freq) {
         //an example is inserting word an after word animal
         finalLetter->isEnd = true;
         finalLetter->freq = freq;
+        raisePathBounds( word, freq );
+        if( topKSize > 0 ) {
+            repairTopK( word );
+        }
+        invalidateResults( word );
         return true;
 
     }
@@ -84,298 +117,1817 @@ bool DictionaryTrie::insert(string word, unsigned int freq) {
 
 }
 
-/* Searches to see if a word is in the MWT. If the word is in the
- * trie, the function will return true. If the word is not in the trie,
- * it will return false.
+/* Changes the frequency of a word that is already in the MWT and
+ * returns true, or returns false if the word is not in the MWT. Only
+ * the word's path is repaired (maxFreq and the top-K lists), so the
+ * cost depends on the length of the word, not the size of the MWT.
  *
- * Prameter: word - the string we are looking for in the MWT
+ * Parameter: word - the word whose frequency changes
+ * Parameter: freq - the new frequency of the word
  */
-bool DictionaryTrie::find(string word) const { 
+bool DictionaryTrie::updateFrequency(string_view word, unsigned int freq) {
 
     if( word.size() < 1 ) {
         return false;
     }
-    //pretty much do what the insert function does
+
+    //remember the path, the derived data is repaired bottom-up
+    vector<MWTNode*> path = vector<MWTNode*>();
     MWTNode* currNode = root;
-   
-    //recurse down the MWT to see if each letter exists in the MWT
-    for( unsigned int i = 0; i < word.size()-1; i++ ) {
+    path.push_back( currNode );
+    for( unsigned int i = 0; i < word.size(); i++ ) {
 
-        //see if the word is in the hash map, if not return false
-        if( currNode->hashMap.find(word[i]) == currNode->hashMap.end() ) {
-            
+        currNode = currNode->children.find(word[i]);
+        if( currNode == nullptr ) {
             return false;
+        }
+        path.push_back( currNode );
 
-        } else {
-    
-            currNode = currNode->hashMap.find(word[i])->second;
+    }
+    if( !currNode->isEnd ) {
+        return false;
+    }
+    if( currNode->freq == freq ) {
+        return true;
+    }
 
+    currNode->freq = freq;
+    repairMaxFreq( path );
+    if( topKSize > 0 ) {
+        for( unsigned int i = path.size(); i > 0; i-- ) {
+            mergeTopK( path[i-1] );
         }
+    }
+    invalidateResults( word );
+    return true;
 
+}
+
+/* Adds delta to the frequency of a word that is already in the MWT,
+ * stopping at the largest unsigned int instead of wrapping around.
+ * Returns false if the word is not in the MWT.
+ *
+ * Parameter: word - the word whose frequency changes
+ * Parameter: delta - the amount to add to the word's frequency
+ */
+bool DictionaryTrie::incrementFrequency(string_view word,
+                                        unsigned int delta) {
+
+    if( word.size() < 1 ) {
+        return false;
     }
-    
-    //case 1: final letter node does not exist
-    if( currNode->hashMap.find(word[word.size()-1]) == 
-        currNode->hashMap.end() ) {
-        
+    MWTNode* currNode = root;
+    for( unsigned int i = 0; i < word.size() && currNode != nullptr; i++ ) {
+        currNode = currNode->children.find(word[i]);
+    }
+    if( currNode == nullptr || !currNode->isEnd ) {
         return false;
+    }
 
-    } 
+    unsigned int freq = currNode->freq;
+    if( freq > UINT_MAX - delta ) {
+        freq = UINT_MAX;
+    } else {
+        freq += delta;
+    }
+    return updateFrequency( word, freq );
 
-    //case 2: final letter node exists but is not an end node
-    MWTNode* finalLetter = currNode->hashMap.find(word[word.size()-1])->second;
-    if (finalLetter->isEnd == false ) {
-        
+}
+
+/* Searches to see if a word is in the MWT. If the word is in the
+ * trie, the function will return true. If the word is not in the trie,
+ * it will return false.
+ *
+ * Prameter: word - the string we are looking for in the MWT
+ */
+bool DictionaryTrie::find(string word) const { 
+
+    if( word.size() < 1 ) {
         return false;
+    }
+    //pretty much do what the insert function does
+    STATS_RESET();
+    MWTNode* currNode = root;
+   
+    //go down the MWT to see if each letter exists in the MWT
+    for( unsigned int i = 0; i < word.size(); i++ ) {
+
+        //see if the letter is in the children, if not return false
+        currNode = currNode->children.find(word[i]);
+        STATS_ADD( childLookups, 1 );
+        if( currNode == nullptr ) {
+            return false;
+        }
+        STATS_ADD( nodesVisited, 1 );
 
     }
     
-    //case 3: final letter node exists and is already marked as an end node
-    return true; 
+    //the final letter node exists, is it marked as an end node
+    return currNode->isEnd; 
 
 }
 
 /* This function returns a list of predicted completions of the prefix
  * passed into the function up to an amount of numCompletions in order
  * of high to low frequency. If two words have the same frequency, then
- * they are ordered lexicographically.
+ * they are ordered lexicographically. The search is best-first on the
+ * subtree maxFreq values, so it stops once numCompletions words are
+ * final instead of visiting every word below the prefix. If the top-K
+ * cache holds at least numCompletions words, it is copied instead.
+ * With the result cache on, a repeated query is answered from it.
  *
  * Parameter: prefix - a string that we will return all its completions
  * Parameter: numCompletions - the max length of the list of predictions
  */
 vector<string> DictionaryTrie::predictCompletions(
-    string prefix, unsigned int numCompletions) {
-    
+    string prefix, unsigned int numCompletions) const {
+
+    STATS_RESET();
+    if( resultCapacity == 0 ) {
+        return searchCompletions( prefix, numCompletions );
+    }
+
+    {
+        lock_guard<mutex> guard( resultLock );
+        auto found = resultIndex.find( prefix );
+        if( found != resultIndex.end() ) {
+            for( auto entry : found->second ) {
+                if( entry->numCompletions == numCompletions ) {
+                    resultStats.hits++;
+                    STATS_FLAG( resultCacheHit );
+                    resultLru.splice( resultLru.begin(), resultLru, entry );
+                    return entry->completions;
+                }
+            }
+        }
+        resultStats.misses++;
+    }
+
+    //search without the lock so other readers are not held up
+    vector<string> completionList = searchCompletions( prefix,
+                                                       numCompletions );
+
+    lock_guard<mutex> guard( resultLock );
+    vector<list<CachedResult>::iterator> & cached = resultIndex[prefix];
+    for( auto entry : cached ) {
+        //another reader got here first
+        if( entry->numCompletions == numCompletions ) {
+            return completionList;
+        }
+    }
+    resultLru.push_front( CachedResult{ prefix, numCompletions,
+                                        completionList } );
+    cached.push_back( resultLru.begin() );
+
+    //drop the least recently used answer if there are too many
+    if( resultLru.size() > resultCapacity ) {
+
+        auto oldest = std::prev( resultLru.end() );
+        vector<list<CachedResult>::iterator> & siblings =
+            resultIndex[oldest->prefix];
+        siblings.erase( std::find( siblings.begin(), siblings.end(),
+                                   oldest ) );
+        if( siblings.empty() ) {
+            resultIndex.erase( oldest->prefix );
+        }
+        resultLru.pop_back();
+        resultStats.evictions++;
+
+    }
+    return completionList;
+
+}
+
+/* Follows node down while it has no word of its own and only one
+ * child, adding the keys passed to word, and returns where it stops.
+ * Every word below node is below that node too, and no word outside
+ * it can rank between them, so a best-first search may jump straight
+ * there instead of copying the path once per character.
+ *
+ * Parameter: node - the node to start from
+ * Parameter: word - the path to node, extended to the returned node
+ */
+DictionaryTrie::MWTNode* DictionaryTrie::skipChain( MWTNode* node,
+                                                    string & word ) {
+
+    while( !node->isEnd && node->children.size() == 1 ) {
+        word.push_back( node->children.begin()->first );
+        node = node->children.begin()->second;
+    }
+    return node;
+
+}
+
+/* The search behind predictCompletions(), without the result cache.
+ *
+ * Parameter: prefix - the prefix of the words to complete
+ * Parameter: numCompletions - the max length of the list of predictions
+ */
+vector<string> DictionaryTrie::searchCompletions(
+    const string & prefix, unsigned int numCompletions) const {
+
     //first traverse down the Trie so we get to the node for prefix
+    STATS_PHASE( walk );
     MWTNode* currNode = root;
     for( unsigned int i = 0; i < prefix.size(); i++ ) { 
 
-        //check to see if we ended up in a node that doesn't exist
-        if( currNode->hashMap.find(prefix[i]) == currNode->hashMap.end() ) {
+        //go to the node, check to see if it doesn't exist
+        currNode = currNode->children.find(prefix[i]);
+        STATS_ADD( childLookups, 1 );
+        if( currNode == nullptr ) {
             return std::vector<string>();
         }
-        
-        //go to the node
-        currNode = currNode->hashMap.find(prefix[i])->second;
+        STATS_ADD( nodesVisited, 1 );
 
     }
-
-    //now that we're at the prefix, we want to get everything under it.
-    vector<pair<string,unsigned int>*> * stringAndFreq = 
-        new std::vector<std::pair<string, unsigned int>*>();
-
-    
-    //call the helper function
-    listWords( stringAndFreq, currNode, prefix );
-
-    //we now have an array of every word past prefix. We need to sort it
-    std::sort( stringAndFreq->begin(), stringAndFreq->end(), compareFreq );
+    STATS_PHASE_END( walk );
 
     //create a list to hold the predicted completions
     vector<string> completionList = std::vector<string>();
-    unsigned int i = 0; 
-    //loop through numCompletion times or the entire vector of pairs
-    while (  i < numCompletions && i < stringAndFreq->size() ) {
-
-        completionList.push_back( stringAndFreq->at(i)->first );
-        i++;
+    if( numCompletions == 0 ) {
+        return completionList;
+    }
+    STATS_PHASE( collect );
+
+    //if the cache already knows the answer, just copy it out
+    if( numCompletions <= topKSize ) {
+
+        const vector<MWTNode*> & cached = topKLists[currNode->topKSlot];
+        unsigned int i = 0;
+        while( i < numCompletions && i < cached.size() ) {
+            completionList.push_back( wordTable[cached[i]->wordId] );
+            STATS_ADD( bytesAllocated,
+                       stringHeapBytes( completionList.back() ) );
+            i++;
+        }
+        STATS_FLAG( topKCacheHit );
+        STATS_ADD( candidatesCollected, completionList.size() );
+        STATS_ADD( bytesAllocated,
+                   completionList.capacity() * sizeof(string) );
+        return completionList;
 
     }
 
-    //free memory of allocated pairs
-    for( unsigned int i = 0; i < stringAndFreq->size(); i++ ) {
-        delete stringAndFreq->at(i);
+    //best-first search: the queue always pops the entry that could hold
+    //the next word in the output order, so a word that is popped is final
+    priority_queue<CompletionEntry, vector<CompletionEntry>, CompareEntry>
+        frontier;
+    frontier.push( CompletionEntry{ currNode->maxFreq, prefix, currNode } );
+    STATS_ADD( candidatesSorted, 1 );
+    size_t peakFrontier = 1;
+
+    //loop until we have numCompletions words or nothing is left to expand
+    while( completionList.size() < numCompletions && !frontier.empty() ) {
+
+        CompletionEntry entry = frontier.top();
+        frontier.pop();
+
+        //a finished word can go straight into the list
+        if( entry.node == nullptr ) {
+            completionList.push_back( entry.word );
+            STATS_ADD( bytesAllocated,
+                       stringHeapBytes( completionList.back() ) );
+            continue;
+        }
+        STATS_ADD( nodesVisited, 1 );
+
+        //the node's own word competes with its children's subtrees
+        if( entry.node->isEnd ) {
+            frontier.push( 
+                CompletionEntry{ entry.node->freq, entry.word, nullptr } );
+            STATS_ADD( candidatesCollected, 1 );
+            STATS_ADD( candidatesSorted, 1 );
+            STATS_ADD( bytesAllocated, stringHeapBytes( entry.word ) );
+        }
+
+        auto iterator = entry.node->children.begin();
+        while( iterator != entry.node->children.end() ) {
+            string word = entry.word + iterator->first;
+            MWTNode* child = skipChain( iterator->second, word );
+            STATS_ADD( bytesAllocated, stringHeapBytes( word ) );
+            frontier.push( CompletionEntry{ child->maxFreq, std::move( word ),
+                                            child } );
+            STATS_ADD( candidatesSorted, 1 );
+            iterator++;
+        }
+        peakFrontier = std::max( peakFrontier, frontier.size() );
+
     }
-    delete stringAndFreq;
+    STATS_ADD( bytesAllocated, peakFrontier * sizeof(CompletionEntry) +
+                               completionList.capacity() * sizeof(string) );
 
     //return the list of predicted compltions
     return completionList;
 }
 
+/* Same as predictCompletions() but the words go into out, which is
+ * emptied first, and nothing is allocated once out has grown big
+ * enough from earlier queries. The result cache is not used here,
+ * since filling it allocates.
+ *
+ * Parameter: prefix - a string that we will return all its completions
+ * Parameter: numCompletions - the max length of the list of predictions
+ * Parameter: out - the buffer the predictions are written to
+ */
+void DictionaryTrie::predictCompletions( string_view prefix,
+                                         unsigned int numCompletions,
+                                         CompletionBuffer & out ) const {
+
+    STATS_RESET();
+    //the buffer only allocates when it grows, so only its growth counts
+    [[maybe_unused]] size_t bytesBefore = out.bytes();
+    out.clear();
+    STATS_PHASE( walk );
+    MWTNode* currNode = root;
+    for( unsigned int i = 0; i < prefix.size() && currNode != nullptr;
+         i++ ) {
+        currNode = currNode->children.find(prefix[i]);
+        STATS_ADD( childLookups, 1 );
+        STATS_ADD( nodesVisited, currNode != nullptr );
+    }
+    STATS_PHASE_END( walk );
+    if( currNode == nullptr || numCompletions == 0 ) {
+        STATS_ADD( bytesAllocated, out.bytes() > bytesBefore ?
+                                   out.bytes() - bytesBefore : 0 );
+        return;
+    }
+    STATS_PHASE( collect );
+
+    if( numCompletions <= topKSize ) {
+
+        const vector<MWTNode*> & cached = topKLists[currNode->topKSlot];
+        for( unsigned int i = 0; i < numCompletions && i < cached.size();
+             i++ ) {
+            const string & word = wordTable[cached[i]->wordId];
+            out.spans.push_back( make_pair( out.words.size(), word.size() ) );
+            out.words.append( word );
+        }
+        STATS_FLAG( topKCacheHit );
+        STATS_ADD( candidatesCollected, out.spans.size() );
+        STATS_ADD( bytesAllocated, out.bytes() > bytesBefore ?
+                                   out.bytes() - bytesBefore : 0 );
+        return;
+
+    }
+
+    //CompareEntry on slices of the path buffer instead of strings
+    const string & paths = out.paths;
+    auto compare = [&paths]( const CompletionBuffer::PathEntry & e1,
+                             const CompletionBuffer::PathEntry & e2 ) {
+        if( e1.freq != e2.freq ) {
+            return e1.freq < e2.freq;
+        }
+        int cmp = string_view( paths ).substr( e1.offset, e1.length )
+                      .compare( string_view( paths ).substr( e2.offset,
+                                                             e2.length ) );
+        if( cmp != 0 ) {
+            return cmp > 0;
+        }
+        return e1.node != nullptr && e2.node == nullptr;
+    };
+
+    vector<CompletionBuffer::PathEntry> & frontier = out.frontier;
+    out.paths.append( prefix.data(), prefix.size() );
+    frontier.push_back( CompletionBuffer::PathEntry{
+        currNode->maxFreq, 0, prefix.size(), currNode } );
+    STATS_ADD( candidatesSorted, 1 );
+
+    while( out.spans.size() < numCompletions && !frontier.empty() ) {
+
+        std::pop_heap( frontier.begin(), frontier.end(), compare );
+        CompletionBuffer::PathEntry entry = frontier.back();
+        frontier.pop_back();
+
+        if( entry.node == nullptr ) {
+            out.spans.push_back( make_pair( out.words.size(),
+                                            entry.length ) );
+            out.words.append( out.paths, entry.offset, entry.length );
+            continue;
+        }
+        STATS_ADD( nodesVisited, 1 );
+
+        //the word reuses the subtree's path, only the flag differs
+        if( entry.node->isEnd ) {
+            frontier.push_back( CompletionBuffer::PathEntry{
+                entry.node->freq, entry.offset, entry.length, nullptr } );
+            std::push_heap( frontier.begin(), frontier.end(), compare );
+            STATS_ADD( candidatesCollected, 1 );
+            STATS_ADD( candidatesSorted, 1 );
+        }
+
+        auto iterator = entry.node->children.begin();
+        while( iterator != entry.node->children.end() ) {
+            size_t offset = out.paths.size();
+            out.paths.append( out.paths, entry.offset, entry.length );
+            out.paths.push_back( iterator->first );
+
+            //like skipChain(), but on the path buffer
+            MWTNode* child = iterator->second;
+            while( !child->isEnd && child->children.size() == 1 ) {
+                out.paths.push_back( child->children.begin()->first );
+                child = child->children.begin()->second;
+            }
+            frontier.push_back( CompletionBuffer::PathEntry{
+                child->maxFreq, offset,
+                out.paths.size() - offset, child } );
+            std::push_heap( frontier.begin(), frontier.end(), compare );
+            STATS_ADD( candidatesSorted, 1 );
+            iterator++;
+        }
+
+    }
+    STATS_ADD( bytesAllocated, out.bytes() > bytesBefore ?
+                               out.bytes() - bytesBefore : 0 );
+
+}
+
+/* Returns the number of words in the buffer */
+size_t DictionaryTrie::CompletionBuffer::size() const {
+
+    return spans.size();
+
+}
+
+/* Returns the i-th word, valid until the buffer is used again
+ *
+ * Parameter: i - the index of the word, less than size()
+ */
+string_view DictionaryTrie::CompletionBuffer::operator[]( size_t i ) const {
+
+    return string_view( words ).substr( spans[i].first, spans[i].second );
+
+}
+
+/* Empties the buffer but keeps its memory for the next query */
+void DictionaryTrie::CompletionBuffer::clear() {
+
+    words.clear();
+    spans.clear();
+    paths.clear();
+    frontier.clear();
+
+}
+
+/* Returns the number of heap bytes the buffer holds on to */
+size_t DictionaryTrie::CompletionBuffer::bytes() const {
+
+    return stringHeapBytes( words ) + stringHeapBytes( paths ) +
+           spans.capacity() * sizeof(pair<size_t, size_t>) +
+           frontier.capacity() * sizeof(PathEntry);
+
+}
+
 /* This function takes in a string pattern which most likely contians
  * underscores. These undrscores can be any character in the words that
  * we will return. We will return all predictions for the pattern with 
  * underscore wildcards up to a numCompletions number from high to low
- * frequency.
+ * frequency. Only the best numCompletions matches are kept, and
+ * subtrees without a word of the pattern's length are never entered.
+ * It runs on the same pattern engine as predictWildcards().
  *
  * Parameter: pattern - a word that contains underscores as wildcard chars
  * Parameter: numCompletions - the max length of the list of predictions
  */
 std::vector<string> DictionaryTrie::predictUnderscores(
-    string pattern, unsigned int numCompletions) {
-    
-    //create a vector to hold the words and their frequencies
-    vector<pair<string,unsigned int>*> * stringAndFreq = 
-        new std::vector<std::pair<string, unsigned int>*>();
+    string pattern, unsigned int numCompletions) const {
 
-    //call the recursion helper function to populate vector list
-    getPatterns( stringAndFreq, root, pattern, 0 );
+    //only underscores are special, so '*' or '[' in a pattern still just
+    //match themselves
+    WildcardPattern automaton;
+    automaton.compileUnderscores( pattern, utf8 );
+    return runPattern( automaton, numCompletions );
 
-    //use the same sorter as in predictCompletions
-    std::sort( stringAndFreq->begin(), stringAndFreq->end(), compareFreq );
+}
 
-    //Do the same thing as predictUnderscores to get a single string vector
+/* The character by character matcher predictUnderscores() used before
+ * the pattern engine (it walks with an explicit stack now, the name is
+ * from when it recursed). Same results, kept as the reference the
+ * engine is tested and benchmarked against.
+ *
+ * Parameter: pattern - a word that contains underscores as wildcard chars
+ * Parameter: numCompletions - the max length of the list of predictions
+ */
+std::vector<string> DictionaryTrie::predictUnderscoresRecursive(
+    string pattern, unsigned int numCompletions) const {
+    
     vector<string> wildCardList = std::vector<string>();
-    unsigned int i = 0; 
-    //loop through numCompletion times or the entire vector of pairs
-    while (  i < numCompletions && i < stringAndFreq->size() ) {
+    if( numCompletions == 0 ) {
+        return wildCardList;
+    }
 
-        wildCardList.push_back( stringAndFreq->at(i)->first );
-        i++;
+    //the best numCompletions matches, worst on top
+    MatchHeap matches( compareFreq );
 
-    }
+    //call the helper function to populate the heap
+    getPatterns( matches, numCompletions, pattern );
+
+    //the heap pops the worst match first, so fill the list from the back
+    wildCardList.resize( matches.size() );
+    for( unsigned int i = matches.size(); i > 0; i-- ) {
+
+        wildCardList[i-1] = matches.top().first;
+        matches.pop();
 
-    //free memory of allocated pairs
-    for( unsigned int i = 0; i < stringAndFreq->size(); i++ ) {
-        delete stringAndFreq->at(i);
     }
-    delete stringAndFreq;
 
     //return the list of predicted underscores
     return wildCardList;
 }
 
-/* Standard destructor for the MWT class. It recurses down to all the 
- * leaves and deletes up to the root
+/* Returns up to numCompletions words matching a wildcard pattern, from
+ * high to low frequency and lexicographically for equal frequencies.
+ * The pattern has to match the whole word: _ or ? is any character,
+ * * is any run of characters, [abc] and [^abc] are character classes
+ * with a-z ranges, and a backslash makes the next character literal
+ * (see WildcardPattern). A malformed pattern matches nothing.
+ *
+ * Parameter: pattern - the wildcard pattern
+ * Parameter: numCompletions - the max length of the list of matches
  */
-DictionaryTrie::~DictionaryTrie() {
+vector<string> DictionaryTrie::predictWildcards(
+    const string & pattern, unsigned int numCompletions) const {
 
-    deleteNodes( root );
+    WildcardPattern automaton;
+    automaton.compile( pattern, utf8 );
+    return runPattern( automaton, numCompletions );
 
 }
 
-/* helper method for the destructor so that we can delete nodes
- * recursively without having to know the height of the trie 
+/* Typo tolerant version of predictCompletions(). Returns up to
+ * numCompletions words that start with something at most maxDistance
+ * edits (insertions, deletions or substitutions) away from prefix.
+ * Words needing fewer edits come first, then higher frequencies, then
+ * lexicographic order, so a maxDistance of 0 gives the same list as
+ * predictCompletions(). Meant for a maxDistance of 1 or 2; the work
+ * grows quickly beyond that.
  *
- * Parameter: node - a pointer to the current node we are deleting
+ * Parameter: prefix - the possibly mistyped prefix
+ * Parameter: numCompletions - the max length of the list of predictions
+ * Parameter: maxDistance - the most edits allowed on the prefix
  */
-void DictionaryTrie::deleteNodes( MWTNode* node ) {
+vector<string> DictionaryTrie::predictFuzzy(
+    const string & prefix, unsigned int numCompletions,
+    unsigned int maxDistance) const {
 
-    if( node->hashMap.empty() == true ) {
-        delete node;
-        return;
+    vector<string> completionList = std::vector<string>();
+    if( numCompletions == 0 ) {
+        return completionList;
     }
-    //create an iterator at the beginning
-    auto iterator = node->hashMap.begin();
-    //loop from beginning ot end
-    while( iterator != node->hashMap.end() ) {
 
-        // recurse to each Node stored as values
-        deleteNodes( iterator->second );
-        iterator++;
+    vector<FuzzyEntry> roots;
+    fuzzyRoots( prefix, maxDistance, roots );
+
+    //best-first search like predictCompletions(), but over every subtree
+    //within the distance at once, the closest ones first
+    priority_queue<FuzzyEntry, vector<FuzzyEntry>, CompareFuzzy>
+        frontier( CompareFuzzy(), std::move( roots ) );
+
+    //a subtree found at one distance can hold a deeper one found at a
+    //smaller distance, whose words come out first and must not repeat
+    std::unordered_set<const MWTNode*> listed;
+
+    while( completionList.size() < numCompletions && !frontier.empty() ) {
+
+        FuzzyEntry entry = frontier.top();
+        frontier.pop();
+
+        if( entry.isWord ) {
+            if( listed.insert( entry.node ).second ) {
+                completionList.push_back( entry.word );
+            }
+            continue;
+        }
+
+        if( entry.node->isEnd ) {
+            frontier.push( FuzzyEntry{ entry.distance, entry.node->freq,
+                                       entry.word, entry.node, true } );
+        }
+        auto iterator = entry.node->children.begin();
+        while( iterator != entry.node->children.end() ) {
+            string word = entry.word + iterator->first;
+            const MWTNode* child = skipChain( iterator->second, word );
+            frontier.push( FuzzyEntry{ entry.distance, child->maxFreq,
+                                       std::move( word ), child, false } );
+            iterator++;
+        }
 
     }
 
-    //finally delete the current node and return
-    delete node;
+    return completionList;
 
 }
-    
-/* helper method for predictCompletions(), recurses down all of the
- * MWTNodes (after prefix) and if there is a valid word, it added the
- * word along with its frequency to the list passed in.
+
+/* Answers a whole batch of queries on the batch thread pool and
+ * returns the results in the order of the queries. Each result is
+ * the same as a single predictCompletions() or predictUnderscores()
+ * call would give. Do not change the MWT while a batch runs.
  *
- * Parameter: wordList - the list of all the word completions we track
- * Parameter: curNode - the current node of the recursion
- * Parameter: curWord - a string of the word built so far
+ * Parameter: queries - the first query of the batch
+ * Parameter: numQueries - the number of queries in the batch
  */
-void DictionaryTrie::listWords( vector<pair<string, unsigned int>*> * wordList,
-                                MWTNode* curNode, string curWord ) {
+vector<vector<string>> DictionaryTrie::predictBatch(
+    const CompletionQuery* queries, size_t numQueries) const {
+
+    //queries handed out to a thread at a time, small enough that threads
+    //that get cheap prefixes can steal from ones stuck on wide patterns
+    const size_t GRAIN = 16;
+
+    //every query writes only its own result, so no locking is needed
+    vector<vector<string>> results = vector<vector<string>>( numQueries );
+    function<void(size_t, size_t)> answer = [&]( size_t begin, size_t end ) {
+        for( size_t i = begin; i < end; i++ ) {
+            const CompletionQuery & query = queries[i];
+            if( query.text.find('_') != string::npos ) {
+                results[i] = predictUnderscores( query.text,
+                                                 query.numCompletions );
+            } else {
+                results[i] = predictCompletions( query.text,
+                                                 query.numCompletions );
+            }
+        }
+    };
 
-    //base case of current node being null
-    if( curNode == nullptr ) {
-        return;
+    lock_guard<mutex> guard( batchLock );
+    if( batchPool == nullptr ) {
+        batchPool = unique_ptr<WorkStealingPool>(
+            new WorkStealingPool( batchThreads ) );
     }
-    
-    //check to see if the current node is the final letter for a word
-    if( curNode->isEnd == true ) {
+    batchPool->parallelFor( numQueries, GRAIN, answer );
+    return results;
 
-        //put the word and its frequency into the vector
-        wordList->push_back( 
-            new std::pair<string, unsigned int>( curWord, curNode->freq ) );
+}
 
-    }
-    
-    //create an iterator at the beginning
-    auto iterator = curNode->hashMap.begin();
-    //loop through each key
-    while( iterator != curNode->hashMap.end() ) {
+/* Sets the number of threads predictBatch() runs on, the calling
+ * thread included. 0, the default, means one per hardware thread.
+ *
+ * Parameter: numThreads - the number of threads batches run on
+ */
+void DictionaryTrie::setBatchThreads(unsigned int numThreads) {
 
-        //append the key character to the current word
-        string newWord = curWord + iterator->first;
-        
-        //recurse down to listwords
-        listWords( wordList, iterator->second, newWord ); 
-        
-        iterator++;
+    lock_guard<mutex> guard( batchLock );
+    batchThreads = numThreads;
+    //the next batch starts a pool of the new size
+    batchPool.reset();
 
-    }
+}
+
+/* Turns UTF-8 mode on or off. In UTF-8 mode insert() and appendSorted()
+ * refuse words that are not valid UTF-8, and the wildcards of
+ * predictUnderscores() and predictWildcards() match one whole code point
+ * instead of one byte, so every result is valid UTF-8 too. The MWT stays
+ * keyed on bytes, a code point is a path of 1 to 4 nodes. Turn it on
+ * before loading, words already in the MWT are not checked.
+ * predictFuzzy() still counts edits in bytes.
+ *
+ * Parameter: enabled - should the MWT be in UTF-8 mode
+ */
+void DictionaryTrie::setUtf8(bool enabled) {
+
+    utf8 = enabled;
+
+}
+
+/* Returns true if the MWT is in UTF-8 mode */
+bool DictionaryTrie::isUtf8() const {
+
+    return utf8;
 
 }
 
-/* Helper method for predictUnderscores() which recurses down 
- * the MWT. For each recursion we either recurse down the chracter at
- * pos or if its an underscore recurse down all characters at pos.
- * when pos reaches the end of pattern's length, it adds the word
- * if valid.
+/* Turns on the precomputed top-K completion cache. Every node keeps
+ * the k most frequent words of its subtree, so predictCompletions()
+ * with numCompletions <= k is a prefix walk plus a copy. The lists are
+ * built here, so call it after bulk loading; insert() keeps them
+ * correct afterwards. Passing 0 turns the cache off.
  *
- * Parameter: wordList - a list holding words and their frequencies
- * Parameter: curNode - the current node in the recursion
- * Parameter: pattern - the current string pattern
- * Parameter: pos - the position in the pattern the recursion is at
+ * Parameter: k - the number of completions cached at every node
  */
-void DictionaryTrie::getPatterns( 
-    vector<pair<string, unsigned int>*> * wordList, MWTNode* curNode, 
-    string pattern, unsigned int pos ) {
+void DictionaryTrie::enableTopKCache( unsigned int k ) {
+
+    topKSize = k;
+    //slot 0 and word 0 are reserved to mean "not assigned"
+    topKLists = vector<vector<MWTNode*>>( 1 );
+    wordTable = vector<string>( 1 );
 
-    //if we pass in a null Node
-    if( curNode == nullptr ) {
+    if( k == 0 ) {
+        topKLists.clear();
+        wordTable.clear();
         return;
     }
 
-    //base case if we are after the last character
-    if( pos == pattern.size() ) {
+    buildTopK();
 
-        //if it is an end of a word, add it to the list
-        if( curNode->isEnd ) {
+}
+
+/* Turns on a cache of whole predictCompletions() answers, keyed by
+ * the prefix and numCompletions, that keeps the capacity most
+ * recently used ones. It pays off when a few hot prefixes make up
+ * most of the queries. insert() and the frequency updates drop the
+ * answers of every prefix of the word they change. Readers on many
+ * threads can share it. Passing 0 turns the cache off.
+ *
+ * Parameter: capacity - the most answers to keep
+ */
+void DictionaryTrie::enableResultCache( size_t capacity ) {
 
-            wordList->push_back( 
-                new std::pair<string, unsigned int>(pattern, curNode->freq) );
+    clearResults();
+    lock_guard<mutex> guard( resultLock );
+    resultCapacity = capacity;
 
-        }
+}
 
-        //return since we have filled in the underscores
-        return;
+/* Returns the hit, miss, eviction and invalidation counters of the
+ * result cache and its current number of entries.
+ */
+ResultCacheStats DictionaryTrie::resultCacheStats() const {
+
+    lock_guard<mutex> guard( resultLock );
+    ResultCacheStats stats = resultStats;
+    stats.entries = resultLru.size();
+    return stats;
+
+}
 
+/* Drops the cached answers of every prefix of word, since changing
+ * word can change each of their lists.
+ *
+ * Parameter: word - the word that was added or changed
+ */
+void DictionaryTrie::invalidateResults( string_view word ) {
+
+    if( resultCapacity == 0 ) {
+        return;
     }
 
-    //check to see if the current letter is an underscore or not
-    if( pattern[pos] == '_' ) {
-        
-        //if it is an underscore recurse down every character in curNode
-        auto iterator = curNode->hashMap.begin();
-        while( iterator != curNode->hashMap.end() ) {
-            string newStr = pattern;
-            *(newStr.begin() + pos) = iterator->first;
-            getPatterns( wordList, iterator->second, newStr, pos+1 );
-            iterator++;
+    lock_guard<mutex> guard( resultLock );
+    string prefix;
+    for( unsigned int i = 0; i <= word.size() && !resultIndex.empty();
+         i++ ) {
+
+        auto found = resultIndex.find( prefix );
+        if( found != resultIndex.end() ) {
+            for( auto entry : found->second ) {
+                resultLru.erase( entry );
+                resultStats.invalidations++;
+            }
+            resultIndex.erase( found );
+        }
+        if( i < word.size() ) {
+            prefix.push_back( word[i] );
         }
 
-    } else {
+    }
 
-        //check to see if the char is in the tree
-        auto charIter = curNode->hashMap.find(pattern[pos]);
-        if( charIter == curNode->hashMap.end() ) {
-            return;
+}
+
+/* Drops every cached answer, for changes that touch the whole MWT */
+void DictionaryTrie::clearResults() {
+
+    lock_guard<mutex> guard( resultLock );
+    resultStats.invalidations += resultLru.size();
+    resultLru.clear();
+    resultIndex.clear();
+
+}
+
+/* Returns the number of bytes used by the top-K cache (the lists and
+ * the word table they reference), 0 if the cache is disabled.
+ */
+size_t DictionaryTrie::topKCacheBytes() const {
+
+    if( topKSize == 0 ) {
+        return 0;
+    }
+
+    size_t bytes = topKLists.capacity() * sizeof(vector<MWTNode*>) +
+                   wordTable.capacity() * sizeof(string);
+    for( unsigned int i = 0; i < topKLists.size(); i++ ) {
+        bytes += topKLists[i].capacity() * sizeof(MWTNode*);
+    }
+    //only strings too long for the small string buffer own heap memory
+    for( unsigned int i = 0; i < wordTable.size(); i++ ) {
+        if( wordTable[i].capacity() > string().capacity() ) {
+            bytes += wordTable[i].capacity() + 1;
         }
+    }
+    return bytes;
+
+}
+
+/* Returns the number of bytes used by the nodes of the MWT and their
+ * child storage, not counting the top-K cache.
+ */
+size_t DictionaryTrie::memoryBytes() const {
+
+    return subtreeBytes( root );
+
+}
+
+/* Returns the number of nodes in the MWT, the root included */
+size_t DictionaryTrie::nodeCount() const {
 
-        getPatterns( wordList, charIter->second, pattern, pos+1 );
+    size_t nodes = 0;
+    vector<const MWTNode*> stack;
+    stack.push_back( root );
+    while( !stack.empty() ) {
+
+        const MWTNode* curNode = stack.back();
+        stack.pop_back();
+        nodes++;
+        auto iterator = curNode->children.begin();
+        while( iterator != curNode->children.end() ) {
+            stack.push_back( iterator->second );
+            iterator++;
+        }
 
     }
+    return nodes;
+
+}
+
+/* Walks the MWT and returns its node and word counts, the depth and
+ * fan-out histograms of its nodes and the memory used by each part.
+ */
+TrieStats DictionaryTrie::trieStats() const {
+
+    TrieStats stats = TrieStats();
+    stats.fanOutHistogram.assign( 257, 0 );
+
+    //a node and its depth, the order of the walk does not matter
+    vector<pair<const MWTNode*, size_t>> stack;
+    stack.push_back( make_pair( root, 0 ) );
+    while( !stack.empty() ) {
+
+        const MWTNode* curNode = stack.back().first;
+        size_t depth = stack.back().second;
+        stack.pop_back();
+
+        stats.nodes++;
+        if( curNode->isEnd ) {
+            stats.words++;
+        }
+        if( depth >= stats.depthHistogram.size() ) {
+            stats.depthHistogram.resize( depth + 1, 0 );
+        }
+        stats.depthHistogram[depth]++;
+        stats.fanOutHistogram[curNode->children.size()]++;
+        stats.childMapBytes += curNode->children.bytes();
+
+        auto iterator = curNode->children.begin();
+        while( iterator != curNode->children.end() ) {
+            stack.push_back( make_pair( iterator->second, depth + 1 ) );
+            iterator++;
+        }
+
+    }
+
+    //drop the empty top of the fan-out histogram
+    while( stats.fanOutHistogram.size() > 1 &&
+           stats.fanOutHistogram.back() == 0 ) {
+        stats.fanOutHistogram.pop_back();
+    }
+    stats.nodeBytes = stats.nodes * sizeof(MWTNode);
+    stats.arenaBytes = arena.bytesAllocated();
+    stats.topKCacheBytes = topKCacheBytes();
+
+    lock_guard<mutex> guard( resultLock );
+    for( const CachedResult & cached : resultLru ) {
+        stats.resultCacheBytes += sizeof(CachedResult) +
+                                  stringHeapBytes( cached.prefix ) +
+                                  cached.completions.capacity() *
+                                  sizeof(string);
+        for( const string & word : cached.completions ) {
+            stats.resultCacheBytes += stringHeapBytes( word );
+        }
+    }
+    return stats;
+
+}
+
+/* Starts a bulk load of words that come in sorted (byte) order. Only
+ * the path of the last word is kept: every new word shares a prefix
+ * with it, the rest of the last path is complete and finalized, and
+ * the new word's nodes are appended after it without any lookups.
+ * If the MWT is not empty the bulk load just uses insert(). Do not
+ * call insert() until endSorted().
+ */
+void DictionaryTrie::beginSorted() {
+
+    bulkLastWord.clear();
+    bulkPath.clear();
+    bulkFellBack = false;
+    bulkActive = root->children.empty();
+    if( bulkActive ) {
+        bulkPath.push_back( root );
+    }
+
+}
+
+/* Adds the next word of a sorted bulk load, same return value as
+ * insert(). A word that is out of order makes the rest of the bulk
+ * load fall back to insert(), so the result is always correct.
+ *
+ * Parameter: word - the word string we are inserting into the MWT
+ * Parameter: freq - the frequency of the word
+ */
+bool DictionaryTrie::appendSorted(string_view word, unsigned int freq) {
+
+    if( !bulkActive ) {
+        return insert( word, freq );
+    }
+    if( word.size() < 1 ) {
+        return false;
+    }
+    if( utf8 && !validUtf8( word ) ) {
+        return false;
+    }
+
+    //a word that is not bigger than the last one is a duplicate or is
+    //out of order
+    int cmp = word.compare( bulkLastWord );
+    if( cmp <= 0 && bulkLastWord.size() > 0 ) {
+
+        if( cmp == 0 ) {
+            return false;
+        }
+        finishSorted();
+        bulkFellBack = true;
+        return insert( word, freq );
+
+    }
+
+    //the nodes past the shared prefix will never get another child
+    unsigned int shared = 0;
+    while( shared < word.size() && shared < bulkLastWord.size() &&
+           word[shared] == bulkLastWord[shared] ) {
+        shared++;
+    }
+    popSorted( shared + 1 );
+
+    //every new key is bigger than its siblings, so it goes at the end
+    for( unsigned int i = shared; i < word.size(); i++ ) {
+        MWTNode* node = newNode();
+        bulkPath.back()->children.append( word[i], node, arena );
+        bulkPath.push_back( node );
+    }
+
+    MWTNode* finalLetter = bulkPath.back();
+    finalLetter->isEnd = true;
+    finalLetter->freq = freq;
+    finalLetter->maxFreq = freq;
+    finalLetter->minLen = 0;
+    finalLetter->maxLen = 0;
+    bulkLastWord.assign( word.data(), word.size() );
+    return true;
+
+}
+
+/* Ends a sorted bulk load. Returns true if every word came in order,
+ * false if the bulk load had to fall back to insert().
+ */
+bool DictionaryTrie::endSorted() {
+
+    if( bulkActive ) {
+        finishSorted();
+    }
+    return !bulkFellBack;
+
+}
+
+/* helper method for the sorted bulk load which pops nodes off the end
+ * of bulkPath until size nodes are left. A popped node's subtree is
+ * complete, so its maxFreq is final and is passed up to its parent.
+ *
+ * Parameter: size - the number of nodes to keep on bulkPath
+ */
+void DictionaryTrie::popSorted( unsigned int size ) {
+
+    while( bulkPath.size() > size ) {
+
+        MWTNode* child = bulkPath.back();
+        bulkPath.pop_back();
+        if( bulkPath.back()->maxFreq < child->maxFreq ) {
+            bulkPath.back()->maxFreq = child->maxFreq;
+        }
+        widenLengths( bulkPath.back(), child );
+
+    }
+
+}
+
+/* helper method for the sorted bulk load which finishes every node
+ * still on bulkPath, rebuilds the top-K cache if it is on and ends
+ * the bulk load.
+ */
+void DictionaryTrie::finishSorted() {
+
+    popSorted( 1 );
+    bulkPath.clear();
+    bulkLastWord.clear();
+    bulkActive = false;
+    if( topKSize > 0 ) {
+        enableTopKCache( topKSize );
+    }
+    clearResults();
+
+}
+
+/* Moves every word of shard into this MWT by hanging the subtrees
+ * under shard's root directly off this root and taking over shard's
+ * arena, without copying a node. This is how the shards of a parallel
+ * build are stitched together. It only works if both are in the same
+ * UTF-8 mode and no first character of shard is already a child of
+ * this root; otherwise nothing is moved and false is returned. shard
+ * is left empty.
+ *
+ * Parameter: shard - the MWT whose words are moved into this one
+ */
+bool DictionaryTrie::absorb( DictionaryTrie & shard ) {
+
+    //the words of a shard in the other mode were never checked against
+    //this one's rules
+    if( shard.utf8 != utf8 ) {
+        return false;
+    }
+    auto iterator = shard.root->children.begin();
+    while( iterator != shard.root->children.end() ) {
+        if( root->children.find(iterator->first) != nullptr ) {
+            return false;
+        }
+        iterator++;
+    }
+
+    iterator = shard.root->children.begin();
+    while( iterator != shard.root->children.end() ) {
+        root->children.insert( iterator->first, iterator->second, arena );
+        widenLengths( root, iterator->second );
+        iterator++;
+    }
+    if( root->maxFreq < shard.root->maxFreq ) {
+        root->maxFreq = shard.root->maxFreq;
+    }
+
+    //the moved nodes live in shard's slabs, so those become ours too
+    arena.absorb( shard.arena );
+    shard.root = shard.newNode();
+    shard.enableTopKCache( 0 );
+    shard.clearResults();
+    clearResults();
+
+    //the cache refers to nodes by slot, so it is simplest to rebuild it
+    if( topKSize > 0 ) {
+        enableTopKCache( topKSize );
+    }
+    return true;
+
+}
+
+/* Writes the MWT to fileName as a position independent binary image
+ * that DictionarySnapshot can mmap and query without rebuilding the
+ * trie. The top-K cache is not part of the image. Returns false if
+ * the file could not be written.
+ *
+ * Parameter: fileName - the file to write the snapshot to
+ */
+bool DictionaryTrie::writeSnapshot( const string & fileName ) const {
+
+    //number the nodes breadth-first so every node's children end up
+    //next to each other, in key order
+    vector<const MWTNode*> order = vector<const MWTNode*>();
+    vector<SnapshotNode> nodes = vector<SnapshotNode>();
+    vector<uint8_t> keys = vector<uint8_t>();
+    unsigned int wordCount = 0;
+    order.push_back( root );
+    keys.push_back( 0 );
+
+    for( unsigned int i = 0; i < order.size(); i++ ) {
+
+        const MWTNode* node = order[i];
+        SnapshotNode snapNode;
+        snapNode.freq = node->freq;
+        snapNode.maxFreq = node->maxFreq;
+        snapNode.firstChild = order.size();
+        snapNode.childCount = node->children.size();
+        snapNode.isEnd = node->isEnd;
+        snapNode.unused = 0;
+        nodes.push_back( snapNode );
+        if( node->isEnd ) {
+            wordCount++;
+        }
+
+        auto iterator = node->children.begin();
+        while( iterator != node->children.end() ) {
+            order.push_back( iterator->second );
+            keys.push_back( (uint8_t) iterator->first );
+            iterator++;
+        }
+
+    }
+
+    SnapshotHeader header;
+    memcpy( header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC) );
+    header.version = SNAPSHOT_VERSION;
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.nodeCount = nodes.size();
+    header.wordCount = wordCount;
+    header.nodesOffset = sizeof(SnapshotHeader);
+    header.keysOffset = header.nodesOffset + 
+                        nodes.size() * sizeof(SnapshotNode);
+
+    ofstream out;
+    out.open( fileName, ios::binary | ios::trunc );
+    out.write( (const char*) &header, sizeof(header) );
+    out.write( (const char*) nodes.data(), 
+               nodes.size() * sizeof(SnapshotNode) );
+    out.write( (const char*) keys.data(), keys.size() );
+    out.close();
+    return !out.fail();
+
+}
+
+/* Returns the number of bytes the node arena has allocated from the
+ * system, including slack in its slabs and recycled blocks.
+ */
+size_t DictionaryTrie::arenaBytes() const {
+
+    return arena.bytesAllocated();
+
+}
+
+/* Standard destructor for the MWT class. The nodes live in the arena,
+ * so they are freed slab by slab without walking the trie.
+ */
+DictionaryTrie::~DictionaryTrie() {}
+
+/* Creates a new empty MWTNode in the arena and returns it */
+DictionaryTrie::MWTNode* DictionaryTrie::newNode() {
+
+    return new ( arena.allocate( sizeof(MWTNode) ) ) MWTNode();
+
+}
+
+/* helper method for insert() which walks down the path of a newly
+ * inserted word and raises the maxFreq of every node on it, including
+ * the root and the word's own node, so it covers the new frequency.
+ * It also widens the minLen and maxLen of every node on the path to
+ * cover the new word's length.
+ *
+ * Parameter: word - the word that was just inserted
+ * Parameter: freq - the frequency of the word
+ */
+void DictionaryTrie::raisePathBounds( string_view word, unsigned int freq ) {
+
+    MWTNode* currNode = root;
+    for( unsigned int i = 0; i <= word.size(); i++ ) {
+
+        if( i > 0 ) {
+            currNode = currNode->children.find(word[i-1]);
+        }
+        if( currNode->maxFreq < freq ) {
+            currNode->maxFreq = freq;
+        }
+
+        //the word ends this many characters below the node
+        size_t remaining = word.size() - i;
+        uint16_t length = remaining < LEN_MAX ? remaining : LEN_MAX;
+        if( currNode->minLen > length ) {
+            currNode->minLen = length;
+        }
+        if( currNode->maxLen < length ) {
+            currNode->maxLen = length;
+        }
+
+    }
+
+}
+
+/* Widens the minLen and maxLen of parent to cover the words below
+ * child, which is one character further down.
+ *
+ * Parameter: parent - the node whose lengths are widened
+ * Parameter: child - a child of parent whose subtree is complete
+ */
+void DictionaryTrie::widenLengths( MWTNode* parent, const MWTNode* child ) {
+
+    //a child with no word below it has nothing to pass up
+    if( child->maxLen < child->minLen ) {
+        return;
+    }
+    uint16_t minLen = child->minLen == LEN_MAX ? LEN_MAX : child->minLen + 1;
+    uint16_t maxLen = child->maxLen == LEN_MAX ? LEN_MAX : child->maxLen + 1;
+    if( parent->minLen > minLen ) {
+        parent->minLen = minLen;
+    }
+    if( parent->maxLen < maxLen ) {
+        parent->maxLen = maxLen;
+    }
+
+}
+
+/* helper method for updateFrequency() which recomputes the maxFreq of
+ * the nodes on a word's path from the bottom up, each from its own
+ * frequency and its children's maxFreq. It stops as soon as a node's
+ * maxFreq comes out unchanged since nothing above it can change then.
+ *
+ * Parameter: path - the nodes spelling the word, starting with the root
+ */
+void DictionaryTrie::repairMaxFreq( const vector<MWTNode*> & path ) {
+
+    for( unsigned int i = path.size(); i > 0; i-- ) {
+
+        MWTNode* node = path[i-1];
+        unsigned int maxFreq = node->isEnd ? node->freq : 0;
+        auto iterator = node->children.begin();
+        while( iterator != node->children.end() ) {
+            if( iterator->second->maxFreq > maxFreq ) {
+                maxFreq = iterator->second->maxFreq;
+            }
+            iterator++;
+        }
+
+        if( node->maxFreq == maxFreq ) {
+            return;
+        }
+        node->maxFreq = maxFreq;
+
+    }
+
+}
+
+/* helper method for memoryBytes() which walks the MWT below node with
+ * an explicit stack and adds up the size of every node and of its
+ * child storage.
+ *
+ * Parameter: node - the root of the subtree to measure
+ */
+size_t DictionaryTrie::subtreeBytes( const MWTNode* node ) const {
+
+    //the order does not matter for a sum, so a plain stack of nodes will do
+    size_t bytes = 0;
+    vector<const MWTNode*> stack = vector<const MWTNode*>( 1, node );
+    while( !stack.empty() ) {
+
+        const MWTNode* curNode = stack.back();
+        stack.pop_back();
+        bytes += sizeof(MWTNode) + curNode->children.bytes();
+        auto iterator = curNode->children.begin();
+        while( iterator != curNode->children.end() ) {
+            stack.push_back( iterator->second );
+            iterator++;
+        }
+
+    }
+    return bytes;
+
+}
+
+/* helper method for enableTopKCache() which walks down the MWT with
+ * an explicit stack and gives every node a top-K list and every word
+ * an entry in wordTable. A node's list is filled in when it is popped,
+ * after its children's lists are built.
+ */
+void DictionaryTrie::buildTopK() {
+
+    vector<WalkFrame> stack;
+    string word;
+    MWTNode* node = root;
+    unsigned int depth = 0;
+
+    while( true ) {
+
+        //first visit: number the node and its word, then go below it
+        if( node != nullptr ) {
+
+            node->topKSlot = topKLists.size();
+            topKLists.push_back( vector<MWTNode*>() );
+            word.resize( depth );
+            if( node->isEnd ) {
+                node->wordId = wordTable.size();
+                wordTable.push_back( word );
+            }
+            stack.push_back(
+                WalkFrame{ node, depth, 0, node->children.begin() } );
+            node = nullptr;
+
+        }
+
+        if( stack.empty() ) {
+            break;
+        }
+
+        WalkFrame & top = stack.back();
+        if( top.next != top.node->children.end() ) {
+
+            node = top.next->second;
+            depth = top.depth + 1;
+            word.resize( top.depth );
+            word.push_back( top.next->first );
+            ++top.next;
+            continue;
+
+        }
+
+        //every child is done, so the node's list can be merged
+        mergeTopK( top.node );
+        //most subtrees hold fewer than k words, don't keep the slack around
+        topKLists[top.node->topKSlot].shrink_to_fit();
+        stack.pop_back();
+
+    }
+
+}
+
+/* helper method for insert() which fixes the top-K lists on the path
+ * of a newly inserted word, from the word's node back up to the root.
+ *
+ * Parameter: word - the word that was just inserted
+ */
+void DictionaryTrie::repairTopK( string_view word ) {
+
+    //remember the path since the lists have to be fixed bottom-up
+    vector<MWTNode*> path = vector<MWTNode*>();
+    MWTNode* currNode = root;
+    path.push_back( currNode );
+    for( unsigned int i = 0; i < word.size(); i++ ) {
+        currNode = currNode->children.find(word[i]);
+        path.push_back( currNode );
+    }
+
+    //the word's node and any node created for it have no list yet
+    for( unsigned int i = 0; i < path.size(); i++ ) {
+        if( path[i]->topKSlot == 0 ) {
+            path[i]->topKSlot = topKLists.size();
+            topKLists.push_back( vector<MWTNode*>() );
+        }
+    }
+    if( currNode->wordId == 0 ) {
+        currNode->wordId = wordTable.size();
+        wordTable.push_back( string( word ) );
+    }
+
+    for( unsigned int i = path.size(); i > 0; i-- ) {
+        mergeTopK( path[i-1] );
+    }
+
+}
+
+/* Refills the top-K list of node by merging its own word with the
+ * (already correct) lists of its children. Children are merged in key
+ * order so equal frequencies stay lexicographically ordered.
+ *
+ * Parameter: node - the node whose list is rebuilt
+ */
+void DictionaryTrie::mergeTopK( MWTNode* node ) {
+
+    //the children come in key order, and every word below a smaller key
+    //comes first lexicographically
+    vector<MWTNode*> children;
+    auto iterator = node->children.begin();
+    while( iterator != node->children.end() ) {
+        children.push_back( iterator->second );
+        iterator++;
+    }
+
+    vector<MWTNode*> & list = topKLists[node->topKSlot];
+    list.clear();
+    vector<unsigned int> heads = vector<unsigned int>( children.size(), 0 );
+    //the node's own word is shorter than, so ahead of, every child's word
+    bool ownPending = node->isEnd;
+
+    while( list.size() < topKSize ) {
+
+        MWTNode* best = ownPending ? node : nullptr;
+        int bestChild = -1;
+        for( unsigned int c = 0; c < children.size(); c++ ) {
+
+            const vector<MWTNode*> & childList = 
+                topKLists[children[c]->topKSlot];
+            if( heads[c] < childList.size() && ( best == nullptr || 
+                childList[heads[c]]->freq > best->freq ) ) {
+                best = childList[heads[c]];
+                bestChild = c;
+            }
+
+        }
+
+        if( best == nullptr ) {
+            break;
+        }
+        list.push_back( best );
+        if( bestChild == -1 ) {
+            ownPending = false;
+        } else {
+            heads[bestChild]++;
+        }
+
+    }
+
+}
+
+/* Helper method for predictUnderscoresRecursive() which walks down
+ * the MWT with an explicit stack. At each position it either follows
+ * the pattern's character or, for an underscore, every child. When
+ * the walk reaches the end of pattern's length, it adds the word if
+ * valid. Subtrees with no word of the pattern's length, or whose
+ * maxFreq cannot beat the worst of numCompletions matches, are
+ * skipped.
+ *
+ * Parameter: matches - the best matches found so far
+ * Parameter: numCompletions - the most matches to keep
+ * Parameter: pattern - the pattern with underscores
+ */
+void DictionaryTrie::getPatterns( MatchHeap & matches,
+                                  unsigned int numCompletions,
+                                  const string & pattern ) const {
+
+    //the pattern with its underscores filled in down to the current node
+    string word = pattern;
+    vector<WalkFrame> stack;
+    MWTNode* curNode = root;
+    unsigned int pos = 0;
+
+    while( true ) {
+
+        //follow the pattern's characters until an underscore, a dead end
+        //or a skipped subtree
+        while( curNode != nullptr ) {
+
+            //skip the subtree if none of its words ends exactly at the end
+            //of the pattern
+            size_t remaining = pattern.size() - pos;
+            if( remaining < curNode->minLen ||
+                ( curNode->maxLen != LEN_MAX &&
+                  remaining > curNode->maxLen ) ) {
+                break;
+            }
+
+            //skip the subtree if even its best word would not make the
+            //cut, an equal frequency still could since it may come first
+            //alphabetically
+            if( matches.size() == numCompletions &&
+                curNode->maxFreq < matches.top().second ) {
+                break;
+            }
+
+            //after the last character, keep the word if it is one of the
+            //best
+            if( remaining == 0 ) {
+
+                if( curNode->isEnd ) {
+                    pair<string, unsigned int> match( word, curNode->freq );
+                    if( matches.size() < numCompletions ) {
+                        matches.push( match );
+                    } else if( compareFreq( match, matches.top() ) ) {
+                        matches.pop();
+                        matches.push( match );
+                    }
+                }
+                break;
+
+            }
+
+            //an underscore tries every child, which takes a stack frame
+            if( pattern[pos] == '_' ) {
+                stack.push_back( WalkFrame{ curNode, pos, 0,
+                                            curNode->children.begin() } );
+                break;
+            }
+
+            curNode = curNode->children.find(pattern[pos]);
+            pos++;
+
+        }
+
+        if( stack.empty() ) {
+            break;
+        }
+
+        //go on with the next child of the deepest underscore
+        WalkFrame & top = stack.back();
+        if( top.next == top.node->children.end() ) {
+            stack.pop_back();
+            curNode = nullptr;
+            continue;
+        }
+        word[top.depth] = top.next->first;
+        curNode = top.next->second;
+        pos = top.depth + 1;
+        ++top.next;
+
+    }
+
+}
+
+/* Comparator for the best-first completion queue. Returns true when e1
+ * should be popped after e2: it has a lower frequency, or the same
+ * frequency and a lexicographically larger word, or the same word but e1
+ * is a subtree while e2 is a finished word.
+ *
+ * Parameter: e1 - the first entry to be compared
+ * Parameter: e2 - the second entry to be compared
+ */
+bool DictionaryTrie::CompareEntry::operator()( 
+    const CompletionEntry & e1, const CompletionEntry & e2 ) const {
+
+    if( e1.freq != e2.freq ) {
+        return e1.freq < e2.freq;
+    }
+
+    int cmp = e1.word.compare(e2.word);
+    if( cmp != 0 ) {
+        return cmp > 0;
+    }
+
+    //same path: the finished word has to come out before its subtree
+    return e1.node != nullptr && e2.node == nullptr;
+
+}
+
+/* Helper method for predictFuzzy() which walks the MWT with an
+ * explicit stack, keeping the Levenshtein DP row of the path against
+ * prefix, one row per depth. A node whose path is within maxDistance
+ * edits of the whole prefix, and closer than any node above it, is
+ * added to roots. The walk stops where the smallest value in the row
+ * can no longer beat the best distance on the path.
+ *
+ * Parameter: prefix - the possibly mistyped prefix
+ * Parameter: maxDistance - the most edits allowed on the prefix
+ * Parameter: roots - the subtrees found within the distance
+ */
+void DictionaryTrie::fuzzyRoots( const string & prefix,
+                                 unsigned int maxDistance,
+                                 vector<FuzzyEntry> & roots ) const {
+
+    //the root's row is the cost of building the prefix from nothing
+    unsigned int cols = prefix.size() + 1;
+    vector<unsigned int> rows = vector<unsigned int>(
+        ( prefix.size() + maxDistance + 2 ) * cols );
+    for( unsigned int j = 0; j < cols; j++ ) {
+        rows[j] = j;
+    }
+
+    vector<WalkFrame> stack;
+    string path;
+    MWTNode* curNode = root;
+    unsigned int depth = 0;
+    unsigned int bestOnPath = maxDistance + 1;
+
+    while( true ) {
+
+        if( curNode != nullptr ) {
+
+            const unsigned int* row = &rows[depth * cols];
+
+            //every word below here starts with path, so they are all this
+            //close
+            if( row[prefix.size()] < bestOnPath ) {
+                bestOnPath = row[prefix.size()];
+                roots.push_back( FuzzyEntry{ bestOnPath, curNode->maxFreq,
+                                             path, curNode, false } );
+            }
+
+            //rows only grow going down, so go below the node only if a
+            //deeper node can still be closer
+            unsigned int rowMin = row[0];
+            for( unsigned int j = 1; j < cols; j++ ) {
+                if( row[j] < rowMin ) {
+                    rowMin = row[j];
+                }
+            }
+            if( rowMin < bestOnPath ) {
+                if( rows.size() < ( depth + 2 ) * cols ) {
+                    rows.resize( ( depth + 2 ) * cols );
+                }
+                stack.push_back( WalkFrame{ curNode, depth, bestOnPath,
+                                            curNode->children.begin() } );
+            }
+            curNode = nullptr;
+
+        }
+
+        if( stack.empty() ) {
+            break;
+        }
+
+        WalkFrame & top = stack.back();
+        if( top.next == top.node->children.end() ) {
+            stack.pop_back();
+            continue;
+        }
+
+        const unsigned int* above = &rows[top.depth * cols];
+        unsigned int* next = &rows[( top.depth + 1 ) * cols];
+        char key = top.next->first;
+
+        //insert, delete or substitute (free if the characters match)
+        next[0] = above[0] + 1;
+        for( unsigned int j = 1; j < cols; j++ ) {
+            unsigned int cost = above[j-1] + ( prefix[j-1] != key ? 1 : 0 );
+            if( above[j] + 1 < cost ) {
+                cost = above[j] + 1;
+            }
+            if( next[j-1] + 1 < cost ) {
+                cost = next[j-1] + 1;
+            }
+            next[j] = cost;
+        }
+
+        path.resize( top.depth );
+        path.push_back( key );
+        curNode = top.next->second;
+        depth = top.depth + 1;
+        bestOnPath = top.bound;
+        ++top.next;
+
+    }
+
+}
+
+/* Runs a compiled pattern over the whole MWT and returns the best
+ * numCompletions matches from high to low frequency, ties in
+ * lexicographic order.
+ *
+ * Parameter: automaton - the compiled pattern
+ * Parameter: numCompletions - the max length of the list of matches
+ */
+vector<string> DictionaryTrie::runPattern( const WildcardPattern & automaton,
+                                           unsigned int numCompletions )
+    const {
+
+    STATS_RESET();
+    vector<string> matchList = vector<string>();
+    if( numCompletions == 0 ) {
+        return matchList;
+    }
+
+    MatchHeap matches( compareFreq );
+    STATS_PHASE( walk );
+    matchPattern( automaton, matches, numCompletions );
+    STATS_PHASE_END( walk );
+
+    //the heap pops the worst match first, so fill the list from the back
+    STATS_PHASE( sort );
+    matchList.resize( matches.size() );
+    STATS_ADD( bytesAllocated, matchList.capacity() * sizeof(string) );
+    for( unsigned int i = matches.size(); i > 0; i-- ) {
+        matchList[i-1] = matches.top().first;
+        matches.pop();
+    }
+    return matchList;
+
+}
+
+/* Helper method for runPattern() which walks the MWT and the pattern's
+ * automaton in lockstep with an explicit stack. A child is only entered
+ * if stepping the automaton over its key leaves a live state. Subtrees
+ * whose word lengths the pattern cannot accept, or whose maxFreq cannot
+ * beat the worst of numCompletions matches, are skipped, and a state set
+ * that can only step on one character looks that child up instead of
+ * trying every child. Only nodes with several children to try get a
+ * frame, and a copy of their state set, so a long pattern down a long
+ * chain of nodes does not need a state set per depth.
+ *
+ * Parameter: automaton - the compiled pattern
+ * Parameter: matches - the best matches found so far
+ * Parameter: numCompletions - the most matches to keep
+ */
+void DictionaryTrie::matchPattern( const WildcardPattern & automaton,
+                                   MatchHeap & matches,
+                                   unsigned int numCompletions ) const {
+
+    unsigned int setWords = automaton.setWords();
+    //the state set of the current node, and the one after a step
+    vector<uint64_t> set = vector<uint64_t>( setWords );
+    vector<uint64_t> next = vector<uint64_t>( setWords );
+    //the state set of every frame on the stack, in the same order
+    vector<uint64_t> saved;
+    automaton.start( set.data() );
+
+    vector<WalkFrame> stack;
+    string word;
+    MWTNode* curNode = root;
+    unsigned int depth = 0;
+
+    while( true ) {
+
+        //go down while there is only one child worth trying
+        while( curNode != nullptr ) {
+
+            STATS_ADD( nodesVisited, 1 );
+            //skip the subtree if the lengths of its words and the lengths
+            //the pattern still accepts do not overlap
+            size_t lo;
+            size_t hi;
+            automaton.remaining( set.data(), lo, hi );
+            if( ( curNode->maxLen != LEN_MAX && curNode->maxLen < lo ) ||
+                curNode->minLen > hi ) {
+                break;
+            }
+
+            //skip the subtree if even its best word would not make the cut
+            if( matches.size() == numCompletions &&
+                curNode->maxFreq < matches.top().second ) {
+                break;
+            }
+
+            if( curNode->isEnd && automaton.accepts( set.data() ) ) {
+
+                pair<string, unsigned int> match( word, curNode->freq );
+                STATS_ADD( candidatesCollected, 1 );
+                if( matches.size() < numCompletions ) {
+                    matches.push( match );
+                    STATS_ADD( candidatesSorted, 1 );
+                    STATS_ADD( bytesAllocated, stringHeapBytes( word ) );
+                } else if( compareFreq( match, matches.top() ) ) {
+                    matches.pop();
+                    matches.push( match );
+                    STATS_ADD( candidatesSorted, 1 );
+                    STATS_ADD( bytesAllocated, stringHeapBytes( word ) );
+                }
+
+            }
+
+            int only = automaton.nextChar( set.data() );
+            if( only == -2 || curNode->children.empty() ) {
+                break;
+            }
+
+            //several children can go on, so come back to them later
+            if( only == -1 && curNode->children.size() > 1 ) {
+                stack.push_back( WalkFrame{ curNode, depth, 0,
+                                            curNode->children.begin() } );
+                saved.insert( saved.end(), set.begin(), set.end() );
+                break;
+            }
+
+            //only one key can go on, look it up instead of trying them all
+            char key = only >= 0 ? (char) only :
+                                   curNode->children.begin()->first;
+            curNode = curNode->children.find( key );
+            STATS_ADD( childLookups, 1 );
+            if( curNode == nullptr ||
+                !automaton.step( set.data(), key, next.data() ) ) {
+                break;
+            }
+            set.swap( next );
+            word.push_back( key );
+            depth++;
+
+        }
+
+        if( stack.empty() ) {
+            break;
+        }
+
+        WalkFrame & top = stack.back();
+        if( top.next == top.node->children.end() ) {
+            stack.pop_back();
+            saved.resize( stack.size() * setWords );
+            curNode = nullptr;
+            continue;
+        }
+
+        char key = top.next->first;
+        curNode = nullptr;
+        if( automaton.step( &saved[( stack.size() - 1 ) * setWords], key,
+                            set.data() ) ) {
+            word.resize( top.depth );
+            word.push_back( key );
+            curNode = top.next->second;
+            depth = top.depth + 1;
+        }
+        ++top.next;
+
+    }
+    STATS_ADD( bytesAllocated, ( set.capacity() + next.capacity() +
+                                 saved.capacity() ) * sizeof(uint64_t) +
+                               stack.capacity() * sizeof(WalkFrame) +
+                               stringHeapBytes( word ) );
+
+}
+
+/* Orders the fuzzy queue by distance first, then like CompareEntry */
+bool DictionaryTrie::CompareFuzzy::operator()(
+    const FuzzyEntry & e1, const FuzzyEntry & e2 ) const {
+
+    if( e1.distance != e2.distance ) {
+        return e1.distance > e2.distance;
+    }
+    if( e1.freq != e2.freq ) {
+        return e1.freq < e2.freq;
+    }
+
+    int cmp = e1.word.compare(e2.word);
+    if( cmp != 0 ) {
+        return cmp > 0;
+    }
+
+    //same path: the finished word has to come out before its subtree
+    return !e1.isWord && e2.isWord;
 
 }
 
-/* Comparator method used to sort the list of words and their frequencies.
+/* Comparator method used to rank words and their frequencies.
  * The rule is: The list is sorted from high frequency to low frequency,
  * if multiple words have the same frequency, then they are sorted
  * lexicographically.
@@ -383,16 +1935,16 @@ void DictionaryTrie::getPatterns(
  * Parameter: p1 - the first pair to be compared
  * Parameter: p2 - the second pair to be compared
  */
-bool DictionaryTrie::compareFreq( const pair<string, unsigned int> * p1, 
-                                  const pair<string, unsigned int> * p2 ) {
+bool DictionaryTrie::compareFreq( const pair<string, unsigned int> & p1, 
+                                  const pair<string, unsigned int> & p2 ) {
 
     //if they have same frequency, they will be in alphabetical order
-    if( p1->second == p2->second ) {
+    if( p1.second == p2.second ) {
 
-        return p1->first.compare(p2->first) < 0;
+        return p1.first.compare(p2.first) < 0;
 
     }
 
-    return p2->second < p1->second;
+    return p2.second < p1.second;
 
 }
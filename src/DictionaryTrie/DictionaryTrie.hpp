@@ -9,76 +9,382 @@
  * Author: Christian Kouris 
  * Email: ckouris@ucsd.edu
  * Sources: auto (C++) Microsoft Docs, cplusplus reference unordered_map,
- *          std::vector doc, std::pair doc, std::sort doc, string docs
+ *          std::vector doc, std::pair doc, std::sort doc, string docs,
+ *          std::priority_queue doc
  */
 #ifndef DICTIONARY_TRIE_HPP
 #define DICTIONARY_TRIE_HPP
 
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <queue>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <utility>
 #include <vector>
-#include <unordered_map>
+#include "ChildMap.hpp"
+#include "Dictionary.hpp"
+#include "NodeArena.hpp"
+#include "QueryStats.hpp"
 
 using namespace std;
 
+class WildcardPattern;
+class WorkStealingPool;
+
+/** One query of a batch, answered the way autocomplete answers it: a
+ *  text with an underscore in it is a pattern for predictUnderscores(),
+ *  anything else is a prefix for predictCompletions().
+ */
+struct CompletionQuery {
+    //the prefix or underscore pattern
+    string text;
+    //the max number of results
+    unsigned int numCompletions;
+};
+
+/** The counters of the predictCompletions() result cache */
+struct ResultCacheStats {
+    //queries answered from the cache
+    unsigned long long hits;
+    //queries that had to search the MWT
+    unsigned long long misses;
+    //answers dropped to make room for newer ones
+    unsigned long long evictions;
+    //answers dropped because a word under their prefix changed
+    unsigned long long invalidations;
+    //answers cached right now
+    size_t entries;
+};
+
 /**
  * The class for a dictionary ADT, implemented as either
- * a mulit-way trie or a ternary search tree.
+ * a mulit-way trie or a ternary search tree. This is the multiway trie,
+ * TernarySearchTree is the other backend of the Dictionary interface.
  */
-class DictionaryTrie {
+class DictionaryTrie final : public Dictionary {
   private:
+    //a cursor walks the nodes and reuses the completion search directly
+    friend class CompletionCursor;
+
+    //minLen of a node with no word below it, and the cap of both lengths
+    static const uint16_t LEN_MAX = UINT16_MAX;
+
     /** Inner class which defines a Multiway tree node */
     class MWTNode {
       public:
         //is it the last letter of a word
         bool isEnd;
+        //the fewest and most characters from this node to the end of a
+        //word in its subtree, 0 if this node ends one. A subtree with no
+        //word has minLen LEN_MAX and maxLen 0; a maxLen of LEN_MAX means
+        //LEN_MAX or more.
+        uint16_t minLen;
+        uint16_t maxLen;
         //frequency
         unsigned int freq;
-        //a map that pairs a char to another MWTNode
-        unordered_map<char, MWTNode*> hashMap; 
+        //the highest frequency of any word in this node's subtree
+        unsigned int maxFreq;
+        //index of this word in wordTable, 0 if not assigned
+        unsigned int wordId;
+        //index of this node's list in topKLists, 0 if not assigned
+        unsigned int topKSlot;
+        //a compact map that pairs a char to another MWTNode
+        ChildMap<MWTNode> children; 
         
         MWTNode() {
             isEnd = false;
+            minLen = LEN_MAX;
+            maxLen = 0;
             freq = 0;
-            hashMap = std::unordered_map<char, MWTNode*>();
+            maxFreq = 0;
+            wordId = 0;
+            topKSlot = 0;
         }
     };
 
+    /** An entry in the best-first completion queue. It is either a
+     *  finished word (node is nullptr) or a subtree that still has to be
+     *  expanded, keyed by the subtree's maxFreq.
+     */
+    struct CompletionEntry {
+        //the word's frequency or the subtree's max frequency
+        unsigned int freq;
+        //the word, or the path leading to the subtree
+        string word;
+        //the subtree to expand, nullptr if this entry is a finished word
+        MWTNode* node;
+    };
+
+    /** Orders the completion queue so that the entry popped first is
+     *  the one with the highest frequency, then the lexicographically
+     *  smallest word, and a finished word before a subtree with the same
+     *  path (every word in that subtree is longer than the path).
+     */
+    struct CompareEntry {
+        bool operator()( const CompletionEntry & e1,
+                         const CompletionEntry & e2 ) const;
+    };
+
+    /** An entry in the fuzzy completion queue, a finished word or a
+     *  subtree whose words all start within distance edits of the prefix.
+     */
+    struct FuzzyEntry {
+        //the fewest edits that turn the prefix into a prefix of the words
+        unsigned int distance;
+        //the word's frequency or the subtree's max frequency
+        unsigned int freq;
+        //the word, or the path leading to the subtree
+        string word;
+        //the word's node, or the subtree to expand
+        const MWTNode* node;
+        //is this a finished word rather than a subtree
+        bool isWord;
+    };
+
+    /** Orders the fuzzy queue by distance first, then like CompareEntry */
+    struct CompareFuzzy {
+        bool operator()( const FuzzyEntry & e1,
+                         const FuzzyEntry & e2 ) const;
+    };
+
+    /** A node on the explicit stack of a depth-first walk. The walks
+     *  keep the rest of their state (the word, DP rows, state sets) in
+     *  buffers of their own, so a frame only says where to go next.
+     */
+    struct WalkFrame {
+        MWTNode* node;
+        //the depth of node, the length of the word spelled to it
+        unsigned int depth;
+        //predictFuzzy()'s best distance above node, unused otherwise
+        unsigned int bound;
+        //the next child of node to visit
+        ChildMap<MWTNode>::iterator next;
+    };
+
+    //owns the memory of every node and of their child storage
+    NodeArena arena;
+
     MWTNode* root;
+
+    //size of the per-node top-K lists, 0 when the cache is disabled
+    unsigned int topKSize;
+    //the cached top-K end nodes of every subtree, indexed by topKSlot
+    vector<vector<MWTNode*>> topKLists;
+    //the words referenced by the top-K lists, indexed by wordId
+    vector<string> wordTable;
+
+    //is a sorted bulk load building the trie right now
+    bool bulkActive;
+    //did the current sorted bulk load have to fall back to insert()
+    bool bulkFellBack;
+    //the last word of the sorted bulk load and the nodes spelling it,
+    //starting with the root
+    string bulkLastWord;
+    vector<MWTNode*> bulkPath;
+
+    //are words UTF-8 and do wildcards match whole code points
+    bool utf8;
+
+    //number of threads batches run on, 0 for one per hardware thread
+    unsigned int batchThreads;
+    //the pool batches run on, created by the first batch
+    mutable unique_ptr<WorkStealingPool> batchPool;
+    //guards batchPool, one batch runs at a time
+    mutable mutex batchLock;
+
+    /** A cached answer of predictCompletions() */
+    struct CachedResult {
+        string prefix;
+        unsigned int numCompletions;
+        vector<string> completions;
+    };
+    //the most answers the result cache keeps, 0 when it is off
+    size_t resultCapacity;
+    //the cached answers, most recently used first
+    mutable list<CachedResult> resultLru;
+    //the cached answers of every prefix, one per numCompletions asked
+    mutable unordered_map<string, vector<list<CachedResult>::iterator>>
+        resultIndex;
+    mutable ResultCacheStats resultStats;
+    //guards the result cache, readers share it
+    mutable mutex resultLock;
    
-    /* helper method for the destructor so that we can delete nodes
-     * recursively without having to know the height of the trie 
+    /* Creates a new empty MWTNode in the arena and returns it */
+    MWTNode* newNode();
+   
+    /** The matches of predictUnderscores(), kept to the best K. The
+     *  comparator ranks a better match as smaller, so the worst match
+     *  kept is on top, ready to be replaced.
+     */
+    typedef priority_queue<pair<string, unsigned int>,
+                           vector<pair<string, unsigned int>>,
+                           bool (*)( const pair<string, unsigned int> &,
+                                     const pair<string, unsigned int> & )>
+        MatchHeap;
+
+    /* helper method for insert() which walks down the path of a newly
+     * inserted word and raises the maxFreq of every node on it, including
+     * the root and the word's own node, so it covers the new frequency.
+     * It also widens the minLen and maxLen of every node on the path to
+     * cover the new word's length.
      *
-     * Parameter: node - a pointer to the current node we are deleting
+     * Parameter: word - the word that was just inserted
+     * Parameter: freq - the frequency of the word
      */
-    void deleteNodes( MWTNode* node );
-   
-    /* helper method for predictCompletions(), recurses down all of the
-     * MWTNodes (after prefix) and if there is a valid word, it added the
-     * word along with its frequency to the list passed in.
+    void raisePathBounds( string_view word, unsigned int freq );
+
+    /* Widens the minLen and maxLen of parent to cover the words below
+     * child, which is one character further down.
      *
-     * Parameter: wordList - the list of all the word completions we track
-     * Parameter: curNode - the current node of the recursion
-     * Parameter: curWord - a string of the word built so far
+     * Parameter: parent - the node whose lengths are widened
+     * Parameter: child - a child of parent whose subtree is complete
      */
-    void listWords( vector<pair<string, unsigned int>*> * wordList,
-                    MWTNode* curNode, string curWord );
+    static void widenLengths( MWTNode* parent, const MWTNode* child );
 
-    /* Helper method for predictUnderscores() which recurses down 
-     * the MWT. For each recursion we either recurse down the chracter at
-     * pos or if its an underscore recurse down all characters at pos.
-     * when pos reaches the end of pattern's length, it adds the word
-     * if valid.
+    /* helper method for updateFrequency() which recomputes the maxFreq of
+     * the nodes on a word's path from the bottom up, each from its own
+     * frequency and its children's maxFreq. It stops as soon as a node's
+     * maxFreq comes out unchanged since nothing above it can change then.
      *
-     * Parameter: wordList - a list holding words and their frequencies
-     * Parameter: curNode - the current node in the recursion
-     * Parameter: pattern - the current string pattern
-     * Parameter: pos - the position in the pattern the recursion is at
+     * Parameter: path - the nodes spelling the word, starting with the root
      */
-    void getPatterns( vector<pair<string, unsigned int>*> * wordList,
-                      MWTNode* curNode, string pattern, unsigned int pos );
+    void repairMaxFreq( const vector<MWTNode*> & path );
 
-    /* Comparator method used to sort the list of words and their frequencies.
+    /* helper method for the sorted bulk load which pops nodes off the end
+     * of bulkPath until size nodes are left. A popped node's subtree is
+     * complete, so its maxFreq and lengths are final and are passed up to
+     * its parent.
+     *
+     * Parameter: size - the number of nodes to keep on bulkPath
+     */
+    void popSorted( unsigned int size );
+
+    /* helper method for the sorted bulk load which finishes every node
+     * still on bulkPath, rebuilds the top-K cache if it is on and ends
+     * the bulk load.
+     */
+    void finishSorted();
+
+    /* helper method for memoryBytes() which walks the MWT below node with
+     * an explicit stack and adds up the size of every node and of its
+     * child storage.
+     *
+     * Parameter: node - the root of the subtree to measure
+     */
+    size_t subtreeBytes( const MWTNode* node ) const;
+
+    /* Follows node down while it has no word of its own and only one
+     * child, adding the keys passed to word, and returns where it stops.
+     * Every word below node is below that node too, and no word outside
+     * it can rank between them, so a best-first search may jump straight
+     * there instead of copying the path once per character.
+     *
+     * Parameter: node - the node to start from
+     * Parameter: word - the path to node, extended to the returned node
+     */
+    static MWTNode* skipChain( MWTNode* node, string & word );
+
+    /* The search behind predictCompletions(), without the result cache.
+     *
+     * Parameter: prefix - the prefix of the words to complete
+     * Parameter: numCompletions - the max length of the list of predictions
+     */
+    vector<string> searchCompletions(const string & prefix,
+                                     unsigned int numCompletions) const;
+
+    /* Drops the cached answers of every prefix of word, since changing
+     * word can change each of their lists.
+     *
+     * Parameter: word - the word that was added or changed
+     */
+    void invalidateResults( string_view word );
+
+    /* Drops every cached answer, for changes that touch the whole MWT */
+    void clearResults();
+
+    /* helper method for enableTopKCache() which walks down the MWT with
+     * an explicit stack and gives every node a top-K list and every word
+     * an entry in wordTable. A node's list is filled in when it is popped,
+     * after its children's lists are built.
+     */
+    void buildTopK();
+
+    /* helper method for insert() which fixes the top-K lists on the path
+     * of a newly inserted word, from the word's node back up to the root.
+     *
+     * Parameter: word - the word that was just inserted
+     */
+    void repairTopK( string_view word );
+
+    /* Refills the top-K list of node by merging its own word with the
+     * (already correct) lists of its children. Children are merged in key
+     * order so equal frequencies stay lexicographically ordered.
+     *
+     * Parameter: node - the node whose list is rebuilt
+     */
+    void mergeTopK( MWTNode* node );
+
+    /* Helper method for predictUnderscoresRecursive() which walks down
+     * the MWT with an explicit stack. At each position it either follows
+     * the pattern's character or, for an underscore, every child. When
+     * the walk reaches the end of pattern's length, it adds the word if
+     * valid. Subtrees with no word of the pattern's length, or whose
+     * maxFreq cannot beat the worst of numCompletions matches, are
+     * skipped.
+     *
+     * Parameter: matches - the best matches found so far
+     * Parameter: numCompletions - the most matches to keep
+     * Parameter: pattern - the pattern with underscores
+     */
+    void getPatterns( MatchHeap & matches, unsigned int numCompletions,
+                      const string & pattern ) const;
+
+    /* Helper method for predictFuzzy() which walks the MWT with an
+     * explicit stack, keeping the Levenshtein DP row of the path against
+     * prefix, one row per depth. A node whose path is within maxDistance
+     * edits of the whole prefix, and closer than any node above it, is
+     * added to roots. The walk stops where the smallest value in the row
+     * can no longer beat the best distance on the path.
+     *
+     * Parameter: prefix - the possibly mistyped prefix
+     * Parameter: maxDistance - the most edits allowed on the prefix
+     * Parameter: roots - the subtrees found within the distance
+     */
+    void fuzzyRoots( const string & prefix, unsigned int maxDistance,
+                     vector<FuzzyEntry> & roots ) const;
+
+    /* Runs a compiled pattern over the whole MWT and returns the best
+     * numCompletions matches from high to low frequency, ties in
+     * lexicographic order.
+     *
+     * Parameter: automaton - the compiled pattern
+     * Parameter: numCompletions - the max length of the list of matches
+     */
+    vector<string> runPattern( const WildcardPattern & automaton,
+                               unsigned int numCompletions ) const;
+
+    /* Helper method for runPattern() which walks the MWT and the pattern's
+     * automaton in lockstep with an explicit stack. A child is only entered
+     * if stepping the automaton over its key leaves a live state. Subtrees
+     * whose word lengths the pattern cannot accept, or whose maxFreq cannot
+     * beat the worst of numCompletions matches, are skipped, and a state set
+     * that can only step on one character looks that child up instead of
+     * trying every child. Only nodes with several children to try get a
+     * frame, and a copy of their state set, so a long pattern down a long
+     * chain of nodes does not need a state set per depth.
+     *
+     * Parameter: automaton - the compiled pattern
+     * Parameter: matches - the best matches found so far
+     * Parameter: numCompletions - the most matches to keep
+     */
+    void matchPattern( const WildcardPattern & automaton, MatchHeap & matches,
+                       unsigned int numCompletions ) const;
+
+    /* Comparator method used to rank words and their frequencies.
      * The rule is: The list is sorted from high frequency to low frequency,
      * if multiple words have the same frequency, then they are sorted
      * lexicographically.
@@ -86,8 +392,8 @@ class DictionaryTrie {
      * Parameter: p1 - the first pair to be compared
      * Parameter: p2 - the second pair to be compared
      */
-    static bool compareFreq( const pair<string, unsigned int> * p1, 
-                             const pair<string, unsigned int> * p2 );
+    static bool compareFreq( const pair<string, unsigned int> & p1, 
+                             const pair<string, unsigned int> & p2 );
     
   public:
     /* Default constructor for the DictionaryTrie class which is a MultiWay
@@ -97,12 +403,33 @@ class DictionaryTrie {
 
     /* Insterts a new node into the MWT using the information of "word" and
      * "freq" and returns true if successful. If the string is already in the
-     * MWT, the function inserts noting and returns false.
+     * MWT, the function inserts noting and returns false. The word is
+     * taken as a view, so loaders can pass slices of their read buffer.
+     * In UTF-8 mode a word that is not valid UTF-8 is refused too.
      * 
      * Parameter: word - the word string we are inserting into the MWT
      * Parameter: freq - the frequency of the word
      */
-    bool insert(string word, unsigned int freq);
+    bool insert(string_view word, unsigned int freq) override;
+
+    /* Changes the frequency of a word that is already in the MWT and
+     * returns true, or returns false if the word is not in the MWT. Only
+     * the word's path is repaired (maxFreq and the top-K lists), so the
+     * cost depends on the length of the word, not the size of the MWT.
+     *
+     * Parameter: word - the word whose frequency changes
+     * Parameter: freq - the new frequency of the word
+     */
+    bool updateFrequency(string_view word, unsigned int freq);
+
+    /* Adds delta to the frequency of a word that is already in the MWT,
+     * stopping at the largest unsigned int instead of wrapping around.
+     * Returns false if the word is not in the MWT.
+     *
+     * Parameter: word - the word whose frequency changes
+     * Parameter: delta - the amount to add to the word's frequency
+     */
+    bool incrementFrequency(string_view word, unsigned int delta = 1);
 
     /* Searches to see if a word is in the MWT. If the word is in the
      * trie, the function will return true. If the word is not in the trie,
@@ -110,33 +437,268 @@ class DictionaryTrie {
      *
      * Prameter: word - the string we are looking for in the MWT
      */
-    bool find(string word) const;
+    bool find(string word) const override;
 
     /* This function returns a list of predicted completions of the prefix
      * passed into the function up to an amount of numCompletions in order
      * of high to low frequency. If two words have the same frequency, then
-     * they are ordered lexicographically.
+     * they are ordered lexicographically. The search is best-first on the
+     * subtree maxFreq values, so it stops once numCompletions words are
+     * final instead of visiting every word below the prefix. If the top-K
+     * cache holds at least numCompletions words, it is copied instead.
+     * With the result cache on, a repeated query is answered from it.
      *
      * Parameter: prefix - a string that we will return all its completions
      * Parameter: numCompletions - the max length of the list of predictions
      */
     vector<string> predictCompletions(string prefix,
-                                      unsigned int numCompletions);
+                                      unsigned int numCompletions) const
+        override;
+
+    /** A caller owned, reusable buffer for the allocation free
+     *  predictCompletions(). The words are written back to back into one
+     *  character buffer and read out as views; the search's frontier and
+     *  paths live here too. Nothing is freed between queries, so once the
+     *  buffer has grown to fit the queries it sees, a query allocates
+     *  nothing. The views stay valid until the buffer is used again.
+     */
+    class CompletionBuffer {
+      private:
+        friend class DictionaryTrie;
+
+        /** A frontier entry whose path is a slice of paths */
+        struct PathEntry {
+            //the word's frequency or the subtree's max frequency
+            unsigned int freq;
+            //where the word or the path to the subtree is in paths
+            size_t offset;
+            size_t length;
+            //the subtree to expand, nullptr if this entry is a finished word
+            MWTNode* node;
+        };
+
+        //the result words, back to back
+        string words;
+        //the offset and length of every result word in words
+        vector<pair<size_t, size_t>> spans;
+        //the paths of the frontier entries, back to back
+        string paths;
+        //the best-first frontier, a heap
+        vector<PathEntry> frontier;
+
+      public:
+        /* Returns the number of words in the buffer */
+        size_t size() const;
+
+        /* Returns the i-th word, valid until the buffer is used again
+         *
+         * Parameter: i - the index of the word, less than size()
+         */
+        string_view operator[]( size_t i ) const;
+
+        /* Empties the buffer but keeps its memory for the next query */
+        void clear();
+
+        /* Returns the number of heap bytes the buffer holds on to */
+        size_t bytes() const;
+    };
+
+    /* Same as predictCompletions() but the words go into out, which is
+     * emptied first, and nothing is allocated once out has grown big
+     * enough from earlier queries. The result cache is not used here,
+     * since filling it allocates.
+     *
+     * Parameter: prefix - a string that we will return all its completions
+     * Parameter: numCompletions - the max length of the list of predictions
+     * Parameter: out - the buffer the predictions are written to
+     */
+    void predictCompletions(string_view prefix, unsigned int numCompletions,
+                            CompletionBuffer & out) const;
 
     /* This function takes in a string pattern which most likely contians
      * underscores. These undrscores can be any character in the words that
      * we will return. We will return all predictions for the pattern with 
      * underscore wildcards up to a numCompletions number from high to low
-     * frequency.
+     * frequency. Only the best numCompletions matches are kept, and
+     * subtrees without a word of the pattern's length are never entered.
+     * It runs on the same pattern engine as predictWildcards().
      *
      * Parameter: pattern - a word that contains underscores as wildcard chars
      * Parameter: numCompletions - the max length of the list of predictions
      */
     vector<string> predictUnderscores(string pattern,
-                                      unsigned int numCompletions);
+                                      unsigned int numCompletions) const
+        override;
+
+    /* The character by character matcher predictUnderscores() used before
+     * the pattern engine (it walks with an explicit stack now, the name is
+     * from when it recursed). Same results, kept as the reference the
+     * engine is tested and benchmarked against.
+     *
+     * Parameter: pattern - a word that contains underscores as wildcard chars
+     * Parameter: numCompletions - the max length of the list of predictions
+     */
+    vector<string> predictUnderscoresRecursive(string pattern,
+                                               unsigned int numCompletions)
+        const;
+
+    /* Returns up to numCompletions words matching a wildcard pattern, from
+     * high to low frequency and lexicographically for equal frequencies.
+     * The pattern has to match the whole word: _ or ? is any character,
+     * * is any run of characters, [abc] and [^abc] are character classes
+     * with a-z ranges, and a backslash makes the next character literal
+     * (see WildcardPattern). A malformed pattern matches nothing.
+     *
+     * Parameter: pattern - the wildcard pattern
+     * Parameter: numCompletions - the max length of the list of matches
+     */
+    vector<string> predictWildcards(const string & pattern,
+                                    unsigned int numCompletions) const;
+
+    /* Typo tolerant version of predictCompletions(). Returns up to
+     * numCompletions words that start with something at most maxDistance
+     * edits (insertions, deletions or substitutions) away from prefix.
+     * Words needing fewer edits come first, then higher frequencies, then
+     * lexicographic order, so a maxDistance of 0 gives the same list as
+     * predictCompletions(). Meant for a maxDistance of 1 or 2; the work
+     * grows quickly beyond that.
+     *
+     * Parameter: prefix - the possibly mistyped prefix
+     * Parameter: numCompletions - the max length of the list of predictions
+     * Parameter: maxDistance - the most edits allowed on the prefix
+     */
+    vector<string> predictFuzzy(const string & prefix,
+                                unsigned int numCompletions,
+                                unsigned int maxDistance) const;
+
+    /* Answers a whole batch of queries on the batch thread pool and
+     * returns the results in the order of the queries. Each result is
+     * the same as a single predictCompletions() or predictUnderscores()
+     * call would give. Do not change the MWT while a batch runs.
+     *
+     * Parameter: queries - the first query of the batch
+     * Parameter: numQueries - the number of queries in the batch
+     */
+    vector<vector<string>> predictBatch(const CompletionQuery* queries,
+                                        size_t numQueries) const;
+
+    /* Sets the number of threads predictBatch() runs on, the calling
+     * thread included. 0, the default, means one per hardware thread.
+     *
+     * Parameter: numThreads - the number of threads batches run on
+     */
+    void setBatchThreads(unsigned int numThreads);
+
+    /* Turns UTF-8 mode on or off. In UTF-8 mode insert() and
+     * appendSorted() refuse words that are not valid UTF-8, and the
+     * wildcards of predictUnderscores() and predictWildcards() match one
+     * whole code point instead of one byte, so every result is valid
+     * UTF-8 too. The MWT stays keyed on bytes, a code point is a path of
+     * 1 to 4 nodes. Turn it on before loading, words already in the MWT
+     * are not checked. predictFuzzy() still counts edits in bytes.
+     *
+     * Parameter: enabled - should the MWT be in UTF-8 mode
+     */
+    void setUtf8(bool enabled);
+
+    /* Returns true if the MWT is in UTF-8 mode */
+    bool isUtf8() const;
+
+    /* Turns on the precomputed top-K completion cache. Every node keeps
+     * the k most frequent words of its subtree, so predictCompletions()
+     * with numCompletions <= k is a prefix walk plus a copy. The lists are
+     * built here, so call it after bulk loading; insert() keeps them
+     * correct afterwards. Passing 0 turns the cache off.
+     *
+     * Parameter: k - the number of completions cached at every node
+     */
+    void enableTopKCache( unsigned int k );
+
+    /* Turns on a cache of whole predictCompletions() answers, keyed by
+     * the prefix and numCompletions, that keeps the capacity most
+     * recently used ones. It pays off when a few hot prefixes make up
+     * most of the queries. insert() and the frequency updates drop the
+     * answers of every prefix of the word they change. Readers on many
+     * threads can share it. Passing 0 turns the cache off.
+     *
+     * Parameter: capacity - the most answers to keep
+     */
+    void enableResultCache( size_t capacity );
+
+    /* Returns the hit, miss, eviction and invalidation counters of the
+     * result cache and its current number of entries.
+     */
+    ResultCacheStats resultCacheStats() const;
+
+    /* Returns the number of bytes used by the top-K cache (the lists and
+     * the word table they reference), 0 if the cache is disabled.
+     */
+    size_t topKCacheBytes() const;
+
+    /* Returns the number of bytes used by the nodes of the MWT and their
+     * child storage, not counting the top-K cache.
+     */
+    size_t memoryBytes() const override;
+
+    /* Returns the number of nodes in the MWT, the root included */
+    size_t nodeCount() const override;
+
+    /* Walks the MWT and returns its node and word counts, the depth and
+     * fan-out histograms of its nodes and the memory used by each part.
+     */
+    TrieStats trieStats() const;
+
+    /* Starts a bulk load of words that come in sorted (byte) order. Only
+     * the path of the last word is kept: every new word shares a prefix
+     * with it, the rest of the last path is complete and finalized, and
+     * the new word's nodes are appended after it without any lookups.
+     * If the MWT is not empty the bulk load just uses insert(). Do not
+     * call insert() until endSorted().
+     */
+    void beginSorted();
+
+    /* Adds the next word of a sorted bulk load, same return value as
+     * insert(). A word that is out of order makes the rest of the bulk
+     * load fall back to insert(), so the result is always correct.
+     *
+     * Parameter: word - the word string we are inserting into the MWT
+     * Parameter: freq - the frequency of the word
+     */
+    bool appendSorted(string_view word, unsigned int freq);
+
+    /* Ends a sorted bulk load. Returns true if every word came in order,
+     * false if the bulk load had to fall back to insert().
+     */
+    bool endSorted();
+
+    /* Moves every word of shard into this MWT by hanging the subtrees
+     * under shard's root directly off this root and taking over shard's
+     * arena, without copying a node. This is how the shards of a parallel
+     * build are stitched together. It only works if both are in the same
+     * UTF-8 mode and no first character of shard is already a child of
+     * this root; otherwise nothing is moved and false is returned. shard
+     * is left empty.
+     *
+     * Parameter: shard - the MWT whose words are moved into this one
+     */
+    bool absorb( DictionaryTrie & shard );
+
+    /* Writes the MWT to fileName as a position independent binary image
+     * that DictionarySnapshot can mmap and query without rebuilding the
+     * trie. The top-K cache is not part of the image. Returns false if
+     * the file could not be written.
+     *
+     * Parameter: fileName - the file to write the snapshot to
+     */
+    bool writeSnapshot( const string & fileName ) const;
+
+    /* Returns the number of bytes the node arena has allocated from the
+     * system, including slack in its slabs and recycled blocks.
+     */
+    size_t arenaBytes() const;
 
-    /* Standard destructor for the MWT class. It recurses down to all the 
-     * leaves and deletes up to the root
+    /* Standard destructor for the MWT class. The nodes live in the arena,
+     * so they are freed slab by slab without walking the trie.
      */
     ~DictionaryTrie();
 };
@@ -0,0 +1,143 @@
+/**
+ * The purpose of this cpp file is to provide implementation for the
+ * methods of the NodeArena class, the slab allocator that backs the
+ * nodes of the trie and their child storage.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: cplusplus reference operator new, placement new
+ */
+#include "NodeArena.hpp"
+#include <new>
+
+/* Creates an empty arena, no memory is taken until the first block */
+NodeArena::NodeArena() {
+
+    bumpPtr = nullptr;
+    bumpEnd = nullptr;
+    for( size_t i = 0; i <= MAX_RECYCLED / ALIGN; i++ ) {
+        freeLists[i] = nullptr;
+    }
+    allocated = 0;
+    inUse = 0;
+
+}
+
+/* Returns a block of at least the given number of bytes, aligned for
+ * pointers. It is reused from a free list when one of the same size
+ * was given back.
+ *
+ * Parameter: bytes - the size of the block
+ */
+void* NodeArena::allocate( size_t bytes ) {
+
+    bytes = roundUp( bytes == 0 ? 1 : bytes );
+    inUse += bytes;
+
+    //first try a block that was given back
+    if( bytes <= MAX_RECYCLED && freeLists[bytes / ALIGN] != nullptr ) {
+
+        void* block = freeLists[bytes / ALIGN];
+        freeLists[bytes / ALIGN] = *(void**) block;
+        return block;
+
+    }
+
+    //blocks bigger than a quarter slab get a slab of their own
+    if( bytes > SLAB_SIZE / 4 ) {
+        return newSlab( bytes );
+    }
+
+    if( bumpPtr == nullptr || (size_t) ( bumpEnd - bumpPtr ) < bytes ) {
+        bumpPtr = newSlab( SLAB_SIZE );
+        bumpEnd = bumpPtr + SLAB_SIZE;
+    }
+    void* block = bumpPtr;
+    bumpPtr += bytes;
+    return block;
+
+}
+
+/* Gives a block back so a later allocate() of the same size can reuse
+ * it. The memory itself stays with the arena until it is destroyed.
+ *
+ * Parameter: block - a block returned by allocate()
+ * Parameter: bytes - the size that was passed to allocate()
+ */
+void NodeArena::release( void* block, size_t bytes ) {
+
+    if( block == nullptr ) {
+        return;
+    }
+    bytes = roundUp( bytes == 0 ? 1 : bytes );
+    inUse -= bytes;
+
+    //the free list link is stored in the block itself
+    if( bytes <= MAX_RECYCLED ) {
+        *(void**) block = freeLists[bytes / ALIGN];
+        freeLists[bytes / ALIGN] = block;
+    }
+
+}
+
+/* Takes over every slab of other, so whatever was allocated from other
+ * now lives (and dies) with this arena. other is left empty and can
+ * be used again.
+ *
+ * Parameter: other - the arena to take the slabs from
+ */
+void NodeArena::absorb( NodeArena & other ) {
+
+    slabs.insert( slabs.end(), other.slabs.begin(), other.slabs.end() );
+    allocated += other.allocated;
+    inUse += other.inUse;
+
+    //other's free blocks and the rest of its bump slab are not reused
+    other.slabs.clear();
+    other.bumpPtr = nullptr;
+    other.bumpEnd = nullptr;
+    for( size_t i = 0; i <= MAX_RECYCLED / ALIGN; i++ ) {
+        other.freeLists[i] = nullptr;
+    }
+    other.allocated = 0;
+    other.inUse = 0;
+
+}
+
+/* Returns the number of bytes the arena got from the system */
+size_t NodeArena::bytesAllocated() const {
+
+    return allocated;
+
+}
+
+/* Returns the number of bytes currently handed out */
+size_t NodeArena::bytesInUse() const {
+
+    return inUse;
+
+}
+
+/* Gets a new slab of the given size from the system and returns it.
+ *
+ * Parameter: bytes - the size the slab has to hold
+ */
+char* NodeArena::newSlab( size_t bytes ) {
+
+    char* slab = (char*) ::operator new( bytes );
+    slabs.push_back( slab );
+    allocated += bytes;
+    return slab;
+
+}
+
+/* Frees every slab at once. Nothing allocated from the arena has its
+ * destructor run, so only trivially destructible data goes in here.
+ */
+NodeArena::~NodeArena() {
+
+    for( unsigned int i = 0; i < slabs.size(); i++ ) {
+        ::operator delete( slabs[i] );
+    }
+
+}
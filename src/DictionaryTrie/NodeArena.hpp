@@ -0,0 +1,96 @@
+/**
+ * The purpose of this hpp file is to define the NodeArena class, a slab
+ * allocator that hands out the memory for the nodes of a trie and for
+ * their child storage. Memory comes from large contiguous slabs with a
+ * bump pointer, blocks given back while the trie grows are kept on free
+ * lists by size so they can be reused, and everything is released in
+ * bulk when the arena is destroyed instead of one node at a time.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: cplusplus reference operator new, placement new
+ */
+#ifndef NODE_ARENA_HPP
+#define NODE_ARENA_HPP
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+class NodeArena {
+  private:
+    //every block is rounded up to a multiple of this
+    static const size_t ALIGN = sizeof(void*);
+    //the size of a regular slab
+    static const size_t SLAB_SIZE = 64 * 1024;
+    //blocks up to this size are recycled through the free lists
+    static const size_t MAX_RECYCLED = 4096;
+
+    //every slab this arena got from the system
+    vector<char*> slabs;
+    //the next free byte of the current slab and the end of that slab
+    char* bumpPtr;
+    char* bumpEnd;
+    //heads of the free lists, one per multiple of ALIGN
+    void* freeLists[MAX_RECYCLED / ALIGN + 1];
+    //total bytes of all slabs
+    size_t allocated;
+    //bytes handed out and not given back
+    size_t inUse;
+
+    /* Rounds bytes up to the arena's alignment */
+    static size_t roundUp( size_t bytes ) {
+        return ( bytes + ALIGN - 1 ) / ALIGN * ALIGN;
+    }
+
+    /* Gets a new slab of the given size from the system and returns it.
+     *
+     * Parameter: bytes - the size the slab has to hold
+     */
+    char* newSlab( size_t bytes );
+
+  public:
+    /* Creates an empty arena, no memory is taken until the first block */
+    NodeArena();
+
+    NodeArena( const NodeArena & other ) = delete;
+    NodeArena & operator=( const NodeArena & other ) = delete;
+
+    /* Returns a block of at least the given number of bytes, aligned for
+     * pointers. It is reused from a free list when one of the same size
+     * was given back.
+     *
+     * Parameter: bytes - the size of the block
+     */
+    void* allocate( size_t bytes );
+
+    /* Gives a block back so a later allocate() of the same size can reuse
+     * it. The memory itself stays with the arena until it is destroyed.
+     *
+     * Parameter: block - a block returned by allocate()
+     * Parameter: bytes - the size that was passed to allocate()
+     */
+    void release( void* block, size_t bytes );
+
+    /* Takes over every slab of other, so whatever was allocated from other
+     * now lives (and dies) with this arena. other is left empty and can
+     * be used again.
+     *
+     * Parameter: other - the arena to take the slabs from
+     */
+    void absorb( NodeArena & other );
+
+    /* Returns the number of bytes the arena got from the system */
+    size_t bytesAllocated() const;
+
+    /* Returns the number of bytes currently handed out */
+    size_t bytesInUse() const;
+
+    /* Frees every slab at once. Nothing allocated from the arena has its
+     * destructor run, so only trivially destructible data goes in here.
+     */
+    ~NodeArena();
+};
+
+#endif  // NODE_ARENA_HPP
@@ -0,0 +1,64 @@
+/**
+ * The purpose of this cpp file is to provide implementation for the
+ * methods of QueryStats and TrieStats and to hold the per thread
+ * counters the query macros write to.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: thread_local storage duration docs
+ */
+#include "QueryStats.hpp"
+
+#ifdef DICTIONARY_TRIE_STATS
+thread_local QueryStats currentQueryStats;
+#endif
+
+/* Writes the counters on one line
+ *
+ * Parameter: out - the stream to write to
+ */
+void QueryStats::print( ostream & out ) const {
+
+    out << "nodes " << nodesVisited << ", lookups " << childLookups
+        << ", collected " << candidatesCollected << ", sorted "
+        << candidatesSorted << ", bytes " << bytesAllocated
+        << ", walk " << walkNanoseconds << " ns, collect "
+        << collectNanoseconds << " ns, sort " << sortNanoseconds << " ns";
+    if( topKCacheHit ) {
+        out << ", top-K cache hit";
+    }
+    if( resultCacheHit ) {
+        out << ", result cache hit";
+    }
+
+}
+
+/* Writes the counts, the memory and both histograms
+ *
+ * Parameter: out - the stream to write to
+ */
+void TrieStats::print( ostream & out ) const {
+
+    out << "nodes: " << nodes << ", words: " << words << "\n";
+    out << "memory: nodes " << nodeBytes << " B, child maps "
+        << childMapBytes << " B, arena " << arenaBytes << " B, top-K cache "
+        << topKCacheBytes << " B, result cache " << resultCacheBytes
+        << " B\n";
+
+    out << "nodes by depth:";
+    for( size_t d = 0; d < depthHistogram.size(); d++ ) {
+        if( depthHistogram[d] != 0 ) {
+            out << " " << d << ":" << depthHistogram[d];
+        }
+    }
+    out << "\n";
+
+    out << "nodes by fan-out:";
+    for( size_t c = 0; c < fanOutHistogram.size(); c++ ) {
+        if( fanOutHistogram[c] != 0 ) {
+            out << " " << c << ":" << fanOutHistogram[c];
+        }
+    }
+    out << "\n";
+
+}
@@ -0,0 +1,167 @@
+/**
+ * The purpose of this hpp file is to define QueryStats, the counters of
+ * the work a single dictionary query did, the macros the queries
+ * count with, and TrieStats, the shape and memory use of a whole trie.
+ * The query counters are only kept when the library is built with
+ * DICTIONARY_TRIE_STATS defined (meson configure -Dquery_stats=true).
+ * Otherwise every macro expands to nothing and a query does exactly the
+ * work it would without this file.
+ *
+ * The counters of the last query are kept per thread, so queries running
+ * on different threads do not mix their counts.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: std::chrono doc, thread_local storage duration docs
+ */
+#ifndef QUERY_STATS_HPP
+#define QUERY_STATS_HPP
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/** The work one find(), predictCompletions(), predictUnderscores() or
+ *  predictWildcards() call did, on any backend. All zero unless the
+ *  library was built with DICTIONARY_TRIE_STATS.
+ */
+struct QueryStats {
+#ifdef DICTIONARY_TRIE_STATS
+    static constexpr bool ENABLED = true;
+#else
+    static constexpr bool ENABLED = false;
+#endif
+
+    //nodes the query stepped onto or expanded
+    unsigned long long nodesVisited;
+    //children looked up by key, the walk down a prefix or a pattern's
+    //literal characters
+    unsigned long long childLookups;
+    //words that were offered as an answer
+    unsigned long long candidatesCollected;
+    //entries pushed through the queue or heap that orders the answers
+    unsigned long long candidatesSorted;
+    //heap bytes asked for by the words, queues and lists the query built
+    //(containers are counted at the size they grew to)
+    unsigned long long bytesAllocated;
+    //was the answer copied from the top-K cache
+    bool topKCacheHit;
+    //was the answer taken from the result cache
+    bool resultCacheHit;
+
+    //time getting to the words: down the prefix, or the whole lockstep
+    //walk of a pattern
+    long long walkNanoseconds;
+    //time gathering the best words below the prefix
+    long long collectNanoseconds;
+    //time putting gathered matches in order
+    long long sortNanoseconds;
+
+    QueryStats()
+        : nodesVisited(0), childLookups(0), candidatesCollected(0),
+          candidatesSorted(0), bytesAllocated(0), topKCacheHit(false),
+          resultCacheHit(false), walkNanoseconds(0), collectNanoseconds(0),
+          sortNanoseconds(0) {}
+
+    /* Writes the counters on one line
+     *
+     * Parameter: out - the stream to write to
+     */
+    void print( ostream & out ) const;
+};
+
+/** The shape and memory use of a DictionaryTrie, from trieStats(). These
+ *  are worked out on demand by walking the trie, so they do not depend on
+ *  DICTIONARY_TRIE_STATS.
+ */
+struct TrieStats {
+    //number of nodes, the root included
+    size_t nodes;
+    //number of words
+    size_t words;
+    //depthHistogram[d] is the number of nodes d keys below the root
+    vector<size_t> depthHistogram;
+    //fanOutHistogram[c] is the number of nodes with c children
+    vector<size_t> fanOutHistogram;
+
+    //bytes of the nodes themselves
+    size_t nodeBytes;
+    //bytes of the nodes' child storage
+    size_t childMapBytes;
+    //bytes the node arena took from the system, the two above plus slack
+    size_t arenaBytes;
+    //bytes of the top-K cache lists and word table
+    size_t topKCacheBytes;
+    //bytes of the answers in the result cache
+    size_t resultCacheBytes;
+
+    /* Writes the counts, the memory and both histograms
+     *
+     * Parameter: out - the stream to write to
+     */
+    void print( ostream & out ) const;
+};
+
+/* Returns the heap bytes a string owns, 0 if it fits in its small
+ * string buffer.
+ *
+ * Parameter: word - the string to measure
+ */
+inline size_t stringHeapBytes( const string & word ) {
+    return word.capacity() > string().capacity() ? word.capacity() + 1 : 0;
+}
+
+#ifdef DICTIONARY_TRIE_STATS
+
+//the counters of the query running on (or last run on) this thread
+extern thread_local QueryStats currentQueryStats;
+
+/** Adds the time from its creation to stop(), or to the end of its
+ *  scope, to one of the phase counters.
+ */
+class PhaseTimer {
+  private:
+    long long & counter;
+    chrono::steady_clock::time_point start;
+    bool running;
+
+  public:
+    explicit PhaseTimer( long long & counter )
+        : counter(counter), start(chrono::steady_clock::now()),
+          running(true) {}
+
+    PhaseTimer( const PhaseTimer & other ) = delete;
+    PhaseTimer & operator=( const PhaseTimer & other ) = delete;
+
+    void stop() {
+        if( running ) {
+            counter += chrono::duration_cast<chrono::nanoseconds>(
+                           chrono::steady_clock::now() - start ).count();
+            running = false;
+        }
+    }
+
+    ~PhaseTimer() { stop(); }
+};
+
+#define STATS_RESET() ( currentQueryStats = QueryStats() )
+#define STATS_ADD( counter, n ) ( currentQueryStats.counter += ( n ) )
+#define STATS_FLAG( flag ) ( currentQueryStats.flag = true )
+#define STATS_PHASE( phase ) \
+    PhaseTimer phase##Timer( currentQueryStats.phase##Nanoseconds )
+#define STATS_PHASE_END( phase ) phase##Timer.stop()
+
+#else
+
+#define STATS_RESET() ( (void) 0 )
+#define STATS_ADD( counter, n ) ( (void) 0 )
+#define STATS_FLAG( flag ) ( (void) 0 )
+#define STATS_PHASE( phase ) ( (void) 0 )
+#define STATS_PHASE_END( phase ) ( (void) 0 )
+
+#endif  // DICTIONARY_TRIE_STATS
+
+#endif  // QUERY_STATS_HPP
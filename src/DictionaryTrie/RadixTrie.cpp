@@ -0,0 +1,395 @@
+/**
+ * The purpose of this cpp file is to provide implementation for the
+ * methods of the RadixTrie class. Every walk goes down the trie with a
+ * loop or an explicit stack, and a label is compared with memcmp rather
+ * than one node per character.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: Morrison "PATRICIA - Practical Algorithm To Retrieve
+ *          Information Coded in Alphanumeric", std::priority_queue doc
+ */
+#include "RadixTrie.hpp"
+#include <cstring>
+#include <new>
+#include "QueryStats.hpp"
+
+/* Creates an empty radix trie */
+RadixTrie::RadixTrie() : numNodes(0) {
+
+    root = newNode( string_view() );
+
+}
+
+/* Creates a node in the arena whose label is a copy of label and returns
+ * it. The label goes right behind the node in the same block, so reading
+ * a node's label rarely touches another cache line.
+ *
+ * Parameter: label - the characters of the edge into the node
+ */
+RadixTrie::RadixNode* RadixTrie::newNode( string_view label ) {
+
+    numNodes++;
+    char* block = (char*) arena.allocate( sizeof(RadixNode) + label.size() );
+    char* text = block + sizeof(RadixNode);
+    if( !label.empty() ) {
+        memcpy( text, label.data(), label.size() );
+    }
+    return new ( block ) RadixNode( text, label.size() );
+
+}
+
+/* Inserts word with the given frequency and returns true, or returns
+ * false if the word is empty or already in the trie. An edge the word
+ * leaves in its middle is split in two.
+ *
+ * Parameter: word - the word to insert
+ * Parameter: freq - the frequency of the word
+ */
+bool RadixTrie::insert( string_view word, unsigned int freq ) {
+
+    if( word.size() < 1 ) {
+        return false;
+    }
+
+    //a duplicate only shows once the whole word is matched, and its path
+    //already existed, so the walk has changed nothing when it gives up
+    insertPath.clear();
+    RadixNode* curNode = root;
+    size_t i = 0;
+    while( true ) {
+
+        insertPath.push_back( curNode );
+        if( i == word.size() ) {
+            if( curNode->isEnd ) {
+                return false;
+            }
+            curNode->isEnd = true;
+            curNode->freq = freq;
+            break;
+        }
+
+        //no edge starts with the next character, the rest of the word
+        //becomes one leaf
+        RadixNode* child = curNode->children.find( word[i] );
+        if( child == nullptr ) {
+            RadixNode* leaf = newNode( word.substr( i ) );
+            leaf->isEnd = true;
+            leaf->freq = freq;
+            leaf->maxFreq = freq;
+            curNode->children.insert( word[i], leaf, arena );
+            break;
+        }
+
+        //how much of the edge the word follows
+        size_t common = 0;
+        while( common < child->labelLen && i + common < word.size() &&
+               child->label[common] == word[i + common] ) {
+            common++;
+        }
+
+        //the word leaves the edge in its middle: the part it follows
+        //becomes a new node above the child, which keeps the rest
+        if( common < child->labelLen ) {
+            RadixNode* split = newNode( string_view() );
+            split->label = child->label;
+            split->labelLen = common;
+            split->maxFreq = child->maxFreq;
+            child->label += common;
+            child->labelLen -= common;
+            split->children.insert( child->label[0], child, arena );
+            curNode->children.replace( word[i], split );
+            child = split;
+        }
+
+        curNode = child;
+        i += common;
+
+    }
+
+    //every node passed has the new word in its subtree, so its maxFreq
+    //covers it
+    for( RadixNode* node : insertPath ) {
+        if( freq > node->maxFreq ) {
+            node->maxFreq = freq;
+        }
+    }
+    return true;
+
+}
+
+/* Returns true if word is in the trie
+ *
+ * Parameter: word - the word to look for
+ */
+bool RadixTrie::find( string word ) const {
+
+    if( word.size() < 1 ) {
+        return false;
+    }
+    STATS_RESET();
+    const RadixNode* curNode = root;
+    size_t i = 0;
+    while( i < word.size() ) {
+
+        curNode = curNode->children.find( word[i] );
+        STATS_ADD( childLookups, 1 );
+        STATS_ADD( nodesVisited, curNode != nullptr );
+        if( curNode == nullptr ||
+            curNode->labelLen > word.size() - i ||
+            memcmp( curNode->label, word.data() + i,
+                    curNode->labelLen ) != 0 ) {
+            return false;
+        }
+        i += curNode->labelLen;
+
+    }
+    return curNode->isEnd;
+
+}
+
+/* Returns the node whose subtree holds exactly the words that start with
+ * prefix, nullptr if there are none. prefix may end in the middle of the
+ * edge into that node. path is set to the word spelled down to the end of
+ * the node's label.
+ *
+ * Parameter: prefix - the prefix to look for
+ * Parameter: path - set to the path of the returned node
+ */
+const RadixTrie::RadixNode* RadixTrie::findPrefix( string_view prefix,
+                                                   string & path ) const {
+
+    path.clear();
+    const RadixNode* curNode = root;
+    STATS_ADD( nodesVisited, 1 );
+    size_t i = 0;
+    while( i < prefix.size() ) {
+
+        curNode = curNode->children.find( prefix[i] );
+        STATS_ADD( childLookups, 1 );
+        if( curNode == nullptr ) {
+            return nullptr;
+        }
+        STATS_ADD( nodesVisited, 1 );
+
+        //only the part of the label the prefix covers has to match
+        size_t n = curNode->labelLen;
+        if( n > prefix.size() - i ) {
+            n = prefix.size() - i;
+        }
+        if( memcmp( curNode->label, prefix.data() + i, n ) != 0 ) {
+            return nullptr;
+        }
+        path.append( curNode->label, curNode->labelLen );
+        i += curNode->labelLen;
+
+    }
+    return curNode;
+
+}
+
+/* Returns up to numCompletions words that start with prefix, from high
+ * to low frequency and lexicographically among equal ones. The search is
+ * best-first on the subtree maxFreq values, so it stops once
+ * numCompletions words are final.
+ *
+ * Parameter: prefix - the prefix of the words to return
+ * Parameter: numCompletions - the max length of the list of predictions
+ */
+vector<string> RadixTrie::predictCompletions(
+    string prefix, unsigned int numCompletions ) const {
+
+    STATS_RESET();
+    vector<string> completionList = vector<string>();
+    if( numCompletions == 0 ) {
+        return completionList;
+    }
+
+    string path;
+    const RadixNode* node = findPrefix( prefix, path );
+    if( node == nullptr ) {
+        return completionList;
+    }
+
+    priority_queue<CompletionEntry, vector<CompletionEntry>, CompareEntry>
+        frontier;
+    frontier.push( CompletionEntry{ node->maxFreq, std::move( path ),
+                                    node } );
+
+    //loop until we have numCompletions words or nothing is left to expand
+    while( completionList.size() < numCompletions && !frontier.empty() ) {
+
+        CompletionEntry entry = frontier.top();
+        frontier.pop();
+
+        //a finished word can go straight into the list
+        if( entry.node == nullptr ) {
+            completionList.push_back( std::move( entry.word ) );
+            STATS_ADD( candidatesCollected, 1 );
+            continue;
+        }
+
+        //the node's own word, then every child one label further
+        node = entry.node;
+        STATS_ADD( nodesVisited, 1 );
+        if( node->isEnd ) {
+            frontier.push( CompletionEntry{ node->freq, entry.word,
+                                            nullptr } );
+        }
+        for( auto iterator = node->children.begin();
+             iterator != node->children.end(); iterator++ ) {
+            const RadixNode* child = iterator->second;
+            string word = entry.word;
+            word.append( child->label, child->labelLen );
+            frontier.push( CompletionEntry{ child->maxFreq,
+                                            std::move( word ), child } );
+        }
+
+    }
+
+    return completionList;
+
+}
+
+/* Returns up to numCompletions words of the same length as pattern that
+ * match it, an underscore matching any one character, ordered like
+ * predictCompletions(). A whole label is matched against the pattern at
+ * once, and subtrees whose maxFreq cannot beat the worst of
+ * numCompletions matches are skipped.
+ *
+ * Parameter: pattern - a word that contains underscores as wildcard chars
+ * Parameter: numCompletions - the max length of the list of predictions
+ */
+vector<string> RadixTrie::predictUnderscores(
+    string pattern, unsigned int numCompletions ) const {
+
+    STATS_RESET();
+    vector<string> matchList = vector<string>();
+    if( numCompletions == 0 || pattern.empty() ) {
+        return matchList;
+    }
+
+    MatchHeap matches( compareFreq );
+    //word holds the characters matched on the way to the frame on top
+    string word;
+    vector<PatternFrame> stack;
+    stack.push_back( PatternFrame{ root, 0 } );
+    while( !stack.empty() ) {
+
+        PatternFrame frame = stack.back();
+        stack.pop_back();
+        const RadixNode* node = frame.node;
+
+        //skip the subtree if even its best word would not make the cut
+        if( matches.size() == numCompletions &&
+            node->maxFreq < matches.top().second ) {
+            continue;
+        }
+        STATS_ADD( nodesVisited, 1 );
+
+        //the whole label has to fit in the pattern and match it
+        unsigned int end = frame.pos + node->labelLen;
+        if( end > pattern.size() ) {
+            continue;
+        }
+        bool matched = true;
+        for( unsigned int i = 0; i < node->labelLen && matched; i++ ) {
+            char c = pattern[frame.pos + i];
+            matched = c == '_' || c == node->label[i];
+        }
+        if( !matched ) {
+            continue;
+        }
+        word.resize( frame.pos );
+        word.append( node->label, node->labelLen );
+
+        if( end == pattern.size() ) {
+            if( node->isEnd ) {
+                pair<string, unsigned int> match( word, node->freq );
+                STATS_ADD( candidatesCollected, 1 );
+                if( matches.size() < numCompletions ) {
+                    matches.push( match );
+                } else if( compareFreq( match, matches.top() ) ) {
+                    matches.pop();
+                    matches.push( match );
+                }
+            }
+            continue;
+        }
+
+        //a literal character picks the one child its edge can start with
+        char c = pattern[end];
+        if( c != '_' ) {
+            const RadixNode* child = node->children.find( c );
+            STATS_ADD( childLookups, 1 );
+            if( child != nullptr ) {
+                stack.push_back( PatternFrame{ child, end } );
+            }
+            continue;
+        }
+        for( auto iterator = node->children.begin();
+             iterator != node->children.end(); iterator++ ) {
+            stack.push_back( PatternFrame{ iterator->second, end } );
+        }
+
+    }
+
+    //the heap pops the worst match first, so fill the list from the back
+    matchList.resize( matches.size() );
+    for( unsigned int i = matches.size(); i > 0; i-- ) {
+        matchList[i-1] = matches.top().first;
+        matches.pop();
+    }
+    return matchList;
+
+}
+
+/* Returns the number of bytes used by the nodes, labels and child maps of
+ * the trie
+ */
+size_t RadixTrie::memoryBytes() const {
+
+    return arena.bytesInUse();
+
+}
+
+/* Returns the number of nodes in the trie, the root included */
+size_t RadixTrie::nodeCount() const {
+
+    return numNodes;
+
+}
+
+/* Standard destructor, the nodes live in the arena and go with it */
+RadixTrie::~RadixTrie() {}
+
+/* Orders the completion queue like DictionaryTrie's: highest frequency
+ * first, then the lexicographically smallest word, and a finished word
+ * before a subtree with the same path.
+ */
+bool RadixTrie::CompareEntry::operator()(
+    const CompletionEntry & e1, const CompletionEntry & e2 ) const {
+
+    if( e1.freq != e2.freq ) {
+        return e1.freq < e2.freq;
+    }
+    int cmp = e1.word.compare( e2.word );
+    if( cmp != 0 ) {
+        return cmp > 0;
+    }
+    return e1.node != nullptr && e2.node == nullptr;
+
+}
+
+/* Returns true if p1 should come before p2 in the results: higher
+ * frequency first, then lexicographically.
+ */
+bool RadixTrie::compareFreq( const pair<string, unsigned int> & p1,
+                             const pair<string, unsigned int> & p2 ) {
+
+    if( p1.second != p2.second ) {
+        return p1.second > p2.second;
+    }
+    return p1.first < p2.first;
+
+}
@@ -0,0 +1,197 @@
+/**
+ * The purpose of this hpp file is to define the RadixTrie class, the
+ * path compressed (Patricia) backend of the Dictionary interface. A chain
+ * of nodes that each have one child and no word of their own is collapsed
+ * into a single node, and the characters of the chain become the label of
+ * the edge into it. The dictionary is full of such chains (the tails of
+ * phrases, suffixes like -ation), so the trie has a fraction of the nodes
+ * of DictionaryTrie and a lookup follows a fraction of the pointers.
+ *
+ * A prefix or a pattern can end in the middle of an edge: the node below
+ * that edge then stands for every word that starts with it. Completions
+ * are found best-first on the subtree maxFreq values and patterns by a
+ * pruned depth-first walk, like the other backends, and give the same
+ * answers.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: Morrison "PATRICIA - Practical Algorithm To Retrieve
+ *          Information Coded in Alphanumeric", std::priority_queue doc
+ */
+#ifndef RADIX_TRIE_HPP
+#define RADIX_TRIE_HPP
+
+#include <cstdint>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "ChildMap.hpp"
+#include "Dictionary.hpp"
+#include "NodeArena.hpp"
+
+using namespace std;
+
+class RadixTrie : public Dictionary {
+  private:
+    /** Inner class which defines a radix trie node */
+    class RadixNode {
+      public:
+        //the characters of the edge into this node, kept in the arena.
+        //Splitting an edge only moves the pointer, the bytes stay put.
+        const char* label;
+        //number of characters in the label, 0 only for the root
+        uint32_t labelLen;
+        //is the end of the label the last letter of a word
+        bool isEnd;
+        //frequency
+        unsigned int freq;
+        //the highest frequency of any word in this node's subtree
+        unsigned int maxFreq;
+        //the children, keyed by the first character of their label
+        ChildMap<RadixNode> children;
+
+        RadixNode( const char* label, uint32_t labelLen ) {
+            this->label = label;
+            this->labelLen = labelLen;
+            isEnd = false;
+            freq = 0;
+            maxFreq = 0;
+        }
+    };
+
+    /** An entry in the best-first completion queue. It is either a
+     *  finished word (node is nullptr) or a subtree that still has to be
+     *  expanded, keyed by the subtree's maxFreq. word is the path to the
+     *  end of the subtree root's label, every word in the subtree starts
+     *  with it.
+     */
+    struct CompletionEntry {
+        //the word's frequency or the subtree's max frequency
+        unsigned int freq;
+        //the word, or the path leading to the subtree
+        string word;
+        //the subtree to expand, nullptr if this entry is a finished word
+        const RadixNode* node;
+    };
+
+    /** Orders the completion queue like DictionaryTrie's: highest
+     *  frequency first, then the lexicographically smallest word, and a
+     *  finished word before a subtree with the same path.
+     */
+    struct CompareEntry {
+        bool operator()( const CompletionEntry & e1,
+                         const CompletionEntry & e2 ) const;
+    };
+
+    /** A node still to visit in the pattern walk and the position in the
+     *  pattern its label starts at.
+     */
+    struct PatternFrame {
+        const RadixNode* node;
+        unsigned int pos;
+    };
+
+    /** The matches of predictUnderscores(), kept to the best K. The
+     *  worst match is on top so it can be replaced.
+     */
+    typedef priority_queue<pair<string, unsigned int>,
+                           vector<pair<string, unsigned int>>,
+                           bool (*)( const pair<string, unsigned int> &,
+                                     const pair<string, unsigned int> & )>
+        MatchHeap;
+
+    //owns the memory of every node, label and child map
+    NodeArena arena;
+
+    RadixNode* root;
+
+    //number of nodes in the trie, the root included
+    size_t numNodes;
+
+    //the nodes insert() passed, kept between calls so inserting does
+    //not allocate once it has grown
+    vector<RadixNode*> insertPath;
+
+    /* Creates a node in the arena whose label is a copy of label and
+     * returns it.
+     *
+     * Parameter: label - the characters of the edge into the node
+     */
+    RadixNode* newNode( string_view label );
+
+    /* Returns the node whose subtree holds exactly the words that start
+     * with prefix, nullptr if there are none. prefix may end in the middle
+     * of the edge into that node. path is set to the word spelled down to
+     * the end of the node's label.
+     *
+     * Parameter: prefix - the prefix to look for
+     * Parameter: path - set to the path of the returned node
+     */
+    const RadixNode* findPrefix( string_view prefix, string & path ) const;
+
+    /* Returns true if p1 should come before p2 in the results: higher
+     * frequency first, then lexicographically.
+     */
+    static bool compareFreq( const pair<string, unsigned int> & p1,
+                             const pair<string, unsigned int> & p2 );
+
+  public:
+    /* Creates an empty radix trie */
+    RadixTrie();
+
+    RadixTrie( const RadixTrie & other ) = delete;
+    RadixTrie & operator=( const RadixTrie & other ) = delete;
+
+    /* Inserts word with the given frequency and returns true, or returns
+     * false if the word is empty or already in the trie. An edge the word
+     * leaves in its middle is split in two.
+     *
+     * Parameter: word - the word to insert
+     * Parameter: freq - the frequency of the word
+     */
+    bool insert( string_view word, unsigned int freq ) override;
+
+    /* Returns true if word is in the trie
+     *
+     * Parameter: word - the word to look for
+     */
+    bool find( string word ) const override;
+
+    /* Returns up to numCompletions words that start with prefix, from
+     * high to low frequency and lexicographically among equal ones. The
+     * search is best-first on the subtree maxFreq values, so it stops
+     * once numCompletions words are final.
+     *
+     * Parameter: prefix - the prefix of the words to return
+     * Parameter: numCompletions - the max length of the list of predictions
+     */
+    vector<string> predictCompletions(
+        string prefix, unsigned int numCompletions ) const override;
+
+    /* Returns up to numCompletions words of the same length as pattern
+     * that match it, an underscore matching any one character, ordered
+     * like predictCompletions(). A whole label is matched against the
+     * pattern at once, and subtrees whose maxFreq cannot beat the worst
+     * of numCompletions matches are skipped.
+     *
+     * Parameter: pattern - a word that contains underscores as wildcard chars
+     * Parameter: numCompletions - the max length of the list of predictions
+     */
+    vector<string> predictUnderscores(
+        string pattern, unsigned int numCompletions ) const override;
+
+    /* Returns the number of bytes used by the nodes, labels and child
+     * maps of the trie
+     */
+    size_t memoryBytes() const override;
+
+    /* Returns the number of nodes in the trie, the root included */
+    size_t nodeCount() const override;
+
+    /* Standard destructor, the nodes live in the arena and go with it */
+    ~RadixTrie();
+};
+
+#endif  // RADIX_TRIE_HPP
@@ -0,0 +1,363 @@
+/**
+ * The purpose of this cpp file is to provide implementation for the
+ * methods of the TernarySearchTree class. Every walk goes down the tree
+ * with a loop or an explicit stack, so a very long word needs no more
+ * call stack than a short one.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: Bentley and Sedgewick "Fast Algorithms for Sorting and
+ *          Searching Strings" (ternary search trees),
+ *          std::priority_queue doc
+ */
+#include "TernarySearchTree.hpp"
+#include <new>
+#include "QueryStats.hpp"
+
+/* Creates an empty TST */
+TernarySearchTree::TernarySearchTree() : root(nullptr), numNodes(0) {}
+
+/* Creates a new node for key in the arena and returns it */
+TernarySearchTree::TSTNode* TernarySearchTree::newNode( char key ) {
+
+    numNodes++;
+    return new ( arena.allocate( sizeof(TSTNode) ) ) TSTNode( key );
+
+}
+
+/* Inserts word with the given frequency and returns true, or returns
+ * false if the word is empty or already in the TST.
+ *
+ * Parameter: word - the word to insert
+ * Parameter: freq - the frequency of the word
+ */
+bool TernarySearchTree::insert( string_view word, unsigned int freq ) {
+
+    if( word.size() < 1 ) {
+        return false;
+    }
+
+    //walk down like find(), adding the nodes that are missing. A duplicate
+    //only shows at the last node, and its path already existed, so the
+    //walk has changed nothing when it gives up.
+    insertPath.clear();
+    TSTNode** link = &root;
+    unsigned int i = 0;
+    while( true ) {
+
+        if( *link == nullptr ) {
+            *link = newNode( word[i] );
+        }
+        TSTNode* curNode = *link;
+        insertPath.push_back( curNode );
+
+        if( word[i] < curNode->key ) {
+            link = &curNode->left;
+        } else if( word[i] > curNode->key ) {
+            link = &curNode->right;
+        } else if( i + 1 < word.size() ) {
+            link = &curNode->mid;
+            i++;
+        } else if( curNode->isEnd ) {
+            return false;
+        } else {
+            curNode->isEnd = true;
+            curNode->freq = freq;
+            break;
+        }
+
+    }
+
+    //every node passed has the new word in its subtree, so its maxFreq
+    //covers it
+    for( TSTNode* node : insertPath ) {
+        if( freq > node->maxFreq ) {
+            node->maxFreq = freq;
+        }
+    }
+    return true;
+
+}
+
+/* Returns the node of the last character of word, nullptr if no word in
+ * the tree starts with word. visited is set to the number of nodes
+ * passed, for the query that asked to count.
+ *
+ * Parameter: word - the word or prefix to look for
+ * Parameter: visited - set to the number of nodes passed
+ */
+const TernarySearchTree::TSTNode* TernarySearchTree::findNode(
+    string_view word, unsigned long long & visited ) const {
+
+    visited = 0;
+    if( word.empty() ) {
+        return nullptr;
+    }
+    const TSTNode* curNode = root;
+    unsigned int i = 0;
+    while( curNode != nullptr ) {
+
+        visited++;
+        if( word[i] < curNode->key ) {
+            curNode = curNode->left;
+        } else if( word[i] > curNode->key ) {
+            curNode = curNode->right;
+        } else if( i + 1 < word.size() ) {
+            curNode = curNode->mid;
+            i++;
+        } else {
+            return curNode;
+        }
+
+    }
+    return nullptr;
+
+}
+
+/* Returns true if word is in the TST
+ *
+ * Parameter: word - the word to look for
+ */
+bool TernarySearchTree::find( string word ) const {
+
+    STATS_RESET();
+    unsigned long long visited;
+    const TSTNode* node = findNode( word, visited );
+    STATS_ADD( nodesVisited, visited );
+    return node != nullptr && node->isEnd;
+
+}
+
+/* Follows node down its middle while it has no word of its own and no
+ * siblings, adding the keys passed to word, and returns where it stops.
+ * This keeps a long chain from being copied once per node.
+ *
+ * Parameter: node - the node to start from
+ * Parameter: word - the path to node, extended to the returned node
+ */
+const TernarySearchTree::TSTNode* TernarySearchTree::skipChain(
+    const TSTNode* node, string & word ) {
+
+    while( !node->isEnd && node->left == nullptr &&
+           node->right == nullptr && node->mid != nullptr ) {
+        word.push_back( node->key );
+        node = node->mid;
+    }
+    return node;
+
+}
+
+/* Returns up to numCompletions words that start with prefix, from high
+ * to low frequency and lexicographically among equal ones. The search is
+ * best-first on the subtree maxFreq values, so it stops once
+ * numCompletions words are final.
+ *
+ * Parameter: prefix - the prefix of the words to return
+ * Parameter: numCompletions - the max length of the list of predictions
+ */
+vector<string> TernarySearchTree::predictCompletions(
+    string prefix, unsigned int numCompletions ) const {
+
+    STATS_RESET();
+    vector<string> completionList = vector<string>();
+    if( numCompletions == 0 || root == nullptr ) {
+        return completionList;
+    }
+
+    priority_queue<CompletionEntry, vector<CompletionEntry>, CompareEntry>
+        frontier;
+    if( prefix.empty() ) {
+
+        frontier.push( CompletionEntry{ root->maxFreq, prefix, root } );
+
+    } else {
+
+        //the prefix's node holds the prefix itself, its middle subtree
+        //every longer word
+        unsigned long long visited;
+        const TSTNode* node = findNode( prefix, visited );
+        STATS_ADD( nodesVisited, visited );
+        if( node == nullptr ) {
+            return completionList;
+        }
+        if( node->isEnd ) {
+            frontier.push( CompletionEntry{ node->freq, prefix, nullptr } );
+        }
+        if( node->mid != nullptr ) {
+            string word = prefix;
+            const TSTNode* mid = skipChain( node->mid, word );
+            frontier.push( CompletionEntry{ mid->maxFreq, std::move( word ),
+                                            mid } );
+        }
+
+    }
+
+    //loop until we have numCompletions words or nothing is left to expand
+    while( completionList.size() < numCompletions && !frontier.empty() ) {
+
+        CompletionEntry entry = frontier.top();
+        frontier.pop();
+
+        //a finished word can go straight into the list
+        if( entry.node == nullptr ) {
+            completionList.push_back( std::move( entry.word ) );
+            STATS_ADD( candidatesCollected, 1 );
+            continue;
+        }
+
+        //the siblings share the path, the node's own word and its middle
+        //subtree go one character further
+        const TSTNode* node = entry.node;
+        STATS_ADD( nodesVisited, 1 );
+        if( node->left != nullptr ) {
+            frontier.push( CompletionEntry{ node->left->maxFreq, entry.word,
+                                            node->left } );
+        }
+        if( node->right != nullptr ) {
+            frontier.push( CompletionEntry{ node->right->maxFreq,
+                                            entry.word, node->right } );
+        }
+        entry.word.push_back( node->key );
+        if( node->isEnd ) {
+            frontier.push( CompletionEntry{ node->freq, entry.word,
+                                            nullptr } );
+        }
+        if( node->mid != nullptr ) {
+            const TSTNode* mid = skipChain( node->mid, entry.word );
+            frontier.push( CompletionEntry{ mid->maxFreq,
+                                            std::move( entry.word ), mid } );
+        }
+
+    }
+
+    return completionList;
+
+}
+
+/* Returns up to numCompletions words of the same length as pattern that
+ * match it, an underscore matching any one character, ordered like
+ * predictCompletions(). A literal character only follows the one branch
+ * its comparison picks, and subtrees whose maxFreq cannot beat the worst
+ * of numCompletions matches are skipped.
+ *
+ * Parameter: pattern - a word that contains underscores as wildcard chars
+ * Parameter: numCompletions - the max length of the list of predictions
+ */
+vector<string> TernarySearchTree::predictUnderscores(
+    string pattern, unsigned int numCompletions ) const {
+
+    STATS_RESET();
+    vector<string> matchList = vector<string>();
+    if( numCompletions == 0 || pattern.empty() || root == nullptr ) {
+        return matchList;
+    }
+
+    MatchHeap matches( compareFreq );
+    //word holds the characters matched on the way to the frame on top
+    string word;
+    vector<PatternFrame> stack;
+    stack.push_back( PatternFrame{ root, 0 } );
+    while( !stack.empty() ) {
+
+        PatternFrame frame = stack.back();
+        stack.pop_back();
+        const TSTNode* node = frame.node;
+
+        //skip the subtree if even its best word would not make the cut
+        if( matches.size() == numCompletions &&
+            node->maxFreq < matches.top().second ) {
+            continue;
+        }
+        STATS_ADD( nodesVisited, 1 );
+
+        char c = pattern[frame.pos];
+        bool wild = c == '_';
+        if( node->left != nullptr && ( wild || c < node->key ) ) {
+            stack.push_back( PatternFrame{ node->left, frame.pos } );
+        }
+        if( node->right != nullptr && ( wild || c > node->key ) ) {
+            stack.push_back( PatternFrame{ node->right, frame.pos } );
+        }
+        if( !wild && c != node->key ) {
+            continue;
+        }
+
+        word.resize( frame.pos );
+        word.push_back( node->key );
+        if( frame.pos + 1 < pattern.size() ) {
+            if( node->mid != nullptr ) {
+                stack.push_back( PatternFrame{ node->mid, frame.pos + 1 } );
+            }
+            continue;
+        }
+
+        if( node->isEnd ) {
+            pair<string, unsigned int> match( word, node->freq );
+            STATS_ADD( candidatesCollected, 1 );
+            if( matches.size() < numCompletions ) {
+                matches.push( match );
+            } else if( compareFreq( match, matches.top() ) ) {
+                matches.pop();
+                matches.push( match );
+            }
+        }
+
+    }
+
+    //the heap pops the worst match first, so fill the list from the back
+    matchList.resize( matches.size() );
+    for( unsigned int i = matches.size(); i > 0; i-- ) {
+        matchList[i-1] = matches.top().first;
+        matches.pop();
+    }
+    return matchList;
+
+}
+
+/* Returns the number of bytes used by the nodes of the TST */
+size_t TernarySearchTree::memoryBytes() const {
+
+    return numNodes * sizeof(TSTNode);
+
+}
+
+/* Returns the number of nodes in the TST */
+size_t TernarySearchTree::nodeCount() const {
+
+    return numNodes;
+
+}
+
+/* Standard destructor, the nodes live in the arena and go with it */
+TernarySearchTree::~TernarySearchTree() {}
+
+/* Orders the completion queue like DictionaryTrie's: highest frequency
+ * first, then the lexicographically smallest word, and a finished word
+ * before a subtree with the same path.
+ */
+bool TernarySearchTree::CompareEntry::operator()(
+    const CompletionEntry & e1, const CompletionEntry & e2 ) const {
+
+    if( e1.freq != e2.freq ) {
+        return e1.freq < e2.freq;
+    }
+    int cmp = e1.word.compare( e2.word );
+    if( cmp != 0 ) {
+        return cmp > 0;
+    }
+    return e1.node != nullptr && e2.node == nullptr;
+
+}
+
+/* Returns true if p1 should come before p2 in the results: higher
+ * frequency first, then lexicographically.
+ */
+bool TernarySearchTree::compareFreq( const pair<string, unsigned int> & p1,
+                                     const pair<string, unsigned int> & p2 ) {
+
+    if( p1.second != p2.second ) {
+        return p1.second > p2.second;
+    }
+    return p1.first < p2.first;
+
+}
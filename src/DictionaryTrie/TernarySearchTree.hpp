@@ -0,0 +1,200 @@
+/**
+ * The purpose of this hpp file is to define the TernarySearchTree class,
+ * the ternary search tree backend of the Dictionary interface. Every node
+ * holds one character and three children: the left and right subtrees
+ * hold the words that have a smaller or bigger character at this
+ * position, and the middle subtree the words that go on past it. A node
+ * costs three pointers no matter how many siblings it has, where a
+ * multiway trie node pays for a child map, so the TST trades a few more
+ * nodes per lookup for less memory on sparse levels.
+ *
+ * The answers are the same as DictionaryTrie's: completions are found
+ * best-first on the subtree maxFreq values and patterns by a pruned
+ * depth-first walk, both with explicit stacks.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: Bentley and Sedgewick "Fast Algorithms for Sorting and
+ *          Searching Strings" (ternary search trees),
+ *          std::priority_queue doc
+ */
+#ifndef TERNARY_SEARCH_TREE_HPP
+#define TERNARY_SEARCH_TREE_HPP
+
+#include <queue>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Dictionary.hpp"
+#include "NodeArena.hpp"
+
+using namespace std;
+
+class TernarySearchTree : public Dictionary {
+  private:
+    /** Inner class which defines a TST node */
+    class TSTNode {
+      public:
+        //the character of this position
+        char key;
+        //is it the last letter of a word
+        bool isEnd;
+        //frequency
+        unsigned int freq;
+        //the highest frequency of any word in this node's subtree, the
+        //left and right subtrees included
+        unsigned int maxFreq;
+        //words with a smaller character here, words going on past this
+        //one, and words with a bigger character here
+        TSTNode* left;
+        TSTNode* mid;
+        TSTNode* right;
+
+        TSTNode( char key ) {
+            this->key = key;
+            isEnd = false;
+            freq = 0;
+            maxFreq = 0;
+            left = nullptr;
+            mid = nullptr;
+            right = nullptr;
+        }
+    };
+
+    /** An entry in the best-first completion queue. It is either a
+     *  finished word (node is nullptr) or a subtree that still has to be
+     *  expanded, keyed by the subtree's maxFreq. word is the path before
+     *  the subtree's root, every word in the subtree is longer.
+     */
+    struct CompletionEntry {
+        //the word's frequency or the subtree's max frequency
+        unsigned int freq;
+        //the word, or the path leading to the subtree
+        string word;
+        //the subtree to expand, nullptr if this entry is a finished word
+        const TSTNode* node;
+    };
+
+    /** Orders the completion queue like DictionaryTrie's: highest
+     *  frequency first, then the lexicographically smallest word, and a
+     *  finished word before a subtree with the same path.
+     */
+    struct CompareEntry {
+        bool operator()( const CompletionEntry & e1,
+                         const CompletionEntry & e2 ) const;
+    };
+
+    /** A node still to visit in the pattern walk and the number of
+     *  pattern characters matched on the way to it.
+     */
+    struct PatternFrame {
+        const TSTNode* node;
+        unsigned int pos;
+    };
+
+    /** The matches of predictUnderscores(), kept to the best K. The
+     *  worst match is on top so it can be replaced.
+     */
+    typedef priority_queue<pair<string, unsigned int>,
+                           vector<pair<string, unsigned int>>,
+                           bool (*)( const pair<string, unsigned int> &,
+                                     const pair<string, unsigned int> & )>
+        MatchHeap;
+
+    //owns the memory of every node
+    NodeArena arena;
+
+    //nullptr until the first word is inserted
+    TSTNode* root;
+
+    //number of nodes in the tree
+    size_t numNodes;
+
+    //the nodes insert() passed, kept between calls so inserting does
+    //not allocate once it has grown
+    vector<TSTNode*> insertPath;
+
+    /* Creates a new node for key in the arena and returns it */
+    TSTNode* newNode( char key );
+
+    /* Returns the node of the last character of word, nullptr if no word
+     * in the tree starts with word. visited is set to the number of nodes
+     * passed, for the query that asked to count.
+     *
+     * Parameter: word - the word or prefix to look for
+     * Parameter: visited - set to the number of nodes passed
+     */
+    const TSTNode* findNode( string_view word,
+                             unsigned long long & visited ) const;
+
+    /* Follows node down its middle while it has no word of its own and no
+     * siblings, adding the keys passed to word, and returns where it
+     * stops. This keeps a long chain from being copied once per node.
+     *
+     * Parameter: node - the node to start from
+     * Parameter: word - the path to node, extended to the returned node
+     */
+    static const TSTNode* skipChain( const TSTNode* node, string & word );
+
+    /* Returns true if p1 should come before p2 in the results: higher
+     * frequency first, then lexicographically.
+     */
+    static bool compareFreq( const pair<string, unsigned int> & p1,
+                             const pair<string, unsigned int> & p2 );
+
+  public:
+    /* Creates an empty TST */
+    TernarySearchTree();
+
+    TernarySearchTree( const TernarySearchTree & other ) = delete;
+    TernarySearchTree & operator=( const TernarySearchTree & other ) = delete;
+
+    /* Inserts word with the given frequency and returns true, or returns
+     * false if the word is empty or already in the TST.
+     *
+     * Parameter: word - the word to insert
+     * Parameter: freq - the frequency of the word
+     */
+    bool insert( string_view word, unsigned int freq ) override;
+
+    /* Returns true if word is in the TST
+     *
+     * Parameter: word - the word to look for
+     */
+    bool find( string word ) const override;
+
+    /* Returns up to numCompletions words that start with prefix, from
+     * high to low frequency and lexicographically among equal ones. The
+     * search is best-first on the subtree maxFreq values, so it stops
+     * once numCompletions words are final.
+     *
+     * Parameter: prefix - the prefix of the words to return
+     * Parameter: numCompletions - the max length of the list of predictions
+     */
+    vector<string> predictCompletions(
+        string prefix, unsigned int numCompletions ) const override;
+
+    /* Returns up to numCompletions words of the same length as pattern
+     * that match it, an underscore matching any one character, ordered
+     * like predictCompletions(). A literal character only follows the
+     * one branch its comparison picks, and subtrees whose maxFreq cannot
+     * beat the worst of numCompletions matches are skipped.
+     *
+     * Parameter: pattern - a word that contains underscores as wildcard chars
+     * Parameter: numCompletions - the max length of the list of predictions
+     */
+    vector<string> predictUnderscores(
+        string pattern, unsigned int numCompletions ) const override;
+
+    /* Returns the number of bytes used by the nodes of the TST */
+    size_t memoryBytes() const override;
+
+    /* Returns the number of nodes in the TST */
+    size_t nodeCount() const override;
+
+    /* Standard destructor, the nodes live in the arena and go with it */
+    ~TernarySearchTree();
+};
+
+#endif  // TERNARY_SEARCH_TREE_HPP
@@ -0,0 +1,118 @@
+/**
+ * The purpose of this cpp file is to provide implementation for the UTF-8
+ * helpers: the validator the dictionaries run on every word in UTF-8
+ * mode, and the encoder and counter the tests and benchmarks build
+ * multi byte words with.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: RFC 3629 "UTF-8, a transformation format of ISO 10646"
+ */
+#include "Utf8.hpp"
+
+/* Returns true if text is well formed UTF-8: no stray continuation
+ * bytes, no cut off or overlong sequences, no surrogates and nothing
+ * past U+10FFFF.
+ *
+ * Parameter: text - the bytes to check
+ */
+bool validUtf8( string_view text ) {
+
+    size_t i = 0;
+    while( i < text.size() ) {
+
+        unsigned char lead = text[i];
+        if( lead < 0x80 ) {
+            i++;
+            continue;
+        }
+
+        //the number of continuation bytes and the range the first of them
+        //has to be in, which rules out overlong forms, surrogates and code
+        //points past U+10FFFF (RFC 3629 section 4)
+        size_t length;
+        unsigned char lo = 0x80;
+        unsigned char hi = 0xBF;
+        if( lead >= 0xC2 && lead <= 0xDF ) {
+            length = 1;
+        } else if( lead >= 0xE0 && lead <= 0xEF ) {
+            length = 2;
+            if( lead == 0xE0 ) {
+                lo = 0xA0;
+            } else if( lead == 0xED ) {
+                hi = 0x9F;
+            }
+        } else if( lead >= 0xF0 && lead <= 0xF4 ) {
+            length = 3;
+            if( lead == 0xF0 ) {
+                lo = 0x90;
+            } else if( lead == 0xF4 ) {
+                hi = 0x8F;
+            }
+        } else {
+            return false;
+        }
+
+        if( text.size() - i - 1 < length ) {
+            return false;
+        }
+        for( size_t j = 1; j <= length; j++ ) {
+            unsigned char c = text[i + j];
+            if( c < lo || c > hi ) {
+                return false;
+            }
+            lo = 0x80;
+            hi = 0xBF;
+        }
+        i += length + 1;
+
+    }
+    return true;
+
+}
+
+/* Returns the number of code points in text, which has to be valid UTF-8
+ *
+ * Parameter: text - the UTF-8 text to count
+ */
+size_t utf8Length( string_view text ) {
+
+    //every code point has exactly one byte that is not a continuation
+    size_t count = 0;
+    for( char c : text ) {
+        if( ( (unsigned char) c & 0xC0 ) != 0x80 ) {
+            count++;
+        }
+    }
+    return count;
+
+}
+
+/* Appends the UTF-8 bytes of codePoint to text, which is left unchanged
+ * if codePoint is a surrogate or past U+10FFFF.
+ *
+ * Parameter: text - the string to append to
+ * Parameter: codePoint - the code point to append
+ */
+void appendUtf8( string & text, uint32_t codePoint ) {
+
+    if( codePoint < 0x80 ) {
+        text.push_back( (char) codePoint );
+    } else if( codePoint < 0x800 ) {
+        text.push_back( (char) ( 0xC0 | ( codePoint >> 6 ) ) );
+        text.push_back( (char) ( 0x80 | ( codePoint & 0x3F ) ) );
+    } else if( codePoint < 0x10000 ) {
+        if( codePoint >= 0xD800 && codePoint <= 0xDFFF ) {
+            return;
+        }
+        text.push_back( (char) ( 0xE0 | ( codePoint >> 12 ) ) );
+        text.push_back( (char) ( 0x80 | ( ( codePoint >> 6 ) & 0x3F ) ) );
+        text.push_back( (char) ( 0x80 | ( codePoint & 0x3F ) ) );
+    } else if( codePoint <= 0x10FFFF ) {
+        text.push_back( (char) ( 0xF0 | ( codePoint >> 18 ) ) );
+        text.push_back( (char) ( 0x80 | ( ( codePoint >> 12 ) & 0x3F ) ) );
+        text.push_back( (char) ( 0x80 | ( ( codePoint >> 6 ) & 0x3F ) ) );
+        text.push_back( (char) ( 0x80 | ( codePoint & 0x3F ) ) );
+    }
+
+}
@@ -0,0 +1,43 @@
+/**
+ * The purpose of this hpp file is to declare the few UTF-8 helpers the
+ * dictionaries use in UTF-8 mode. The tries stay keyed on bytes, a code
+ * point is the path of its 1 to 4 bytes, so all these have to do is keep
+ * the words well formed and build them.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: RFC 3629 "UTF-8, a transformation format of ISO 10646"
+ */
+#ifndef UTF8_HPP
+#define UTF8_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+/* Returns true if text is well formed UTF-8: no stray continuation
+ * bytes, no cut off or overlong sequences, no surrogates and nothing
+ * past U+10FFFF.
+ *
+ * Parameter: text - the bytes to check
+ */
+bool validUtf8( string_view text );
+
+/* Returns the number of code points in text, which has to be valid UTF-8
+ *
+ * Parameter: text - the UTF-8 text to count
+ */
+size_t utf8Length( string_view text );
+
+/* Appends the UTF-8 bytes of codePoint to text, which is left unchanged
+ * if codePoint is a surrogate or past U+10FFFF.
+ *
+ * Parameter: text - the string to append to
+ * Parameter: codePoint - the code point to append
+ */
+void appendUtf8( string & text, uint32_t codePoint );
+
+#endif  // UTF8_HPP
@@ -0,0 +1,446 @@
+/**
+ * The purpose of this cpp file is to provide implementation for the
+ * methods of the WildcardPattern class: the pattern compiler and the
+ * bit-parallel steps of the automaton. State i is live when the first i
+ * steps have matched what was read so far, so reading a character moves
+ * state i to i + 1 if step i's class holds it, and keeps it at i if step
+ * i is a star whose class holds it.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: Navarro and Raffinot "Flexible Pattern Matching in Strings"
+ *          (bit-parallel NFA simulation)
+ */
+#include "WildcardPattern.hpp"
+
+//number of distinct characters
+static const unsigned int ALPHABET = 256;
+
+//UTF-8 bytes 10xxxxxx continue a code point, the others start one
+static const unsigned int CONTINUATION_FIRST = 0x80;
+static const unsigned int CONTINUATION_LAST = 0xBF;
+//the most continuation bytes a code point has
+static const size_t MAX_CONTINUATIONS = 3;
+
+/* Creates a pattern that matches nothing */
+WildcardPattern::WildcardPattern() {
+
+    //one step with an empty class can never be passed
+    addStep( vector<bool>( ALPHABET, false ), false );
+    finish();
+
+}
+
+/* Compiles pattern with the full syntax. Returns false, leaving a
+ * pattern that matches nothing, if pattern is malformed (an unclosed
+ * class, a trailing backslash, or in UTF-8 mode a class listing a
+ * non-ASCII character).
+ *
+ * Parameter: pattern - the pattern to compile
+ * Parameter: utf8 - do wildcards match whole UTF-8 code points
+ */
+bool WildcardPattern::compile( const string & pattern, bool utf8 ) {
+
+    stepChars.clear();
+    stepStar.clear();
+    stepRun.clear();
+    vector<bool> any = vector<bool>( ALPHABET, true );
+    bool valid = true;
+
+    for( unsigned int i = 0; i < pattern.size() && valid; i++ ) {
+
+        char c = pattern[i];
+        if( c == '_' || c == '?' ) {
+
+            if( utf8 ) {
+                addCodePoint( any );
+            } else {
+                addStep( any, false );
+            }
+
+        } else if( c == '*' ) {
+
+            addStep( any, true );
+
+        } else if( c == '[' ) {
+
+            //read the class up to its closing bracket, a bracket right
+            //after the opening one (or its ^) is a member
+            vector<bool> chars = vector<bool>( ALPHABET, false );
+            unsigned int j = i + 1;
+            bool negate = j < pattern.size() && pattern[j] == '^';
+            if( negate ) {
+                j++;
+            }
+            bool first = true;
+            while( j < pattern.size() && ( first || pattern[j] != ']' ) ) {
+
+                unsigned char lo = pattern[j];
+                if( lo == '\\' && j + 1 < pattern.size() ) {
+                    j++;
+                    lo = pattern[j];
+                }
+                unsigned char hi = lo;
+                if( j + 2 < pattern.size() && pattern[j+1] == '-' &&
+                    pattern[j+2] != ']' ) {
+                    hi = pattern[j+2];
+                    j += 2;
+                }
+                //a byte of a multi byte code point is not a character
+                //of its own in UTF-8 mode
+                if( utf8 && ( lo >= CONTINUATION_FIRST ||
+                              hi >= CONTINUATION_FIRST ) ) {
+                    valid = false;
+                    break;
+                }
+                for( unsigned int k = lo; k <= hi; k++ ) {
+                    chars[k] = true;
+                }
+                j++;
+                first = false;
+
+            }
+            if( !valid || j >= pattern.size() ) {
+                valid = false;
+                break;
+            }
+            if( negate ) {
+                chars.flip();
+            }
+            //only a negated class can take a non-ASCII code point
+            if( utf8 && negate ) {
+                addCodePoint( chars );
+            } else {
+                addStep( chars, false );
+            }
+            i = j;
+
+        } else {
+
+            if( c == '\\' ) {
+                if( i + 1 >= pattern.size() ) {
+                    valid = false;
+                    break;
+                }
+                i++;
+                c = pattern[i];
+            }
+            vector<bool> chars = vector<bool>( ALPHABET, false );
+            chars[(unsigned char) c] = true;
+            addStep( chars, false );
+
+        }
+
+    }
+
+    if( !valid ) {
+        stepChars.clear();
+        stepStar.clear();
+        stepRun.clear();
+        addStep( vector<bool>( ALPHABET, false ), false );
+    }
+    finish();
+    return valid;
+
+}
+
+/* Compiles pattern with predictUnderscores() rules: an underscore is
+ * any one character and every other character matches itself.
+ *
+ * Parameter: pattern - the pattern to compile
+ * Parameter: utf8 - do underscores match whole UTF-8 code points
+ */
+void WildcardPattern::compileUnderscores( const string & pattern,
+                                          bool utf8 ) {
+
+    stepChars.clear();
+    stepStar.clear();
+    stepRun.clear();
+    for( unsigned int i = 0; i < pattern.size(); i++ ) {
+
+        if( utf8 && pattern[i] == '_' ) {
+            addCodePoint( vector<bool>( ALPHABET, true ) );
+            continue;
+        }
+        vector<bool> chars = vector<bool>( ALPHABET, pattern[i] == '_' );
+        chars[(unsigned char) pattern[i]] = true;
+        addStep( chars, false );
+
+    }
+    finish();
+
+}
+
+/* Adds a step matching the characters in chars, or a star step that
+ * matches a run of up to maxRun of them.
+ *
+ * Parameter: chars - the 256 flags of the characters to match
+ * Parameter: star - is the step a star
+ * Parameter: maxRun - the longest run a star can match
+ */
+void WildcardPattern::addStep( const vector<bool> & chars, bool star,
+                               size_t maxRun ) {
+
+    //a run of stars matches the same as one star. The only narrow star
+    //is over continuation bytes and * covers it, so the wider of the two
+    //is kept.
+    if( star && !stepStar.empty() && stepStar.back() ) {
+        for( unsigned int c = 0; c < ALPHABET; c++ ) {
+            if( chars[c] ) {
+                stepChars.back()[c] = true;
+            }
+        }
+        if( maxRun > stepRun.back() ) {
+            stepRun.back() = maxRun;
+        }
+        return;
+    }
+    stepChars.push_back( chars );
+    stepStar.push_back( star );
+    stepRun.push_back( star ? maxRun : 1 );
+
+}
+
+/* Adds the steps of one UTF-8 code point whose first byte is in leads: a
+ * step over the first byte and a star over the continuation bytes behind
+ * it.
+ *
+ * Parameter: leads - the 256 flags of the first bytes to match
+ */
+void WildcardPattern::addCodePoint( const vector<bool> & leads ) {
+
+    vector<bool> first = leads;
+    vector<bool> rest = vector<bool>( ALPHABET, false );
+    for( unsigned int c = CONTINUATION_FIRST; c <= CONTINUATION_LAST; c++ ) {
+        first[c] = false;
+        rest[c] = true;
+    }
+    addStep( first, false );
+    addStep( rest, true, MAX_CONTINUATIONS );
+
+}
+
+/* Turns the list of steps into the masks and length tables */
+void WildcardPattern::finish() {
+
+    numSteps = stepChars.size();
+    //states run from 0 to numSteps
+    numWords = numSteps / 64 + 1;
+
+    charMasks.assign( ALPHABET * numWords, 0 );
+    starMask.assign( numWords, 0 );
+    literals.assign( numSteps, -1 );
+    for( unsigned int i = 0; i < numSteps; i++ ) {
+
+        uint64_t bit = (uint64_t) 1 << ( i % 64 );
+        if( stepStar[i] ) {
+            starMask[i / 64] |= bit;
+            for( unsigned int c = 0; c < ALPHABET; c++ ) {
+                if( stepChars[i][c] ) {
+                    charMasks[c * numWords + i / 64] |= bit;
+                }
+            }
+            continue;
+        }
+
+        unsigned int count = 0;
+        for( unsigned int c = 0; c < ALPHABET; c++ ) {
+            if( stepChars[i][c] ) {
+                charMasks[c * numWords + i / 64] |= bit;
+                literals[i] = c;
+                count++;
+            }
+        }
+        if( count != 1 ) {
+            literals[i] = -1;
+        }
+
+    }
+
+    //work the lengths out back to front from the accepting state
+    minRemaining.assign( numSteps + 1, 0 );
+    maxRemaining.assign( numSteps + 1, 0 );
+    for( unsigned int i = numSteps; i > 0; i-- ) {
+
+        if( stepStar[i-1] ) {
+            minRemaining[i-1] = minRemaining[i];
+            maxRemaining[i-1] = maxRemaining[i] == SIZE_MAX ||
+                                stepRun[i-1] == SIZE_MAX ?
+                                SIZE_MAX : maxRemaining[i] + stepRun[i-1];
+        } else {
+            minRemaining[i-1] = minRemaining[i] + 1;
+            maxRemaining[i-1] = maxRemaining[i] == SIZE_MAX ?
+                                SIZE_MAX : maxRemaining[i] + 1;
+        }
+
+    }
+
+    stepChars.clear();
+    stepStar.clear();
+    stepRun.clear();
+
+}
+
+/* Adds to set the state after every live star, since a star can match
+ * no characters at all.
+ */
+void WildcardPattern::closeStars( uint64_t* set ) const {
+
+    //stars never follow each other, so one shift reaches every state
+    uint64_t carry = 0;
+    for( unsigned int w = 0; w < numWords; w++ ) {
+        uint64_t stars = set[w] & starMask[w];
+        set[w] |= ( stars << 1 ) | carry;
+        carry = stars >> 63;
+    }
+
+}
+
+/* Returns the number of 64 bit words in a state set */
+unsigned int WildcardPattern::setWords() const {
+
+    return numWords;
+
+}
+
+/* Fills set with the states the automaton starts in
+ *
+ * Parameter: set - the state set to fill
+ */
+void WildcardPattern::start( uint64_t* set ) const {
+
+    for( unsigned int w = 0; w < numWords; w++ ) {
+        set[w] = 0;
+    }
+    set[0] = 1;
+    closeStars( set );
+
+}
+
+/* Fills next with the states reached from set on character c and
+ * returns false if there are none, meaning no word continuing with c
+ * can match.
+ *
+ * Parameter: set - the current state set
+ * Parameter: c - the next character
+ * Parameter: next - the state set to fill
+ */
+bool WildcardPattern::step( const uint64_t* set, char c,
+                            uint64_t* next ) const {
+
+    const uint64_t* mask = &charMasks[(unsigned char) c * numWords];
+    uint64_t carry = 0;
+    for( unsigned int w = 0; w < numWords; w++ ) {
+
+        //a matching class moves on a state, a matching star stays where
+        //it is
+        uint64_t matched = set[w] & mask[w];
+        uint64_t moved = matched & ~starMask[w];
+        uint64_t stayed = matched & starMask[w];
+        next[w] = ( moved << 1 ) | carry | stayed;
+        carry = moved >> 63;
+
+    }
+    closeStars( next );
+
+    uint64_t live = 0;
+    for( unsigned int w = 0; w < numWords; w++ ) {
+        live |= next[w];
+    }
+    return live != 0;
+
+}
+
+/* Returns true if set contains the accepting state
+ *
+ * Parameter: set - the state set to check
+ */
+bool WildcardPattern::accepts( const uint64_t* set ) const {
+
+    return ( set[numSteps / 64] >> ( numSteps % 64 ) ) & 1;
+
+}
+
+/* Returns the only character set can step on, -1 if it can step on
+ * more than one and -2 if it cannot step at all.
+ *
+ * Parameter: set - the state set to check
+ */
+int WildcardPattern::nextChar( const uint64_t* set ) const {
+
+    int only = -2;
+    for( unsigned int w = 0; w < numWords; w++ ) {
+
+        if( set[w] & starMask[w] ) {
+            return -1;
+        }
+        uint64_t live = set[w];
+        while( live != 0 ) {
+
+            unsigned int i = w * 64 + __builtin_ctzll( live );
+            live &= live - 1;
+            if( i == numSteps ) {
+                continue;
+            }
+            if( literals[i] < 0 || ( only >= 0 && only != literals[i] ) ) {
+                return -1;
+            }
+            only = literals[i];
+
+        }
+
+    }
+    return only;
+
+}
+
+/* Sets lo and hi to the fewest and most characters a word still needs
+ * to be accepted from set, hi is SIZE_MAX if there is no upper limit.
+ *
+ * Parameter: set - the state set to check
+ * Parameter: lo - set to the fewest characters needed
+ * Parameter: hi - set to the most characters allowed
+ */
+void WildcardPattern::remaining( const uint64_t* set, size_t & lo,
+                                 size_t & hi ) const {
+
+    lo = SIZE_MAX;
+    hi = 0;
+    for( unsigned int w = 0; w < numWords; w++ ) {
+
+        uint64_t live = set[w];
+        while( live != 0 ) {
+
+            unsigned int i = w * 64 + __builtin_ctzll( live );
+            live &= live - 1;
+            if( minRemaining[i] < lo ) {
+                lo = minRemaining[i];
+            }
+            if( maxRemaining[i] > hi ) {
+                hi = maxRemaining[i];
+            }
+
+        }
+
+    }
+
+}
+
+/* Returns true if the whole of word matches the pattern
+ *
+ * Parameter: word - the word to match
+ */
+bool WildcardPattern::matches( const string & word ) const {
+
+    vector<uint64_t> set = vector<uint64_t>( numWords );
+    vector<uint64_t> next = vector<uint64_t>( numWords );
+    start( set.data() );
+    for( unsigned int i = 0; i < word.size(); i++ ) {
+        if( !step( set.data(), word[i], next.data() ) ) {
+            return false;
+        }
+        set.swap( next );
+    }
+    return accepts( set.data() );
+
+}
@@ -0,0 +1,162 @@
+/**
+ * The purpose of this hpp file is to define the WildcardPattern class, a
+ * query pattern compiled into a small nondeterministic automaton that
+ * DictionaryTrie walks in lockstep with its nodes. The pattern is a list
+ * of steps, each matching one character out of a class or, for a star,
+ * any run of characters. The automaton's states are the positions between
+ * steps and a set of states is a bitset, so stepping over one character
+ * is a few word-wide ANDs and shifts no matter how many states are live.
+ *
+ * Syntax (a pattern always has to match the whole word):
+ *   _ or ?      any one character
+ *   *           any run of characters, including none
+ *   [abc]       one of the listed characters, a-z style ranges allowed
+ *   [^abc]      any one character that is not listed
+ *   \c          the character c itself, for matching the special ones
+ *   anything else matches itself
+ *
+ * In UTF-8 mode a character is a whole code point rather than a byte. A
+ * wildcard then compiles to a step over the byte a code point starts with
+ * followed by a star over continuation bytes that can run for at most
+ * three of them, so the automaton still reads one byte at a time and the
+ * trie can stay keyed on bytes. Since the words are valid UTF-8, that
+ * star always stops at the end of the code point the step started.
+ * Classes may only list ASCII characters in this mode.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: Navarro and Raffinot "Flexible Pattern Matching in Strings"
+ *          (bit-parallel NFA simulation)
+ */
+#ifndef WILDCARD_PATTERN_HPP
+#define WILDCARD_PATTERN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class WildcardPattern {
+  private:
+    //number of steps, state numSteps is the accepting one
+    unsigned int numSteps;
+    //number of 64 bit words in a state set
+    unsigned int numWords;
+
+    //for every character, the set of steps whose class contains it
+    vector<uint64_t> charMasks;
+    //the set of steps that are stars. A star's bit in charMasks is set
+    //for the characters it can stay on rather than move on.
+    vector<uint64_t> starMask;
+    //for every step, the one character it matches, -1 for a star or class
+    vector<int> literals;
+    //for every state, the fewest and most characters still needed to
+    //reach the accepting state, SIZE_MAX for any number
+    vector<size_t> minRemaining;
+    vector<size_t> maxRemaining;
+
+    //the steps as they are parsed, before finish() builds the masks
+    vector<vector<bool>> stepChars;
+    vector<bool> stepStar;
+    //for every star, the most characters it can match, SIZE_MAX for any
+    vector<size_t> stepRun;
+
+    /* Adds a step matching the characters in chars, or a star step that
+     * matches a run of up to maxRun of them.
+     *
+     * Parameter: chars - the 256 flags of the characters to match
+     * Parameter: star - is the step a star
+     * Parameter: maxRun - the longest run a star can match
+     */
+    void addStep( const vector<bool> & chars, bool star,
+                  size_t maxRun = SIZE_MAX );
+
+    /* Adds the steps of one UTF-8 code point whose first byte is in
+     * leads: a step over the first byte and a star over the continuation
+     * bytes behind it.
+     *
+     * Parameter: leads - the 256 flags of the first bytes to match
+     */
+    void addCodePoint( const vector<bool> & leads );
+
+    /* Turns the list of steps into the masks and length tables */
+    void finish();
+
+    /* Adds to set the state after every live star, since a star can match
+     * no characters at all.
+     */
+    void closeStars( uint64_t* set ) const;
+
+  public:
+    /* Creates a pattern that matches nothing */
+    WildcardPattern();
+
+    /* Compiles pattern with the full syntax. Returns false, leaving a
+     * pattern that matches nothing, if pattern is malformed (an unclosed
+     * class, a trailing backslash, or in UTF-8 mode a class listing a
+     * non-ASCII character).
+     *
+     * Parameter: pattern - the pattern to compile
+     * Parameter: utf8 - do wildcards match whole UTF-8 code points
+     */
+    bool compile( const string & pattern, bool utf8 = false );
+
+    /* Compiles pattern with predictUnderscores() rules: an underscore is
+     * any one character and every other character matches itself.
+     *
+     * Parameter: pattern - the pattern to compile
+     * Parameter: utf8 - do underscores match whole UTF-8 code points
+     */
+    void compileUnderscores( const string & pattern, bool utf8 = false );
+
+    /* Returns the number of 64 bit words in a state set */
+    unsigned int setWords() const;
+
+    /* Fills set with the states the automaton starts in
+     *
+     * Parameter: set - the state set to fill
+     */
+    void start( uint64_t* set ) const;
+
+    /* Fills next with the states reached from set on character c and
+     * returns false if there are none, meaning no word continuing with c
+     * can match.
+     *
+     * Parameter: set - the current state set
+     * Parameter: c - the next character
+     * Parameter: next - the state set to fill
+     */
+    bool step( const uint64_t* set, char c, uint64_t* next ) const;
+
+    /* Returns true if set contains the accepting state
+     *
+     * Parameter: set - the state set to check
+     */
+    bool accepts( const uint64_t* set ) const;
+
+    /* Returns the only character set can step on, -1 if it can step on
+     * more than one and -2 if it cannot step at all.
+     *
+     * Parameter: set - the state set to check
+     */
+    int nextChar( const uint64_t* set ) const;
+
+    /* Sets lo and hi to the fewest and most characters a word still needs
+     * to be accepted from set, hi is SIZE_MAX if there is no upper limit.
+     *
+     * Parameter: set - the state set to check
+     * Parameter: lo - set to the fewest characters needed
+     * Parameter: hi - set to the most characters allowed
+     */
+    void remaining( const uint64_t* set, size_t & lo, size_t & hi ) const;
+
+    /* Returns true if the whole of word matches the pattern
+     *
+     * Parameter: word - the word to match
+     */
+    bool matches( const string & word ) const;
+};
+
+#endif  // WILDCARD_PATTERN_HPP
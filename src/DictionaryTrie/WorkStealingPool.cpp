@@ -0,0 +1,214 @@
+/**
+ * The purpose of this cpp file is to provide implementation for the
+ * methods of the WorkStealingPool class.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: std::thread doc, std::condition_variable doc,
+ *          Blumofe and Leiserson "Scheduling multithreaded computations
+ *          by work stealing"
+ */
+#include "WorkStealingPool.hpp"
+
+/* Creates a pool that runs loops on numThreads threads, the caller
+ * included, so numThreads - 1 threads are started. 0 means one thread
+ * per hardware thread.
+ *
+ * Parameter: numThreads - the number of threads to run loops on
+ */
+WorkStealingPool::WorkStealingPool( unsigned int numThreads ) {
+
+    if( numThreads == 0 ) {
+        numThreads = thread::hardware_concurrency();
+    }
+    if( numThreads == 0 ) {
+        numThreads = 1;
+    }
+
+    numQueues = numThreads;
+    queues = unique_ptr<WorkQueue[]>( new WorkQueue[numQueues] );
+    body.store( nullptr );
+    remaining.store( 0 );
+    generation = 0;
+    stopping = false;
+
+    for( unsigned int t = 1; t < numThreads; t++ ) {
+        workers.push_back( thread( &WorkStealingPool::workerMain, this, t ) );
+    }
+
+}
+
+/* Calls body(begin, end) on ranges of at most grain indices that
+ * together cover 0 .. count - 1, spread over the pool, and returns
+ * once all of them are done. The ranges run in no particular order,
+ * so body must be safe to call from several threads at once.
+ *
+ * Parameter: count - the number of loop indices
+ * Parameter: grain - the most indices handed out as one task
+ * Parameter: body - the function run on every range
+ */
+void WorkStealingPool::parallelFor( size_t count, size_t grain,
+                                    const function<void(size_t, size_t)> &
+                                        body ) {
+
+    if( count == 0 ) {
+        return;
+    }
+    if( grain == 0 ) {
+        grain = 1;
+    }
+
+    //with one thread there is nothing to deal out
+    if( numQueues == 1 ) {
+        for( size_t begin = 0; begin < count; begin += grain ) {
+            body( begin, count - begin < grain ? count : begin + grain );
+        }
+        return;
+    }
+
+    lock_guard<mutex> run( runLock );
+
+    //the body and the count have to be in place before the first range
+    //can be taken, a thread left over from the last loop may grab it
+    size_t numRanges = ( count + grain - 1 ) / grain;
+    this->body.store( &body );
+    remaining.store( numRanges );
+
+    //deal the ranges out in contiguous blocks so every thread starts on
+    //neighbouring items
+    size_t perQueue = ( numRanges + numQueues - 1 ) / numQueues;
+    for( unsigned int q = 0; q < numQueues; q++ ) {
+
+        lock_guard<mutex> guard( queues[q].lock );
+        for( size_t r = q * perQueue; r < ( q + 1 ) * perQueue &&
+             r < numRanges; r++ ) {
+            size_t end = ( r + 1 ) * grain;
+            queues[q].ranges.push_back(
+                Range{ r * grain, end < count ? end : count } );
+        }
+
+    }
+
+    {
+        lock_guard<mutex> guard( stateLock );
+        generation++;
+    }
+    wake.notify_all();
+
+    //help out, then wait for the ranges other threads are still running
+    workLoop( 0 );
+    unique_lock<mutex> guard( stateLock );
+    finished.wait( guard, [this]() { return remaining.load() == 0; } );
+    this->body.store( nullptr );
+
+}
+
+/* Returns the number of threads loops run on, the caller included */
+unsigned int WorkStealingPool::size() const {
+
+    return numQueues;
+
+}
+
+/* Takes a range from the back of thread self's own queue. Returns
+ * false if the queue is empty.
+ *
+ * Parameter: self - the index of the thread's queue
+ * Parameter: range - set to the range taken
+ */
+bool WorkStealingPool::popLocal( unsigned int self, Range & range ) {
+
+    lock_guard<mutex> guard( queues[self].lock );
+    if( queues[self].ranges.empty() ) {
+        return false;
+    }
+    range = queues[self].ranges.back();
+    queues[self].ranges.pop_back();
+    return true;
+
+}
+
+/* Takes a range from the front of some other thread's queue, trying
+ * them in turn starting after self. Returns false if all are empty.
+ *
+ * Parameter: self - the index of the stealing thread's queue
+ * Parameter: range - set to the range taken
+ */
+bool WorkStealingPool::steal( unsigned int self, Range & range ) {
+
+    for( unsigned int i = 1; i < numQueues; i++ ) {
+
+        WorkQueue & victim = queues[( self + i ) % numQueues];
+        lock_guard<mutex> guard( victim.lock );
+        if( !victim.ranges.empty() ) {
+            range = victim.ranges.front();
+            victim.ranges.pop_front();
+            return true;
+        }
+
+    }
+    return false;
+
+}
+
+/* Runs ranges, own ones first and then stolen ones, until no queue
+ * has any left.
+ *
+ * Parameter: self - the index of the running thread's queue
+ */
+void WorkStealingPool::workLoop( unsigned int self ) {
+
+    Range range;
+    while( popLocal( self, range ) || steal( self, range ) ) {
+
+        ( *body.load() )( range.begin, range.end );
+
+        //the last range to finish wakes up the caller
+        if( remaining.fetch_sub( 1 ) == 1 ) {
+            lock_guard<mutex> guard( stateLock );
+            finished.notify_all();
+        }
+
+    }
+
+}
+
+/* The loop of a pool thread: sleeps until a parallelFor() starts,
+ * helps run it and goes back to sleep, until the pool is destroyed.
+ *
+ * Parameter: self - the index of the thread's queue
+ */
+void WorkStealingPool::workerMain( unsigned int self ) {
+
+    uint64_t seen = 0;
+    while( true ) {
+
+        {
+            unique_lock<mutex> guard( stateLock );
+            wake.wait( guard, [&]() {
+                return stopping || generation != seen;
+            } );
+            if( stopping ) {
+                return;
+            }
+            seen = generation;
+        }
+        workLoop( self );
+
+    }
+
+}
+
+/* Wakes the pool threads up, tells them to exit and joins them */
+WorkStealingPool::~WorkStealingPool() {
+
+    {
+        lock_guard<mutex> guard( stateLock );
+        stopping = true;
+    }
+    wake.notify_all();
+    for( unsigned int t = 0; t < workers.size(); t++ ) {
+        workers[t].join();
+    }
+
+}
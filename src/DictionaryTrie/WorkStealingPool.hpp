@@ -0,0 +1,131 @@
+/**
+ * The purpose of this hpp file is to define the WorkStealingPool class, a
+ * small fixed-size thread pool for running a loop over many independent
+ * items, such as a burst of queries. The items are cut into ranges that
+ * are dealt out to one queue per thread. A thread works through its own
+ * queue from the back and, once it runs dry, steals ranges from the
+ * front of the other queues, so threads that got cheap items help out
+ * the ones that got expensive ones. The calling thread works along with
+ * the pool threads while it waits for the loop to finish.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: std::thread doc, std::condition_variable doc,
+ *          Blumofe and Leiserson "Scheduling multithreaded computations
+ *          by work stealing"
+ */
+#ifndef WORK_STEALING_POOL_HPP
+#define WORK_STEALING_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+class WorkStealingPool {
+  private:
+    /** A range of loop indices [begin, end) that is run as one task */
+    struct Range {
+        size_t begin;
+        size_t end;
+    };
+
+    /** The ranges dealt to one thread, on its own cache line */
+    struct alignas(64) WorkQueue {
+        mutex lock;
+        deque<Range> ranges;
+    };
+
+    //the pool threads, the caller of parallelFor() is thread 0
+    vector<thread> workers;
+    //one queue for every thread, including the caller
+    unique_ptr<WorkQueue[]> queues;
+    unsigned int numQueues;
+
+    //the loop body of the running parallelFor(), set before its ranges
+    //are queued so whoever takes a range sees the right body
+    atomic<const function<void(size_t, size_t)>*> body;
+    //number of ranges of the running parallelFor() not finished yet
+    atomic<size_t> remaining;
+
+    //guards generation and stopping, and is used to wait and wake
+    mutex stateLock;
+    condition_variable wake;
+    condition_variable finished;
+    //bumped for every parallelFor() so sleeping threads know to look
+    uint64_t generation;
+    bool stopping;
+
+    //only one parallelFor() runs at a time
+    mutex runLock;
+
+    /* Takes a range from the back of thread self's own queue. Returns
+     * false if the queue is empty.
+     *
+     * Parameter: self - the index of the thread's queue
+     * Parameter: range - set to the range taken
+     */
+    bool popLocal( unsigned int self, Range & range );
+
+    /* Takes a range from the front of some other thread's queue, trying
+     * them in turn starting after self. Returns false if all are empty.
+     *
+     * Parameter: self - the index of the stealing thread's queue
+     * Parameter: range - set to the range taken
+     */
+    bool steal( unsigned int self, Range & range );
+
+    /* Runs ranges, own ones first and then stolen ones, until no queue
+     * has any left.
+     *
+     * Parameter: self - the index of the running thread's queue
+     */
+    void workLoop( unsigned int self );
+
+    /* The loop of a pool thread: sleeps until a parallelFor() starts,
+     * helps run it and goes back to sleep, until the pool is destroyed.
+     *
+     * Parameter: self - the index of the thread's queue
+     */
+    void workerMain( unsigned int self );
+
+  public:
+    /* Creates a pool that runs loops on numThreads threads, the caller
+     * included, so numThreads - 1 threads are started. 0 means one thread
+     * per hardware thread.
+     *
+     * Parameter: numThreads - the number of threads to run loops on
+     */
+    explicit WorkStealingPool( unsigned int numThreads );
+
+    WorkStealingPool( const WorkStealingPool & other ) = delete;
+    WorkStealingPool & operator=( const WorkStealingPool & other ) = delete;
+
+    /* Calls body(begin, end) on ranges of at most grain indices that
+     * together cover 0 .. count - 1, spread over the pool, and returns
+     * once all of them are done. The ranges run in no particular order,
+     * so body must be safe to call from several threads at once.
+     *
+     * Parameter: count - the number of loop indices
+     * Parameter: grain - the most indices handed out as one task
+     * Parameter: body - the function run on every range
+     */
+    void parallelFor( size_t count, size_t grain,
+                      const function<void(size_t, size_t)> & body );
+
+    /* Returns the number of threads loops run on, the caller included */
+    unsigned int size() const;
+
+    /* Wakes the pool threads up, tells them to exit and joins them */
+    ~WorkStealingPool();
+};
+
+#endif  // WORK_STEALING_POOL_HPP
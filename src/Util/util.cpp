@@ -3,8 +3,124 @@
  * benchmarking DictionaryTrie
  */
 #include "util.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
 #include <iostream>
-#include <sstream>
+#include <thread>
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* Returns true for the characters operator>> treats as whitespace */
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+           c == '\r';
+}
+
+namespace {
+
+/** A whole file in memory: mapped if possible, else read in one block */
+class FileBuffer {
+  private:
+    void* mapped;
+    size_t mappedSize;
+    string block;
+    const char* buffer;
+    size_t length;
+
+  public:
+    FileBuffer() : mapped(MAP_FAILED), mappedSize(0), buffer(nullptr),
+                   length(0) {}
+
+    FileBuffer(const FileBuffer& other) = delete;
+    FileBuffer& operator=(const FileBuffer& other) = delete;
+
+    /* Maps or reads the file. Returns false if it cannot be opened */
+    bool open(const string& fileName) {
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            return false;
+        }
+        mappedSize = info.st_size;
+        if (mappedSize > 0) {
+            mapped = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+        if (mapped != MAP_FAILED) {
+            buffer = (const char*)mapped;
+            length = mappedSize;
+        } else {
+            ifstream in(fileName, ios::binary);
+            block.assign(istreambuf_iterator<char>(in),
+                         istreambuf_iterator<char>());
+            buffer = block.data();
+            length = block.size();
+        }
+        return true;
+    }
+
+    const char* data() const { return buffer; }
+
+    size_t size() const { return length; }
+
+    ~FileBuffer() {
+        if (mapped != MAP_FAILED) munmap(mapped, mappedSize);
+    }
+};
+
+/** One parsed dictionary line */
+struct ParsedEntry {
+    string_view word;
+    unsigned int freq;
+};
+
+/** The entries parsed from one chunk of the file by one thread */
+struct ParsedChunk {
+    vector<ParsedEntry> entries;
+    // phrases that needed their whitespace collapsed; a deque never moves
+    // its strings, so the views into them stay valid
+    deque<string> collapsed;
+    // number of entries per first byte
+    vector<size_t> perByte = vector<size_t>(256, 0);
+    unsigned int lines = 0;
+
+    /* Parses every line of text, which must end at a line boundary */
+    void parse(string_view text) {
+        unsigned int freq;
+        string scratch;
+        string_view word;
+        size_t pos = 0;
+        while (pos < text.size()) {
+            size_t end = text.find('\n', pos);
+            if (end == string_view::npos) end = text.size();
+            if (Utils::parseLine(text.substr(pos, end - pos), freq, word,
+                                 scratch)) {
+                if (word.data() == scratch.data()) {
+                    collapsed.push_back(scratch);
+                    word = collapsed.back();
+                }
+                if (!word.empty()) {
+                    entries.push_back(ParsedEntry{word, freq});
+                    perByte[(unsigned char)word[0]]++;
+                }
+            }
+            lines++;
+            pos = end + 1;
+        }
+    }
+};
+
+}  // namespace
 
 /* Starts the timer. Saves the current time. */
 void Timer::begin_timer() { start = std::chrono::high_resolution_clock::now(); }
@@ -21,63 +137,198 @@ long long Timer::end_timer() {
         .count();
 }
 
-/* Load all the words in word stream into the dictionary trie */
-void Utils::loadDict(DictionaryTrie& dict, istream& words) {
+/* Returns the throughput in megabytes per second */
+double LoadStats::megabytesPerSecond() const {
+    if (nanoseconds <= 0) return 0;
+    return (bytes / 1e6) / (nanoseconds / 1e9);
+}
+
+/* Creates an empty histogram keeping precision significant bits */
+LatencyHistogram::LatencyHistogram(unsigned int precision)
+    : precision(precision), total(0), minValue(0), maxValue(0), sum(0) {
+    // exact values below 2^precision, then half as many buckets for
+    // every power of two above it
+    size_t exact = (size_t)1 << precision;
+    counts.assign(exact + (64 - precision) * (exact / 2), 0);
+}
+
+/* Returns the bucket value falls into */
+size_t LatencyHistogram::indexOf(long long value) const {
+    unsigned long long v = (unsigned long long)value;
+    size_t exact = (size_t)1 << precision;
+    if (v < exact) return v;
+
+    // keep the top precision bits, the shift picks the power of two
+    unsigned int top = 63 - __builtin_clzll(v);
+    unsigned int shift = top - precision + 1;
+    size_t mantissa = v >> shift;
+    return exact + (shift - 1) * (exact / 2) + (mantissa - exact / 2);
+}
+
+/* Returns the biggest value that falls into the bucket at index */
+long long LatencyHistogram::highestEquivalent(size_t index) const {
+    size_t exact = (size_t)1 << precision;
+    if (index < exact) return index;
+
+    size_t rest = index - exact;
+    unsigned int shift = rest / (exact / 2) + 1;
+    unsigned long long mantissa = rest % (exact / 2) + exact / 2;
+    unsigned long long high = ((mantissa + 1) << shift) - 1;
+    return high > (unsigned long long)LLONG_MAX ? LLONG_MAX : high;
+}
+
+/* Counts one value, negative values are counted as 0 */
+void LatencyHistogram::record(long long value) {
+    if (value < 0) value = 0;
+    counts[indexOf(value)]++;
+    if (total == 0 || value < minValue) minValue = value;
+    if (total == 0 || value > maxValue) maxValue = value;
+    total++;
+    sum += value;
+}
+
+/* Adds the counts of other, which must have the same precision */
+void LatencyHistogram::add(const LatencyHistogram& other) {
+    if (other.total == 0) return;
+    for (size_t i = 0; i < counts.size(); i++) counts[i] += other.counts[i];
+    if (total == 0 || other.minValue < minValue) minValue = other.minValue;
+    if (total == 0 || other.maxValue > maxValue) maxValue = other.maxValue;
+    total += other.total;
+    sum += other.sum;
+}
+
+/* Returns the number of values counted */
+unsigned long long LatencyHistogram::count() const { return total; }
+
+/* Returns the smallest value counted, 0 if there are none */
+long long LatencyHistogram::min() const { return minValue; }
+
+/* Returns the biggest value counted, 0 if there are none */
+long long LatencyHistogram::max() const { return maxValue; }
+
+/* Returns the mean of the values counted, 0 if there are none */
+double LatencyHistogram::mean() const {
+    return total == 0 ? 0 : sum / total;
+}
+
+/* Returns the value the given fraction of the counted values are at or
+ * below, to the precision of its bucket (the top of the bucket, so it
+ * never under-reports).
+ */
+long long LatencyHistogram::valueAt(double fraction) const {
+    if (total == 0) return 0;
+    unsigned long long wanted = (unsigned long long)(fraction * total + 0.5);
+    if (wanted < 1) wanted = 1;
+    if (wanted > total) wanted = total;
+
+    unsigned long long seen = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        seen += counts[i];
+        if (seen >= wanted) {
+            return std::min(std::max(highestEquivalent(i), minValue),
+                            maxValue);
+        }
+    }
+    return maxValue;
+}
+
+/* Writes the percentile distribution like HdrHistogram does, one row per
+ * halving of the remaining fraction (50%, 75%, 87.5%, ...) down to the
+ * last value. Values are divided by scale first, e.g. 1000 to print
+ * nanoseconds as microseconds.
+ */
+void LatencyHistogram::printDistribution(ostream& out, double scale) const {
+    char row[96];
+    snprintf(row, sizeof(row), "%14s %14s %12s %14s\n", "Value",
+             "Percentile", "TotalCount", "1/(1-Percentile)");
+    out << row;
+
+    double remaining = 1.0;
+    while (true) {
+        double fraction = 1.0 - remaining;
+        unsigned long long below =
+            (unsigned long long)(fraction * total + 0.5);
+        bool last = below >= total;
+        if (last) fraction = 1.0;
+
+        long long value = fraction == 0 ? minValue : valueAt(fraction);
+        if (last) {
+            snprintf(row, sizeof(row), "%14.3f %14.6f %12llu %14s\n",
+                     value / scale, 1.0, total, "inf");
+            out << row;
+            break;
+        }
+        snprintf(row, sizeof(row), "%14.3f %14.6f %12llu %14.2f\n",
+                 value / scale, fraction, below, 1.0 / remaining);
+        out << row;
+        remaining /= 2;
+    }
+}
+
+/* Opens the counter, stopped at zero. Only user space misses are counted,
+ * so the time the kernel spends on the process does not show up.
+ */
+CacheMissCounter::CacheMissCounter() {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/* Returns true if the machine lets the process count cache misses */
+bool CacheMissCounter::available() const { return fd >= 0; }
+
+/* Zeroes the counter and starts counting */
+void CacheMissCounter::begin() {
+    if (fd < 0) return;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+/* Stops counting and returns the misses since begin(), -1 if the counter
+ * is unavailable
+ */
+long long CacheMissCounter::end() {
+    if (fd < 0) return -1;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    long long misses = 0;
+    if (read(fd, &misses, sizeof(misses)) != sizeof(misses)) return -1;
+    return misses;
+}
+
+/* Closes the counter */
+CacheMissCounter::~CacheMissCounter() {
+    if (fd >= 0) close(fd);
+}
+
+/* Load all the words in word stream into the dictionary */
+void Utils::loadDict(Dictionary& dict, istream& words) {
     unsigned int freq;
     string data = "";
-    string tempWord;
-    string word;
-    vector<string> wordString;
-    unsigned int i;
+    string scratch;
+    string_view word;
     while (getline(words, data)) {
-        tempWord = "";
-        word = "";
-        data = data + " .";
-        istringstream iss(data);
-        iss >> freq;
-        while (1) {
-            iss >> tempWord;
-            if (tempWord == ".") break;
-            if (tempWord.length() > 0) wordString.push_back(tempWord);
-        }
-        for (i = 0; i < wordString.size(); i++) {
-            if (i > 0) word = word + " ";
-            word = word + wordString[i];
-        }
-        dict.insert(word, freq);
-        wordString.clear();
+        if (parseLine(data, freq, word, scratch)) dict.insert(word, freq);
         if (words.eof()) break;
     }
 }
 
-/* Load numWords from words stream into the dictionary trie */
-void Utils::loadDict(DictionaryTrie& dict, istream& words,
+/* Load numWords from words stream into the dictionary */
+void Utils::loadDict(Dictionary& dict, istream& words,
                      unsigned int numWords) {
     unsigned int freq;
     string data = "";
-    string tempWord;
-    string word;
-    vector<string> wordString;
-    unsigned int i;
+    string scratch;
+    string_view word;
     unsigned int j = 0;
     for (; j < numWords; j++) {
-        getline(words, data);
-        tempWord = "";
-        word = "";
-        data = data + " .";
-        istringstream iss(data);
-        iss >> freq;
-        while (1) {
-            iss >> tempWord;
-            if (tempWord == ".") break;
-            if (tempWord.length() > 0) wordString.push_back(tempWord);
-        }
-        for (i = 0; i < wordString.size(); i++) {
-            if (i > 0) word = word + " ";
-            word = word + wordString[i];
-        }
-        dict.insert(word, freq);
-        wordString.clear();
+        if (!getline(words, data)) break;
+        if (parseLine(data, freq, word, scratch)) dict.insert(word, freq);
         if (words.eof()) break;
     }
 }
@@ -86,28 +337,245 @@ void Utils::loadDict(DictionaryTrie& dict, istream& words,
 void Utils::loadDict(vector<string>& dict, istream& words) {
     unsigned int junk;
     string data = "";
-    string tempWord;
-    string word;
-    vector<string> wordString;
-    unsigned int i;
+    string scratch;
+    string_view word;
 
     while (getline(words, data)) {
-        tempWord = "";
-        word = "";
-        data = data + " .";
-        istringstream iss(data);
-        iss >> junk;
-        while (1) {
-            iss >> tempWord;
-            if (tempWord == ".") break;
-            if (tempWord.length() > 0) wordString.push_back(tempWord);
+        if (parseLine(data, junk, word, scratch)) dict.push_back(string(word));
+        if (words.eof()) break;
+    }
+}
+
+/* Load up to numWords from the file into the dictionary. The file is
+ * memory-mapped (or read in one block) and every word is handed to
+ * insert() as a view into that buffer. Returns false if the file
+ * could not be read. stats, if given, is filled in.
+ */
+bool Utils::loadDictFile(Dictionary& dict, const string& fileName,
+                         unsigned int numWords, LoadStats* stats) {
+    return scanDictFile(
+        fileName, numWords,
+        [&dict](string_view word, unsigned int freq) {
+            dict.insert(word, freq);
+        },
+        stats);
+}
+
+/* Scan up to numWords lines of the file in place, calling onEntry with
+ * each word and its frequency. The word view is only valid during the
+ * call. Returns false if the file could not be read.
+ */
+bool Utils::scanDictFile(
+    const string& fileName, unsigned int numWords,
+    const function<void(string_view, unsigned int)>& onEntry,
+    LoadStats* stats) {
+    Timer timer;
+    timer.begin_timer();
+
+    FileBuffer file;
+    if (!file.open(fileName)) return false;
+    const char* buffer = file.data();
+    size_t size = file.size();
+
+    unsigned int freq;
+    string scratch;
+    string_view word;
+    unsigned int lines = 0;
+    size_t pos = 0;
+    while (pos < size && lines < numWords) {
+        const char* eol = (const char*)memchr(buffer + pos, '\n', size - pos);
+        size_t end = eol == nullptr ? size : eol - buffer;
+        if (parseLine(string_view(buffer + pos, end - pos), freq, word,
+                      scratch)) {
+            onEntry(word, freq);
         }
-        for (i = 0; i < wordString.size(); i++) {
-            if (i > 0) word = word + " ";
-            word = word + wordString[i];
+        lines++;
+        pos = end + 1;
+    }
+
+    if (stats != nullptr) {
+        stats->bytes = pos < size ? pos : size;
+        stats->lines = lines;
+        stats->nanoseconds = timer.end_timer();
+    }
+    return true;
+}
+
+/* Load all the words in the file, which should be sorted, into the
+ * dictionary with DictionaryTrie's sorted bulk load. An unsorted file
+ * still loads correctly, just at the speed of insert(). Returns false
+ * if the file could not be read. sorted, if given, is set to whether
+ * the file really was in order.
+ */
+bool Utils::loadDictSorted(DictionaryTrie& dict, const string& fileName,
+                           LoadStats* stats, bool* sorted) {
+    dict.beginSorted();
+    bool read = scanDictFile(
+        fileName, UINT_MAX,
+        [&dict](string_view word, unsigned int freq) {
+            dict.appendSorted(word, freq);
+        },
+        stats);
+    bool inOrder = dict.endSorted();
+    if (sorted != nullptr) *sorted = inOrder;
+    return read;
+}
+
+/* Load all the words in the file into the dictionary using numThreads
+ * threads. The result is the same as a serial load. Returns false if
+ * the file could not be read.
+ */
+bool Utils::loadDictParallel(DictionaryTrie& dict, const string& fileName,
+                             unsigned int numThreads, LoadStats* stats) {
+    Timer timer;
+    timer.begin_timer();
+    if (numThreads == 0) numThreads = 1;
+
+    FileBuffer file;
+    if (!file.open(fileName)) return false;
+    const char* buffer = file.data();
+    size_t size = file.size();
+
+    // Cut the buffer into one chunk per thread, ending chunks at newlines
+    vector<size_t> cuts(1, 0);
+    for (unsigned int t = 1; t < numThreads; t++) {
+        size_t cut = max(cuts.back(), size * t / numThreads);
+        const char* eol = (const char*)memchr(buffer + cut, '\n', size - cut);
+        cuts.push_back(eol == nullptr ? size : eol - buffer + 1);
+    }
+    cuts.push_back(size);
+
+    // Phase 1: every thread parses its chunk into (word, freq) entries
+    vector<ParsedChunk> chunks(numThreads);
+    vector<thread> workers;
+    for (unsigned int t = 0; t < numThreads; t++) {
+        workers.push_back(thread([&, t]() {
+            chunks[t].parse(
+                string_view(buffer + cuts[t], cuts[t + 1] - cuts[t]));
+        }));
+    }
+    for (unsigned int t = 0; t < numThreads; t++) workers[t].join();
+    workers.clear();
+
+    // Hand out first bytes so every shard gets about the same number of
+    // words, biggest first to whichever shard has the fewest so far
+    vector<size_t> perByte(256, 0);
+    unsigned int lines = 0;
+    for (unsigned int t = 0; t < numThreads; t++) {
+        for (unsigned int b = 0; b < 256; b++) {
+            perByte[b] += chunks[t].perByte[b];
         }
-        dict.push_back(word);
-        wordString.clear();
-        if (words.eof()) break;
+        lines += chunks[t].lines;
+    }
+    vector<unsigned int> bytes(256);
+    for (unsigned int b = 0; b < 256; b++) bytes[b] = b;
+    sort(bytes.begin(), bytes.end(),
+         [&perByte](unsigned int a, unsigned int b) {
+             return perByte[a] > perByte[b];
+         });
+    vector<size_t> load(numThreads, 0);
+    vector<unsigned int> owner(256, 0);
+    for (unsigned int b : bytes) {
+        unsigned int least =
+            min_element(load.begin(), load.end()) - load.begin();
+        owner[b] = least;
+        load[least] += perByte[b];
+    }
+
+    // Phase 2: every thread builds the shard for its first bytes, reading
+    // the chunks in file order so duplicates resolve like a serial load
+    vector<DictionaryTrie*> shards(numThreads);
+    for (unsigned int t = 0; t < numThreads; t++) {
+        workers.push_back(thread([&, t]() {
+            shards[t] = new DictionaryTrie();
+            // the shards refuse the same words dict would
+            shards[t]->setUtf8(dict.isUtf8());
+            for (unsigned int c = 0; c < numThreads; c++) {
+                for (const ParsedEntry& entry : chunks[c].entries) {
+                    if (owner[(unsigned char)entry.word[0]] == t) {
+                        shards[t]->insert(entry.word, entry.freq);
+                    }
+                }
+            }
+        }));
+    }
+    for (unsigned int t = 0; t < numThreads; t++) workers[t].join();
+
+    // Stitch: the shards have disjoint first bytes, so this only links
+    // their subtrees under dict's root
+    bool stitched = true;
+    for (unsigned int t = 0; t < numThreads; t++) {
+        stitched = stitched && dict.absorb(*shards[t]);
+    }
+    // dict already held some of the first bytes, insert the rest one by one
+    if (!stitched) {
+        for (unsigned int c = 0; c < numThreads; c++) {
+            for (const ParsedEntry& entry : chunks[c].entries) {
+                dict.insert(entry.word, entry.freq);
+            }
+        }
+    }
+    for (unsigned int t = 0; t < numThreads; t++) delete shards[t];
+
+    if (stats != nullptr) {
+        stats->bytes = size;
+        stats->lines = lines;
+        stats->nanoseconds = timer.end_timer();
+    }
+    return true;
+}
+
+/* Parse one dictionary line: the frequency, then the words of the
+ * phrase joined by single spaces. The phrase is a view into line
+ * unless its whitespace had to be collapsed, then it views scratch.
+ * Returns false if the line has no frequency.
+ */
+bool Utils::parseLine(string_view line, unsigned int& freq,
+                      string_view& word, string& scratch) {
+    size_t i = 0;
+    size_t n = line.size();
+    while (i < n && isSpace(line[i])) i++;
+    if (i == n || line[i] < '0' || line[i] > '9') return false;
+    freq = 0;
+    while (i < n && line[i] >= '0' && line[i] <= '9') {
+        freq = freq * 10 + (line[i] - '0');
+        i++;
+    }
+
+    // [begin, end) is the phrase while it is still a slice of line
+    size_t begin = 0;
+    size_t end = 0;
+    bool first = true;
+    bool inScratch = false;
+    while (true) {
+        while (i < n && isSpace(line[i])) i++;
+        if (i == n) break;
+        size_t tokenStart = i;
+        while (i < n && !isSpace(line[i])) i++;
+        string_view token = line.substr(tokenStart, i - tokenStart);
+        // a lone "." ends the phrase, like the old " ." sentinel did
+        if (token == ".") break;
+
+        if (first) {
+            begin = tokenStart;
+            end = i;
+            first = false;
+        } else if (!inScratch && tokenStart == end + 1 && line[end] == ' ') {
+            end = i;
+        } else {
+            if (!inScratch) {
+                scratch.assign(line.data() + begin, end - begin);
+                inScratch = true;
+            }
+            scratch += ' ';
+            scratch.append(token.data(), token.size());
+        }
+    }
+
+    if (inScratch) {
+        word = string_view(scratch);
+    } else {
+        word = line.substr(begin, end - begin);
     }
+    return true;
 }
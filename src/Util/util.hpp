@@ -7,7 +7,10 @@
 #define UTIL_HPP
 
 #include <chrono>
+#include <climits>
+#include <functional>
 #include <iostream>
+#include <string_view>
 #include <vector>
 #include "DictionaryTrie.hpp"
 
@@ -28,18 +31,172 @@ class Timer {
     long long end_timer();
 };
 
+/** What a buffer-based load scanned and how long it took */
+struct LoadStats {
+    //bytes of the file that were scanned
+    size_t bytes;
+    //lines read, blank or unparsable ones included
+    unsigned int lines;
+    //time spent scanning (and inserting) in nanoseconds
+    long long nanoseconds;
+
+    /* Returns the throughput in megabytes per second */
+    double megabytesPerSecond() const;
+};
+
+/** A histogram of latencies in the style of HdrHistogram. Values up to
+ * 2^precision are counted exactly, and bigger ones go into buckets that
+ * split every power of two into 2^(precision - 1) parts. Every bucket is
+ * therefore within 1 / 2^(precision - 1) of the values it holds, and the
+ * whole range of long long takes a few thousand counters. Histograms with
+ * the same precision can be added together, e.g. one per thread.
+ */
+class LatencyHistogram {
+  private:
+    //significant bits kept of every value
+    unsigned int precision;
+    //how many values fell into each bucket
+    vector<unsigned long long> counts;
+    unsigned long long total;
+    long long minValue;
+    long long maxValue;
+    //sum of all the values, for the mean
+    double sum;
+
+    /* Returns the bucket value falls into */
+    size_t indexOf(long long value) const;
+
+    /* Returns the biggest value that falls into the bucket at index */
+    long long highestEquivalent(size_t index) const;
+
+  public:
+    /* Creates an empty histogram keeping precision significant bits */
+    LatencyHistogram(unsigned int precision = 7);
+
+    /* Counts one value, negative values are counted as 0 */
+    void record(long long value);
+
+    /* Adds the counts of other, which must have the same precision */
+    void add(const LatencyHistogram& other);
+
+    /* Returns the number of values counted */
+    unsigned long long count() const;
+
+    /* Returns the smallest value counted, 0 if there are none */
+    long long min() const;
+
+    /* Returns the biggest value counted, 0 if there are none */
+    long long max() const;
+
+    /* Returns the mean of the values counted, 0 if there are none */
+    double mean() const;
+
+    /* Returns the value the given fraction of the counted values are at or
+     * below, to the precision of its bucket (the top of the bucket, so
+     * it never under-reports).
+     */
+    long long valueAt(double fraction) const;
+
+    /* Writes the percentile distribution like HdrHistogram does, one row
+     * per halving of the remaining fraction (50%, 75%, 87.5%, ...) down to
+     * the last value. Values are divided by scale first, e.g. 1000 to
+     * print nanoseconds as microseconds.
+     */
+    void printDistribution(ostream& out, double scale) const;
+};
+
+/** Counts the last level cache misses of the calling thread through the
+ * kernel's hardware performance counters (perf_event_open). Machines
+ * without them, such as most virtual machines, or kernels that do not let
+ * the process read them, leave the counter unavailable, and it then reads
+ * -1.
+ */
+class CacheMissCounter {
+  private:
+    //the perf event file descriptor, -1 if the counter is unavailable
+    int fd;
+
+  public:
+    /* Opens the counter, stopped at zero */
+    CacheMissCounter();
+
+    CacheMissCounter(const CacheMissCounter& other) = delete;
+    CacheMissCounter& operator=(const CacheMissCounter& other) = delete;
+
+    /* Returns true if the machine lets the process count cache misses */
+    bool available() const;
+
+    /* Zeroes the counter and starts counting */
+    void begin();
+
+    /* Stops counting and returns the misses since begin(), -1 if the
+     * counter is unavailable
+     */
+    long long end();
+
+    /* Closes the counter */
+    ~CacheMissCounter();
+};
+
 /** Contains useful functions to parse input file */
 class Utils {
   public:
     /* Load the words in the file into the dictionary */
-    void static loadDict(DictionaryTrie& dict, istream& words);
+    void static loadDict(Dictionary& dict, istream& words);
 
     /* Load numWords from words stream into the dictionary */
-    void static loadDict(DictionaryTrie& dict, istream& words,
+    void static loadDict(Dictionary& dict, istream& words,
                          unsigned int numWords);
 
     /* Load all the words in word stream into a vector */
     void static loadDict(vector<string>& dict, istream& words);
+
+    /* Load up to numWords from the file into the dictionary. The file is
+     * memory-mapped (or read in one block) and every word is handed to
+     * insert() as a view into that buffer. Returns false if the file
+     * could not be read. stats, if given, is filled in.
+     */
+    bool static loadDictFile(Dictionary& dict, const string& fileName,
+                             unsigned int numWords = UINT_MAX,
+                             LoadStats* stats = nullptr);
+
+    /* Load all the words in the file, which should be sorted, into the
+     * dictionary with DictionaryTrie's sorted bulk load. An unsorted file
+     * still loads correctly, just at the speed of insert(). Returns false
+     * if the file could not be read. sorted, if given, is set to whether
+     * the file really was in order.
+     */
+    bool static loadDictSorted(DictionaryTrie& dict, const string& fileName,
+                               LoadStats* stats = nullptr,
+                               bool* sorted = nullptr);
+
+    /* Load all the words in the file into the dictionary using numThreads
+     * threads. The file is cut into chunks that are parsed in parallel,
+     * then every thread builds a shard holding the words of its share of
+     * first bytes, and the shards are stitched under dict's root. The
+     * result is the same as a serial load. Returns false if the file
+     * could not be read.
+     */
+    bool static loadDictParallel(DictionaryTrie& dict, const string& fileName,
+                                 unsigned int numThreads,
+                                 LoadStats* stats = nullptr);
+
+    /* Scan up to numWords lines of the file in place, calling onEntry with
+     * each word and its frequency. The word view is only valid during the
+     * call. Returns false if the file could not be read.
+     */
+    bool static scanDictFile(
+        const string& fileName, unsigned int numWords,
+        const function<void(string_view, unsigned int)>& onEntry,
+        LoadStats* stats = nullptr);
+
+    /* Parse one dictionary line: the frequency, then the words of the
+     * phrase joined by single spaces. The phrase is a view into line
+     * unless its whitespace had to be collapsed, then it views scratch.
+     * Returns false if the line has no frequency.
+     */
+    bool static parseLine(string_view line, unsigned int& freq,
+                          string_view& word, string& scratch);
 };
 
 #endif  // UTIL_HPP
@@ -3,7 +3,8 @@
  * its fullest potential. The user passes in a single file as an argument to
  * build up the trie and then the user is put into a command loop where they
  * can search for the predictions to a prefix and get a certain number of 
- * predictions out of the function.
+ * predictions out of the function. Setting DICTIONARY_BACKEND=tst or radix
+ * runs it on the ternary search tree or the radix trie instead.
  *
  * Author: Christian Kouris
  * Email: ckouris@ucsd.edu
@@ -13,6 +14,8 @@
 #include <iostream>
 #include <sstream>
 #include <vector>
+#include "Dictionary.hpp"
+#include "DictionarySnapshot.hpp"
 #include "DictionaryTrie.hpp"
 #include "util.hpp"
 
@@ -50,7 +53,8 @@ bool fileValid(const char* fileName) {
  * cout << completion << endl;
  * cout << "Continue? (y/n)" << endl;
  *
- * arg 1 - Input file name (in format like freq_dict.txt)
+ * arg 1 - Input file name (in format like freq_dict.txt), or a snapshot
+ *         written by the snapshot executable
  */
 int main(int argc, char** argv) {
     const int NUM_ARG = 2;
@@ -61,17 +65,28 @@ int main(int argc, char** argv) {
     }
     if (!fileValid(argv[1])) return -1;
 
-    DictionaryTrie* dt = new DictionaryTrie();
+    unique_ptr<Dictionary> dt = Dictionary::create(
+        Dictionary::defaultBackend());
+    DictionarySnapshot snapshot;
 
     // Read all the tokens of the file in order to get every word
     cout << "Reading file: " << argv[1] << endl;
 
-    ifstream in;
-    in.open(argv[1], ios::binary);
     string word;
-
-    Utils::loadDict(*dt, in);
-    in.close();
+    // A snapshot is mapped and queried in place instead of being loaded
+    bool useSnapshot = DictionarySnapshot::isSnapshot(argv[1]);
+    if (useSnapshot) {
+        if (!snapshot.open(argv[1])) {
+            cout << "Invalid snapshot file." << endl;
+            return -1;
+        }
+    } else {
+        Utils::loadDictFile(*dt, argv[1]);
+    }
+    // A library built to count query work also describes the trie
+    DictionaryTrie* trie = dynamic_cast<DictionaryTrie*>(dt.get());
+    bool profile = QueryStats::ENABLED && !useSnapshot && trie != nullptr;
+    if (profile) trie->trieStats().print(cout);
 
     char cont = 'y';
     unsigned int numberOfCompletions;
@@ -88,7 +103,8 @@ int main(int argc, char** argv) {
 
         if( isWildCard ) {
 
-            vector<string> underscoreList = 
+            vector<string> underscoreList = useSnapshot ?
+                snapshot.predictUnderscores( word, numberOfCompletions ) :
                 dt->predictUnderscores( word, numberOfCompletions );
             for( unsigned int i = 0; i < underscoreList.size(); i++ ) {
                 cout << underscoreList[i] << endl;
@@ -96,17 +112,22 @@ int main(int argc, char** argv) {
         
         } else {
             
-            vector<string> completionList = 
+            vector<string> completionList = useSnapshot ?
+                snapshot.predictCompletions( word, numberOfCompletions ) :
                 dt->predictCompletions( word, numberOfCompletions );
             for( unsigned int i = 0; i < completionList.size(); i++ ) {
                 cout << completionList[i] << endl;
             }
         
         }
+        if (profile) {
+            cout << "Profile: ";
+            DictionaryTrie::lastQueryStats().print(cout);
+            cout << endl;
+        }
         cout << "Continue? (y/n)" << endl;
         cin >> cont;
         cin.ignore();
     }
-    delete dt;
     return 0;
 }
@@ -0,0 +1,159 @@
+/**
+ * This program is a microbenchmark of child lookup, the step every trie
+ * walk repeats once per character. For a range of fan-outs it builds many
+ * ChildMaps with random keys, then times random lookups into them, both
+ * of keys that are there and keys that are not, and does the same with
+ * an unordered_map<char, Node*>, the map the trie started out with. The
+ * maps are spread over more memory than the caches hold, like the nodes
+ * of a real trie. The report says whether ChildMap's key search was built
+ * with SSE2 or the scalar loop (-Dchild_map_simd=false), so the two
+ * builds can be compared.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: Leis et al. "The Adaptive Radix Tree: ARTful Indexing for
+ *          Main-Memory Databases"
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include "ChildMap.hpp"
+#include "NodeArena.hpp"
+#include "util.hpp"
+
+using namespace std;
+
+/** Stand-in node type, the maps only ever store pointers to it */
+struct BenchNode {
+    int id;
+};
+
+/** One lookup: which map and which key */
+struct Lookup {
+    unsigned int map;
+    char key;
+};
+
+// every map of a fan-out gets its own node to point to
+static BenchNode node;
+
+/* Returns the nanoseconds per lookup of find over the lookups, and adds
+ * the number of children found to found so the loop is not optimized
+ * away.
+ */
+template <typename Find>
+double timeLookups(const vector<Lookup>& lookups, Find find,
+                   unsigned long long& found) {
+    Timer timer;
+    timer.begin_timer();
+    for (const Lookup& lookup : lookups) {
+        found += find(lookup) != nullptr;
+    }
+    long long time = timer.end_timer();
+    return (double)time / lookups.size();
+}
+
+/* arg 1 - (optional) number of lookups timed per fan-out, default 2000000
+ */
+int main(int argc, char** argv) {
+    unsigned int numLookups = 2000000;
+    if (argc > 1) numLookups = strtoul(argv[1], nullptr, 10);
+    if (numLookups == 0) {
+        cout << "Usage: ./benchchildmap [lookups per fan-out]" << endl;
+        return -1;
+    }
+
+#ifdef CHILD_MAP_SSE2
+    cout << "Key search: SSE2" << endl;
+#else
+    cout << "Key search: scalar" << endl;
+#endif
+
+    const unsigned int fanOuts[] = {1,  2,  3,  4,  6,   8,   12, 16,
+                                    24, 32, 48, 64, 128, 256};
+    // enough maps of every size that they do not all stay in cache
+    const unsigned int numMaps = 4096;
+    mt19937 rng(42);
+    unsigned long long found = 0;
+
+    cout << "\nNanoseconds per lookup:" << endl;
+    cout << setw(8) << "fan-out" << setw(12) << "map bytes" << setw(12)
+         << "hit" << setw(12) << "miss" << setw(16) << "unordered hit"
+         << setw(16) << "unordered miss" << endl;
+    for (unsigned int fanOut : fanOuts) {
+        NodeArena arena;
+        vector<ChildMap<BenchNode>> maps(numMaps);
+        vector<unordered_map<char, BenchNode*>> hashMaps(numMaps);
+        // the keys of every map, then the keys that are in none of it
+        vector<vector<char>> present(numMaps), absent(numMaps);
+
+        vector<int> keys(256);
+        for (int k = 0; k < 256; k++) keys[k] = k;
+        size_t mapBytes = 0;
+        for (unsigned int m = 0; m < numMaps; m++) {
+            shuffle(keys.begin(), keys.end(), rng);
+            for (unsigned int k = 0; k < 256; k++) {
+                char key = (char)keys[k];
+                if (k < fanOut) {
+                    maps[m].insert(key, &node, arena);
+                    hashMaps[m][key] = &node;
+                    present[m].push_back(key);
+                } else {
+                    absent[m].push_back(key);
+                }
+            }
+            mapBytes += maps[m].bytes();
+        }
+
+        vector<Lookup> hits, misses;
+        uniform_int_distribution<unsigned int> pickMap(0, numMaps - 1);
+        for (unsigned int i = 0; i < numLookups; i++) {
+            unsigned int m = pickMap(rng);
+            hits.push_back(Lookup{m, present[m][rng() % fanOut]});
+            if (!absent[m].empty()) {
+                misses.push_back(
+                    Lookup{m, absent[m][rng() % absent[m].size()]});
+            }
+        }
+
+        auto childMapFind = [&](const Lookup& l) {
+            return maps[l.map].find(l.key);
+        };
+        auto hashMapFind = [&](const Lookup& l) -> BenchNode* {
+            auto it = hashMaps[l.map].find(l.key);
+            return it == hashMaps[l.map].end() ? nullptr : it->second;
+        };
+        // one untimed pass to fault everything in
+        timeLookups(hits, childMapFind, found);
+        double hit = timeLookups(hits, childMapFind, found);
+        double miss =
+            misses.empty() ? 0 : timeLookups(misses, childMapFind, found);
+        timeLookups(hits, hashMapFind, found);
+        double hashHit = timeLookups(hits, hashMapFind, found);
+        double hashMiss =
+            misses.empty() ? 0 : timeLookups(misses, hashMapFind, found);
+
+        cout << setw(8) << fanOut << setw(12) << mapBytes / numMaps
+             << fixed << setprecision(2) << setw(12) << hit << setw(12);
+        if (misses.empty()) {
+            cout << "-";
+        } else {
+            cout << miss;
+        }
+        cout << setw(16) << hashHit << setw(16);
+        if (misses.empty()) {
+            cout << "-";
+        } else {
+            cout << hashMiss;
+        }
+        cout << endl;
+    }
+
+    // print the count so the compiler has to do the lookups
+    cout << "\n(" << found << " children found)" << endl;
+    return 0;
+}
@@ -0,0 +1,611 @@
+/**
+ * This program is a repeatable benchmark of DictionaryTrie. It builds the
+ * trie from a dictionary file, generates query mixes from the words in it
+ * (prefixes picked by frequency, wildcard patterns, misses, long prefixes
+ * and whole words to find), warms up, then times every query over several
+ * runs. Each mix gets min/p50/p90/p99/max latency and queries per second,
+ * and one more untimed run counts the nodes every query visits (when the
+ * library counts query stats) and its cache misses (when the machine has
+ * hardware counters). A batch
+ * mode measures throughput on more threads. The report goes to stdout and,
+ * if asked for, as JSON to a file so runs of different versions can be
+ * compared. --backend tst or radix runs the same mixes on the ternary
+ * search tree or the radix trie instead; the wildcard mix and the batch
+ * mode need the multiway trie and are left out there. --script greek or
+ * cjk rewrites every letter a-z of the dictionary and the queries as a
+ * two or three byte UTF-8 letter and runs the multiway trie in UTF-8
+ * mode, so the same mixes measure what multi byte words cost.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: getrusage(2) man page, perf_event_open(2) man page
+ */
+#include <sys/resource.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <thread>
+#include "Dictionary.hpp"
+#include "DictionaryTrie.hpp"
+#include "Utf8.hpp"
+#include "util.hpp"
+
+using namespace std;
+
+/** The letters the dictionary is rewritten in, see --script */
+enum class Script { ASCII, GREEK, CJK };
+
+// the names --script takes, and the code point every script moves 'a' to
+static const char* SCRIPT_NAMES[] = {"ascii", "greek", "cjk"};
+static const uint32_t SCRIPT_BASE[] = {'a', 0x3b1, 0x4e00};
+
+/** The settings of one benchmark run, filled in from the arguments */
+struct SuiteConfig {
+    string dictFile;
+    // file the JSON report is written to, empty for none
+    string jsonFile;
+    // queries generated for every mix
+    unsigned int numQueries = 10000;
+    // timed passes over every mix
+    unsigned int runs = 5;
+    // untimed passes over every mix before the timed ones
+    unsigned int warmups = 1;
+    // completions asked for by every query
+    unsigned int numCompletions = 10;
+    // most threads the batch mode goes up to
+    unsigned int maxThreads = 0;
+    unsigned int seed = 42;
+    // data structure the dictionary is built on
+    DictionaryBackend backend = DictionaryBackend::MWT;
+    // letters the words and queries are written in
+    Script script = Script::ASCII;
+};
+
+/** The queries of one mix and what they measured */
+struct QueryMix {
+    string name;
+    // what the text of the queries is, for the report
+    string description;
+    vector<string> queries;
+    // runs one query, returning the number of results
+    function<size_t(const string&)> run;
+
+    // per query latencies of all the timed runs, sorted
+    vector<long long> latencies;
+    // total time of the timed runs
+    long long totalNanoseconds = 0;
+    // results returned over one run, to tell misses apart
+    size_t resultsPerRun = 0;
+    // nodes visited and cache misses per query, -1 if not counted
+    double nodesPerQuery = -1;
+    double missesPerQuery = -1;
+};
+
+/** The queries per second of a batch run on some threads */
+struct BatchResult {
+    unsigned int threads;
+    double queriesPerSecond;
+};
+
+/* Check if a given data file is valid */
+bool fileValid(const char* fileName) {
+    ifstream in;
+    in.open(fileName, ios::binary);
+
+    // Check if input file was actually opened
+    if (!in.is_open()) {
+        cout << "Invalid input file. No file was opened. Please try again.\n";
+        return false;
+    }
+
+    // Check for empty file
+    in.seekg(0, ios_base::end);
+    unsigned int len = in.tellg();
+    if (len == 0) {
+        cout << "The file is empty. \n";
+        return false;
+    }
+    in.close();
+    return true;
+}
+
+/* Returns the peak resident set size of the process in kilobytes */
+long peakRssKilobytes() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return usage.ru_maxrss;
+}
+
+/* Returns the latency below which the given fraction of the sorted
+ * latencies fall.
+ */
+long long percentile(const vector<long long>& sorted, double fraction) {
+    if (sorted.empty()) return 0;
+    size_t i = (size_t)(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[i];
+}
+
+/* Returns s with the characters JSON needs escaped escaped */
+string jsonEscape(const string& s) {
+    ostringstream out;
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (c < 0x20) {
+            out << "\\u" << hex << setw(4) << setfill('0') << (int)c << dec;
+        } else {
+            out << c;
+        }
+    }
+    return out.str();
+}
+
+/* Returns text with every letter a-z replaced by the letter in the same
+ * place of script's alphabet. Everything else, the wildcards included,
+ * stays as it is.
+ */
+string transliterate(string_view text, Script script) {
+    string out;
+    for (char c : text) {
+        if (script != Script::ASCII && c >= 'a' && c <= 'z') {
+            appendUtf8(out, SCRIPT_BASE[(int)script] + (c - 'a'));
+        } else {
+            out.push_back(c);
+        }
+    }
+    return out;
+}
+
+/* Parses the arguments into config, returning false if they are bad */
+bool parseArgs(int argc, char** argv, SuiteConfig& config) {
+    if (argc < 2) return false;
+    config.dictFile = argv[1];
+    for (int i = 2; i < argc; i++) {
+        string flag = argv[i];
+        if (i + 1 >= argc) return false;
+        string value = argv[++i];
+        if (flag == "--json") {
+            config.jsonFile = value;
+            continue;
+        }
+        if (flag == "--backend") {
+            if (!Dictionary::parseBackend(value, config.backend)) return false;
+            continue;
+        }
+        if (flag == "--script") {
+            size_t s = 0;
+            while (s < 3 && value != SCRIPT_NAMES[s]) s++;
+            if (s == 3) return false;
+            config.script = (Script)s;
+            continue;
+        }
+        char* end;
+        unsigned long n = strtoul(value.c_str(), &end, 10);
+        if (*end != '\0') return false;
+        if (flag == "--queries") {
+            config.numQueries = n;
+        } else if (flag == "--runs") {
+            config.runs = n;
+        } else if (flag == "--warmup") {
+            config.warmups = n;
+        } else if (flag == "--k") {
+            config.numCompletions = n;
+        } else if (flag == "--threads") {
+            config.maxThreads = n;
+        } else if (flag == "--seed") {
+            config.seed = n;
+        } else {
+            return false;
+        }
+    }
+    // only the multiway trie has a UTF-8 mode
+    if (config.script != Script::ASCII &&
+        config.backend != DictionaryBackend::MWT) {
+        return false;
+    }
+    return config.numQueries > 0 && config.runs > 0;
+}
+
+/* Generates the query text of every mix from the dictionary words.
+ * Words are picked with probability proportional to their frequency,
+ * like real traffic, except for the patterns which pick uniformly so the
+ * rare words with long tails are covered too. The queries are made from
+ * the ASCII words and rewritten in config's script at the end, so every
+ * script gets the same mixes and a blank is always a whole letter.
+ */
+void generateMixes(const Dictionary& dict, const vector<string>& words,
+                   const vector<unsigned int>& freqs,
+                   const SuiteConfig& config, vector<QueryMix>& mixes) {
+    mt19937 rng(config.seed);
+    discrete_distribution<size_t> byFreq(freqs.begin(), freqs.end());
+    uniform_int_distribution<size_t> uniform(0, words.size() - 1);
+    unsigned int n = config.numQueries;
+
+    // short prefixes of frequent words, what a user has typed so far
+    QueryMix& prefix = mixes[0];
+    while (prefix.queries.size() < n) {
+        const string& word = words[byFreq(rng)];
+        size_t most = min<size_t>(word.size(), 5);
+        size_t len = uniform_int_distribution<size_t>(1, most)(rng);
+        prefix.queries.push_back(word.substr(0, len));
+    }
+
+    // a word with one or two characters blanked out
+    QueryMix& underscore = mixes[1];
+    while (underscore.queries.size() < n) {
+        string word = words[uniform(rng)];
+        if (word.size() < 3) continue;
+        uniform_int_distribution<size_t> pos(0, word.size() - 1);
+        word[pos(rng)] = '_';
+        word[pos(rng)] = '_';
+        underscore.queries.push_back(word);
+    }
+
+    // glob patterns: a prefix and a suffix with anything in between
+    QueryMix& wildcard = mixes[2];
+    while (wildcard.queries.size() < n) {
+        const string& word = words[uniform(rng)];
+        if (word.size() < 4) continue;
+        size_t head = uniform_int_distribution<size_t>(1, 2)(rng);
+        wildcard.queries.push_back(word.substr(0, head) + "*" +
+                                   word.substr(word.size() - 2));
+    }
+
+    // prefixes that are in no word, found by changing the last character
+    // of a real prefix until nothing completes it
+    QueryMix& miss = mixes[3];
+    uniform_int_distribution<int> letter('a', 'z');
+    while (miss.queries.size() < n) {
+        string word = words[byFreq(rng)];
+        size_t len = min<size_t>(word.size(), 4);
+        word.resize(len);
+        word[len - 1] = (char)letter(rng);
+        if (dict.predictCompletions(transliterate(word, config.script), 1)
+                .empty()) {
+            miss.queries.push_back(word);
+        }
+    }
+
+    // nearly whole words and phrases, the walk down is most of the work
+    QueryMix& longPrefix = mixes[4];
+    while (longPrefix.queries.size() < n) {
+        const string& word = words[uniform(rng)];
+        if (word.size() < 10) continue;
+        longPrefix.queries.push_back(word.substr(0, word.size() - 2));
+    }
+
+    // whole words, weighted by frequency like the prefixes
+    QueryMix& find = mixes[5];
+    while (find.queries.size() < n) {
+        find.queries.push_back(words[byFreq(rng)]);
+    }
+
+    if (config.script == Script::ASCII) return;
+    for (QueryMix& mix : mixes) {
+        for (string& query : mix.queries) {
+            query = transliterate(query, config.script);
+        }
+    }
+}
+
+/* Runs every query of mix once, returning the number of results. If
+ * latencies is given, each query's time is added to it.
+ */
+size_t runMix(const QueryMix& mix, vector<long long>* latencies) {
+    Timer timer;
+    size_t results = 0;
+    for (const string& query : mix.queries) {
+        timer.begin_timer();
+        results += mix.run(query);
+        long long time = timer.end_timer();
+        if (latencies != nullptr) latencies->push_back(time);
+    }
+    return results;
+}
+
+/* Warms mix up, then times the configured number of runs of it */
+void measureMix(QueryMix& mix, const SuiteConfig& config) {
+    for (unsigned int i = 0; i < config.warmups; i++) {
+        runMix(mix, nullptr);
+    }
+
+    Timer timer;
+    mix.latencies.reserve(mix.queries.size() * config.runs);
+    for (unsigned int i = 0; i < config.runs; i++) {
+        timer.begin_timer();
+        mix.resultsPerRun = runMix(mix, &mix.latencies);
+        mix.totalNanoseconds += timer.end_timer();
+    }
+    sort(mix.latencies.begin(), mix.latencies.end());
+}
+
+/* Runs every query of mix once more, untimed, and works out the nodes
+ * each query visited and the cache misses it took, as far as the library
+ * and the machine can count them.
+ */
+void countMix(QueryMix& mix, CacheMissCounter& counter) {
+    unsigned long long nodes = 0;
+    counter.begin();
+    for (const string& query : mix.queries) {
+        mix.run(query);
+        nodes += Dictionary::lastQueryStats().nodesVisited;
+    }
+    long long misses = counter.end();
+
+    double queries = mix.queries.size();
+    if (QueryStats::ENABLED) mix.nodesPerQuery = nodes / queries;
+    if (misses >= 0) mix.missesPerQuery = misses / queries;
+}
+
+/* Writes a per query count to out, or "-" if it was not counted */
+void printCount(ostream& out, double count, const char* missing) {
+    if (count < 0) {
+        out << missing;
+    } else {
+        out << fixed << setprecision(1) << count;
+    }
+}
+
+/* Returns the queries per second of mix over its timed runs */
+double queriesPerSecond(const QueryMix& mix) {
+    if (mix.totalNanoseconds == 0) return 0;
+    return mix.latencies.size() * 1e9 / mix.totalNanoseconds;
+}
+
+/* Times predictBatch() over the prefix and underscore mixes together on
+ * 1, 2, 4, ... up to the configured number of threads.
+ */
+vector<BatchResult> measureBatch(DictionaryTrie& trie,
+                                 const vector<QueryMix>& mixes,
+                                 const SuiteConfig& config) {
+    vector<CompletionQuery> batch;
+    for (size_t m = 0; m < 2; m++) {
+        for (const string& query : mixes[m].queries) {
+            batch.push_back(CompletionQuery{query, config.numCompletions});
+        }
+    }
+
+    unsigned int maxThreads = config.maxThreads;
+    if (maxThreads == 0) maxThreads = max(1u, thread::hardware_concurrency());
+
+    vector<BatchResult> results;
+    Timer timer;
+    for (unsigned int threads = 1;; threads *= 2) {
+        threads = min(threads, maxThreads);
+        trie.setBatchThreads(threads);
+        trie.predictBatch(batch.data(), batch.size());
+
+        timer.begin_timer();
+        for (unsigned int i = 0; i < config.runs; i++) {
+            trie.predictBatch(batch.data(), batch.size());
+        }
+        long long time = timer.end_timer();
+        double qps = time == 0 ? 0 : batch.size() * config.runs * 1e9 / time;
+        results.push_back(BatchResult{threads, qps});
+        if (threads == maxThreads) break;
+    }
+    trie.setBatchThreads(0);
+    return results;
+}
+
+/* Writes the report as JSON to out */
+void writeJson(ostream& out, const SuiteConfig& config, size_t numWords,
+               long long buildNanoseconds, size_t memoryBytes,
+               size_t nodes, long buildRss, long peakRss,
+               const vector<QueryMix>& mixes,
+               const vector<BatchResult>& batch) {
+    out << "{\n";
+    out << "  \"dictionary\": \"" << jsonEscape(config.dictFile) << "\",\n";
+    out << "  \"backend\": \"" << Dictionary::backendName(config.backend)
+        << "\",\n";
+    out << "  \"script\": \"" << SCRIPT_NAMES[(int)config.script] << "\",\n";
+    out << "  \"words\": " << numWords << ",\n";
+    out << "  \"queries_per_mix\": " << config.numQueries << ",\n";
+    out << "  \"runs\": " << config.runs << ",\n";
+    out << "  \"warmups\": " << config.warmups << ",\n";
+    out << "  \"num_completions\": " << config.numCompletions << ",\n";
+    out << "  \"seed\": " << config.seed << ",\n";
+    out << "  \"build_ns\": " << buildNanoseconds << ",\n";
+    out << "  \"memory_bytes\": " << memoryBytes << ",\n";
+    out << "  \"nodes\": " << nodes << ",\n";
+    out << "  \"build_rss_kb\": " << buildRss << ",\n";
+    out << "  \"peak_rss_kb\": " << peakRss << ",\n";
+    out << "  \"mixes\": [\n";
+    for (size_t i = 0; i < mixes.size(); i++) {
+        const QueryMix& mix = mixes[i];
+        const vector<long long>& l = mix.latencies;
+        out << "    {\"name\": \"" << mix.name << "\", "
+            << "\"description\": \"" << jsonEscape(mix.description)
+            << "\", "
+            << "\"queries\": " << mix.queries.size() << ", "
+            << "\"results_per_run\": " << mix.resultsPerRun << ", "
+            << "\"min_ns\": " << (l.empty() ? 0 : l.front()) << ", "
+            << "\"p50_ns\": " << percentile(l, 0.50) << ", "
+            << "\"p90_ns\": " << percentile(l, 0.90) << ", "
+            << "\"p99_ns\": " << percentile(l, 0.99) << ", "
+            << "\"max_ns\": " << (l.empty() ? 0 : l.back()) << ", "
+            << "\"qps\": " << fixed << setprecision(1)
+            << queriesPerSecond(mix) << ", \"nodes_per_query\": ";
+        printCount(out, mix.nodesPerQuery, "null");
+        out << ", \"misses_per_query\": ";
+        printCount(out, mix.missesPerQuery, "null");
+        out << "}"
+            << (i + 1 < mixes.size() ? "," : "") << "\n";
+    }
+    out << "  ],\n";
+    out << "  \"batch\": [\n";
+    for (size_t i = 0; i < batch.size(); i++) {
+        out << "    {\"threads\": " << batch[i].threads << ", \"qps\": "
+            << fixed << setprecision(1) << batch[i].queriesPerSecond << "}"
+            << (i + 1 < batch.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+/* Prints the report as a table to stdout */
+void printReport(const SuiteConfig& config, size_t numWords,
+                 long long buildNanoseconds, size_t memoryBytes,
+                 size_t nodes, long buildRss, long peakRss,
+                 const vector<QueryMix>& mixes,
+                 const vector<BatchResult>& batch) {
+    cout << "Backend: " << Dictionary::backendName(config.backend) << endl;
+    cout << "Script: " << SCRIPT_NAMES[(int)config.script] << endl;
+    cout << "Words: " << numWords << endl;
+    cout << "Build time: " << buildNanoseconds / 1000000 << " ms" << endl;
+    cout << "Node memory: " << memoryBytes << " bytes in " << nodes
+         << " nodes" << endl;
+    cout << "RSS after build: " << buildRss << " KB, peak: " << peakRss
+         << " KB" << endl;
+
+    cout << "\nLatency in nanoseconds:" << endl;
+    cout << left << setw(12) << "mix" << right << setw(10) << "min"
+         << setw(10) << "p50" << setw(10) << "p90" << setw(10) << "p99"
+         << setw(12) << "max" << setw(14) << "queries/s" << setw(10)
+         << "nodes/q" << setw(10) << "misses/q" << endl;
+    for (const QueryMix& mix : mixes) {
+        const vector<long long>& l = mix.latencies;
+        cout << left << setw(12) << mix.name << right << setw(10)
+             << (l.empty() ? 0 : l.front()) << setw(10) << percentile(l, 0.50)
+             << setw(10) << percentile(l, 0.90) << setw(10)
+             << percentile(l, 0.99) << setw(12) << (l.empty() ? 0 : l.back())
+             << setw(14) << fixed << setprecision(0) << queriesPerSecond(mix)
+             << setw(10);
+        printCount(cout, mix.nodesPerQuery, "-");
+        cout << setw(10);
+        printCount(cout, mix.missesPerQuery, "-");
+        cout << endl;
+    }
+
+    if (batch.empty()) return;
+    cout << "\nBatch throughput (prefix + underscore mixes):" << endl;
+    for (const BatchResult& result : batch) {
+        cout << "  " << result.threads << " threads: " << fixed
+             << setprecision(0) << result.queriesPerSecond << " queries/s"
+             << endl;
+    }
+}
+
+/* arg 1 - Input file name (in format like freq_dict.txt)
+ * then any of:
+ *   --json <file>     write the report as JSON to file ("-" for stdout)
+ *   --queries <n>     queries generated for every mix (default 10000)
+ *   --runs <n>        timed runs of every mix (default 5)
+ *   --warmup <n>      untimed runs before them (default 1)
+ *   --k <n>           completions asked for by each query (default 10)
+ *   --threads <n>     most threads for the batch mode (default all)
+ *   --seed <n>        seed the mixes are generated from (default 42)
+ *   --backend <name>  mwt, tst or radix (default mwt)
+ *   --script <name>   ascii, greek or cjk letters (default ascii), the
+ *                     last two need mwt
+ */
+int main(int argc, char** argv) {
+    SuiteConfig config;
+    if (!parseArgs(argc, argv, config)) {
+        cout << "Invalid arguments.\n"
+             << "Usage: ./benchsuite <dictionary filename> [--json <file>] "
+             << "[--queries <n>] [--runs <n>] [--warmup <n>] [--k <n>] "
+             << "[--threads <n>] [--seed <n>] [--backend mwt|tst|radix] "
+             << "[--script ascii|greek|cjk]" << endl;
+        return -1;
+    }
+    if (!fileValid(config.dictFile.c_str())) return -1;
+
+    // the words and frequencies the mixes are drawn from
+    vector<string> words;
+    vector<unsigned int> freqs;
+    Utils::scanDictFile(config.dictFile, UINT_MAX,
+                        [&](string_view word, unsigned int freq) {
+                            words.emplace_back(word);
+                            freqs.push_back(freq);
+                        });
+
+    unique_ptr<Dictionary> dict = Dictionary::create(config.backend);
+    // nullptr on the backends without the multiway trie extras
+    DictionaryTrie* trie = dynamic_cast<DictionaryTrie*>(dict.get());
+    if (config.script != Script::ASCII) trie->setUtf8(true);
+    Timer timer;
+    timer.begin_timer();
+    if (config.script == Script::ASCII) {
+        Utils::loadDictFile(*dict, config.dictFile);
+    } else {
+        Utils::scanDictFile(config.dictFile, UINT_MAX,
+                            [&](string_view word, unsigned int freq) {
+                                dict->insert(transliterate(word, config.script),
+                                             freq);
+                            });
+    }
+    long long buildNanoseconds = timer.end_timer();
+    long buildRss = peakRssKilobytes();
+
+    unsigned int k = config.numCompletions;
+    vector<QueryMix> mixes(6);
+    mixes[0].name = "prefix";
+    mixes[0].description = "1-5 character prefixes, weighted by frequency";
+    mixes[0].run = [&](const string& q) {
+        return dict->predictCompletions(q, k).size();
+    };
+    mixes[1].name = "underscore";
+    mixes[1].description = "words with up to two _ blanks";
+    mixes[1].run = [&](const string& q) {
+        return dict->predictUnderscores(q, k).size();
+    };
+    mixes[2].name = "wildcard";
+    mixes[2].description = "glob patterns like ab*yz";
+    mixes[2].run = [&](const string& q) {
+        return trie->predictWildcards(q, k).size();
+    };
+    mixes[3].name = "miss";
+    mixes[3].description = "prefixes no word starts with";
+    mixes[3].run = mixes[0].run;
+    mixes[4].name = "long";
+    mixes[4].description = "prefixes of 8+ characters";
+    mixes[4].run = mixes[0].run;
+    mixes[5].name = "find";
+    mixes[5].description = "whole words, weighted by frequency";
+    mixes[5].run = [&](const string& q) { return (size_t)dict->find(q); };
+
+    generateMixes(*dict, words, freqs, config, mixes);
+    if (trie == nullptr) mixes.erase(mixes.begin() + 2);
+    size_t numWords = words.size();
+    // only the dictionary is queried from here on
+    words = vector<string>();
+    freqs = vector<unsigned int>();
+
+    CacheMissCounter counter;
+    for (QueryMix& mix : mixes) {
+        measureMix(mix, config);
+        countMix(mix, counter);
+    }
+    vector<BatchResult> batch;
+    if (trie != nullptr) batch = measureBatch(*trie, mixes, config);
+    size_t memoryBytes = dict->memoryBytes();
+    size_t nodes = dict->nodeCount();
+    long peakRss = peakRssKilobytes();
+
+    printReport(config, numWords, buildNanoseconds, memoryBytes, nodes,
+                buildRss, peakRss, mixes, batch);
+
+    if (config.jsonFile == "-") {
+        writeJson(cout, config, numWords, buildNanoseconds, memoryBytes,
+                  nodes, buildRss, peakRss, mixes, batch);
+    } else if (!config.jsonFile.empty()) {
+        ofstream out(config.jsonFile);
+        if (!out.is_open()) {
+            cout << "Could not write report: " << config.jsonFile << endl;
+            return -1;
+        }
+        writeJson(out, config, numWords, buildNanoseconds, memoryBytes,
+                  nodes, buildRss, peakRss, mixes, batch);
+        cout << "Wrote report to " << config.jsonFile << endl;
+    }
+    return 0;
+}
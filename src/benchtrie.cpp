@@ -1,16 +1,389 @@
 /**
- * Benchmark the autocomplete function in DictionaryTrie
+ * Benchmark the autocomplete function in DictionaryTrie. Setting
+ * DICTIONARY_BACKEND=tst or radix runs the common tests on the ternary
+ * search tree or the radix trie.
  */
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
 #include <fstream>
+#include <memory>
+#include <random>
 #include <sstream>
+#include <thread>
+#include "CompletionCursor.hpp"
+#include "ConcurrentDictionary.hpp"
+#include "Dictionary.hpp"
+#include "DictionarySnapshot.hpp"
 #include "DictionaryTrie.hpp"
 #include "util.hpp"
 using namespace std;
 
+/* Returns the latency below which the given fraction of the sorted
+ * latencies fall.
+ */
+long long percentile(const vector<long long>& sorted, double fraction) {
+    if (sorted.empty()) return 0;
+    size_t i = (size_t)(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[i];
+}
+
+/* Prints the counters of the last query, if the library counts them */
+void printProfile() {
+    if (!QueryStats::ENABLED) return;
+    cout << "\tProfile: ";
+    DictionaryTrie::lastQueryStats().print(cout);
+    cout << endl;
+}
+
+/* Test the runtime of the features only the multiway trie has: the
+ * caches, snapshots, the other loaders, batches, patterns, fuzzy search,
+ * cursors. trie is loaded from filename, words are its words.
+ */
+void testTrieFeatures(DictionaryTrie* trie, const string& filename,
+                      const vector<string>& words, unsigned int numThreads) {
+    const unsigned int NUM_COMP = 10;
+
+    Timer timer;
+    vector<string> results;
+    long long time = 0;
+    unsigned int count = 0;
+
+    // Test 6: build the top-K cache and repeat test 1 against it
+    cout << "\nTest 6: top-K cache, K = " << NUM_COMP << endl;
+    timer.begin_timer();
+    trie->enableTopKCache(NUM_COMP);
+    time = timer.end_timer();
+    cout << "\tBuild time: " << time << " nanoseconds." << endl;
+    cout << "\tCache memory: " << trie->topKCacheBytes() << " bytes." << endl;
+    timer.begin_timer();
+    count = 0;
+    for (char c = 'a'; c <= 'z'; c++) {
+        results = trie->predictCompletions(string(1, c), NUM_COMP);
+        count += results.size();
+    }
+    time = timer.end_timer();
+    cout << "\tAlphabet time taken: " << time << " nanoseconds." << endl;
+    cout << "\tResults found: " << count << endl;
+
+    // Test 7: write a snapshot, map it and repeat test 1 against it
+    string snapshotFile = filename + ".snapshot";
+    cout << "\nTest 7: snapshot, file = " << snapshotFile << endl;
+    timer.begin_timer();
+    bool written = trie->writeSnapshot(snapshotFile);
+    time = timer.end_timer();
+    cout << "\tWrite time: " << time << " nanoseconds." << endl;
+    DictionarySnapshot snapshot;
+    timer.begin_timer();
+    bool opened = written && snapshot.open(snapshotFile);
+    time = timer.end_timer();
+    if (opened) {
+        cout << "\tOpen time: " << time << " nanoseconds." << endl;
+        timer.begin_timer();
+        count = 0;
+        for (char c = 'a'; c <= 'z'; c++) {
+            results = snapshot.predictCompletions(string(1, c), NUM_COMP);
+            count += results.size();
+        }
+        time = timer.end_timer();
+        cout << "\tAlphabet time taken: " << time << " nanoseconds." << endl;
+        cout << "\tResults found: " << count << endl;
+        snapshot.close();
+    } else {
+        cout << "\tCould not write or open the snapshot." << endl;
+    }
+    remove(snapshotFile.c_str());
+
+    // Test 8: parse the file in place, then load a second trie from it
+    cout << "\nTest 8: in-place loader" << endl;
+    LoadStats stats;
+    unsigned int parsed = 0;
+    Utils::scanDictFile(
+        filename, UINT_MAX,
+        [&parsed](string_view, unsigned int) { parsed++; }, &stats);
+    cout << "\tParse only: " << stats.megabytesPerSecond() << " MB/s, "
+         << parsed << " words." << endl;
+    DictionaryTrie* reloaded = new DictionaryTrie();
+    Utils::loadDictFile(*reloaded, filename, UINT_MAX, &stats);
+    cout << "\tParse and insert: " << stats.megabytesPerSecond()
+         << " MB/s, " << stats.nanoseconds << " nanoseconds." << endl;
+    delete reloaded;
+
+    // Test 9: parallel build, compared against the serial build above
+    cout << "\nTest 9: parallel build, threads = " << numThreads << endl;
+    DictionaryTrie* parallel = new DictionaryTrie();
+    Utils::loadDictParallel(*parallel, filename, numThreads, &stats);
+    cout << "\tTime taken: " << stats.nanoseconds << " nanoseconds, "
+         << stats.megabytesPerSecond() << " MB/s." << endl;
+    cout << "\tSame node memory as serial: "
+         << (parallel->memoryBytes() == trie->memoryBytes() ? "yes" : "no")
+         << endl;
+    delete parallel;
+
+    // Test 10: sorted bulk load, compared against the serial build above
+    cout << "\nTest 10: sorted bulk load" << endl;
+    DictionaryTrie* bulk = new DictionaryTrie();
+    bool sorted = false;
+    Utils::loadDictSorted(*bulk, filename, &stats, &sorted);
+    cout << "\tTime taken: " << stats.nanoseconds << " nanoseconds, "
+         << stats.megabytesPerSecond() << " MB/s." << endl;
+    cout << "\tInput was sorted: " << (sorted ? "yes" : "no") << endl;
+    cout << "\tSame node memory as serial: "
+         << (bulk->memoryBytes() == trie->memoryBytes() ? "yes" : "no")
+         << endl;
+    delete bulk;
+
+    // Test 11: lock-free readers while a writer republishes the dictionary
+    cout << "\nTest 11: concurrent readers during snapshot swaps" << endl;
+    DictionaryTrie* first = new DictionaryTrie();
+    Utils::loadDictSorted(*first, filename);
+    ConcurrentDictionary live(first);
+    for (unsigned int readers = 1; readers <= numThreads; readers *= 2) {
+        atomic<bool> stop(false);
+        vector<unsigned long long> reads(readers, 0);
+        vector<long long> worst(readers, 0);
+        vector<thread> pool;
+        for (unsigned int r = 0; r < readers; r++) {
+            pool.push_back(thread([&, r]() {
+                ConcurrentDictionary::Reader reader(live);
+                Timer readTimer;
+                unsigned int i = r;
+                while (!stop.load()) {
+                    readTimer.begin_timer();
+                    reader.predictCompletions(words[i % words.size()]
+                                                  .substr(0, 2),
+                                              NUM_COMP);
+                    long long took = readTimer.end_timer();
+                    if (took > worst[r]) worst[r] = took;
+                    reads[r]++;
+                    i += readers;
+                }
+            }));
+        }
+
+        // the writer rebuilds and publishes a few new versions meanwhile
+        const unsigned int NUM_PUBLISH = 3;
+        timer.begin_timer();
+        for (unsigned int p = 0; p < NUM_PUBLISH; p++) {
+            DictionaryTrie* next = new DictionaryTrie();
+            Utils::loadDictSorted(*next, filename);
+            live.publish(next);
+        }
+        stop.store(true);
+        for (unsigned int r = 0; r < readers; r++) pool[r].join();
+        time = timer.end_timer();
+
+        unsigned long long totalReads = 0;
+        long long worstRead = 0;
+        for (unsigned int r = 0; r < readers; r++) {
+            totalReads += reads[r];
+            if (worst[r] > worstRead) worstRead = worst[r];
+        }
+        live.reclaim();
+        cout << "\t" << readers << " reader(s): "
+             << (unsigned long long)(totalReads * 1e9 / time)
+             << " reads/s, slowest read " << worstRead << " nanoseconds, "
+             << live.pendingReclaim() << " versions left to reclaim."
+             << endl;
+    }
+
+    // Test 12: bump every word's frequency in place, cache still on
+    cout << "\nTest 12: incrementFrequency on every word" << endl;
+    vector<string> before;
+    for (char c = 'a'; c <= 'z'; c++) {
+        results = trie->predictCompletions(string(1, c), NUM_COMP);
+        before.insert(before.end(), results.begin(), results.end());
+    }
+    timer.begin_timer();
+    for (unsigned int i = 0; i < words.size(); i++) {
+        trie->incrementFrequency(words[i], 1);
+    }
+    time = timer.end_timer();
+    cout << "\tTime taken: " << time << " nanoseconds, "
+         << time / words.size() << " nanoseconds per update." << endl;
+    vector<string> after;
+    for (char c = 'a'; c <= 'z'; c++) {
+        results = trie->predictCompletions(string(1, c), NUM_COMP);
+        after.insert(after.end(), results.begin(), results.end());
+    }
+    cout << "\tRanking unchanged: " << (before == after ? "yes" : "no")
+         << endl;
+
+    // Test 13: a burst of mixed queries answered with predictBatch()
+    const unsigned int NUM_QUERIES = 20000;
+    cout << "\nTest 13: batch of " << NUM_QUERIES << " queries" << endl;
+    vector<CompletionQuery> batch;
+    for (unsigned int i = 0; i < NUM_QUERIES; i++) {
+        string text = words[(i * 7919) % words.size()].substr(0, 1 + i % 4);
+        // every eighth query is an underscore pattern, like autocomplete's
+        if (i % 8 == 0 && text.size() > 1) text[1] = '_';
+        batch.push_back(CompletionQuery{text, NUM_COMP});
+    }
+    vector<vector<string>> serial;
+    for (unsigned int threads = 1; threads <= numThreads; threads *= 2) {
+        trie->setBatchThreads(threads);
+        timer.begin_timer();
+        vector<vector<string>> answers =
+            trie->predictBatch(batch.data(), batch.size());
+        time = timer.end_timer();
+        if (threads == 1) serial = answers;
+        cout << "\t" << threads << " thread(s): "
+             << (unsigned long long)(NUM_QUERIES * 1e9 / time)
+             << " queries/s, same results as 1 thread: "
+             << (answers == serial ? "yes" : "no") << endl;
+    }
+
+    // Test 14: underscore patterns, leading underscores are the worst case.
+    // The recursive matcher is timed against the pattern engine.
+    cout << "\nTest 14: predictUnderscores, numCompletions = " << NUM_COMP
+         << endl;
+    vector<string> patterns = {"___ing", "_____", "__a__e_", "t__",
+                               "___________________ing"};
+    for (unsigned int i = 0; i < patterns.size(); i++) {
+        timer.begin_timer();
+        vector<string> reference =
+            trie->predictUnderscoresRecursive(patterns[i], NUM_COMP);
+        long long recursive = timer.end_timer();
+        timer.begin_timer();
+        results = trie->predictUnderscores(patterns[i], NUM_COMP);
+        time = timer.end_timer();
+        cout << "\tPattern \"" << patterns[i] << "\": recursive "
+             << recursive << " nanoseconds, engine " << time
+             << " nanoseconds, " << results.size() << " results, "
+             << (results == reference ? "same" : "different") << " results."
+             << endl;
+    }
+
+    // Test 15: general wildcard patterns on the pattern engine
+    cout << "\nTest 15: predictWildcards, numCompletions = " << NUM_COMP
+         << endl;
+    patterns = {"*ing", "*tion", "th*", "[aeiou]*[aeiou]", "s[^aeiou]*ed",
+                "*x*z*"};
+    for (unsigned int i = 0; i < patterns.size(); i++) {
+        timer.begin_timer();
+        results = trie->predictWildcards(patterns[i], NUM_COMP);
+        time = timer.end_timer();
+        cout << "\tPattern \"" << patterns[i] << "\": " << time
+             << " nanoseconds, " << results.size() << " results." << endl;
+    }
+
+    // Test 16: typo tolerant completion on mistyped prefixes
+    const unsigned int NUM_TYPOS = 2000;
+    cout << "\nTest 16: predictFuzzy on " << NUM_TYPOS
+         << " mistyped prefixes, numCompletions = " << NUM_COMP << endl;
+    vector<string> typos;
+    for (unsigned int i = 0; typos.size() < NUM_TYPOS && i < words.size() * 4;
+         i++) {
+        const string& word = words[(i * 7919) % words.size()];
+        if (word.size() < 3) continue;
+        string text = word.substr(0, 3 + i % 4);
+        // one substitution, deletion or insertion somewhere in the prefix
+        size_t at = (i / 3) % text.size();
+        if (i % 3 == 0) {
+            text[at] = text[at] == 'z' ? 'a' : text[at] + 1;
+        } else if (i % 3 == 1) {
+            text.erase(at, 1);
+        } else {
+            text.insert(at, 1, 'e');
+        }
+        typos.push_back(text);
+    }
+    for (unsigned int distance = 1; distance <= 2; distance++) {
+        vector<long long> latencies;
+        unsigned long long total = 0;
+        for (unsigned int i = 0; i < typos.size(); i++) {
+            timer.begin_timer();
+            results = trie->predictFuzzy(typos[i], NUM_COMP, distance);
+            latencies.push_back(timer.end_timer());
+            total += results.size();
+        }
+        sort(latencies.begin(), latencies.end());
+        cout << "\tDistance " << distance
+             << ": p50 = " << percentile(latencies, 0.50)
+             << ", p90 = " << percentile(latencies, 0.90)
+             << ", p99 = " << percentile(latencies, 0.99)
+             << ", max = " << latencies.back() << " nanoseconds, "
+             << total << " results." << endl;
+    }
+
+    // Test 17: words typed one character at a time, asking for more
+    // completions than the top-K cache holds so both sides search
+    const unsigned int NUM_TYPED = 2000;
+    const unsigned int TYPED_COMP = 2 * NUM_COMP;
+    cout << "\nTest 17: typing " << NUM_TYPED
+         << " words keystroke by keystroke, numCompletions = " << TYPED_COMP
+         << endl;
+    vector<string> typed;
+    for (unsigned int i = 0; i < NUM_TYPED && i < words.size(); i++) {
+        typed.push_back(words[(i * 7919) % words.size()]);
+    }
+    unsigned long long keystrokes = 0;
+    bool same = true;
+    long long fresh = 0;
+    long long cursorTime = 0;
+    for (unsigned int i = 0; i < typed.size(); i++) {
+        vector<vector<string>> expected;
+        timer.begin_timer();
+        for (unsigned int j = 1; j <= typed[i].size(); j++) {
+            expected.push_back(
+                trie->predictCompletions(typed[i].substr(0, j), TYPED_COMP));
+        }
+        fresh += timer.end_timer();
+
+        timer.begin_timer();
+        CompletionCursor cursor(*trie);
+        for (unsigned int j = 0; j < typed[i].size(); j++) {
+            cursor.push(typed[i][j]);
+            results = cursor.topK(TYPED_COMP);
+            same = same && results == expected[j];
+        }
+        cursorTime += timer.end_timer();
+        keystrokes += typed[i].size();
+    }
+    cout << "\tpredictCompletions per keystroke: " << fresh / keystrokes
+         << " nanoseconds." << endl;
+    cout << "\tCompletionCursor per keystroke: " << cursorTime / keystrokes
+         << " nanoseconds." << endl;
+    cout << "\tSame results: " << (same ? "yes" : "no") << endl;
+
+    // Test 18: skewed traffic, a few short prefixes asked most often,
+    // with and without the result cache in front of the search
+    const unsigned int NUM_SKEWED = 100000;
+    const unsigned int NUM_HOT = 1000;
+    cout << "\nTest 18: result cache on " << NUM_SKEWED
+         << " Zipf distributed queries, numCompletions = " << TYPED_COMP
+         << endl;
+    vector<string> hot;
+    vector<double> weights;
+    for (unsigned int i = 0; i < NUM_HOT && i < words.size(); i++) {
+        hot.push_back(words[(i * 7919) % words.size()].substr(0, 1 + i % 3));
+        weights.push_back(1.0 / (i + 1));
+    }
+    mt19937 gen(42);
+    discrete_distribution<unsigned int> pick(weights.begin(), weights.end());
+    vector<unsigned int> skewed;
+    for (unsigned int i = 0; i < NUM_SKEWED; i++) skewed.push_back(pick(gen));
+    for (size_t capacity : {(size_t)0, (size_t)100, (size_t)1000}) {
+        trie->enableResultCache(capacity);
+        ResultCacheStats start = trie->resultCacheStats();
+        timer.begin_timer();
+        for (unsigned int i = 0; i < skewed.size(); i++) {
+            trie->predictCompletions(hot[skewed[i]], TYPED_COMP);
+        }
+        time = timer.end_timer();
+        ResultCacheStats stats = trie->resultCacheStats();
+        cout << "\tCapacity " << capacity << ": " << time / skewed.size()
+             << " nanoseconds per query, hits = " << stats.hits - start.hits
+             << ", evictions = " << stats.evictions - start.evictions
+             << endl;
+    }
+    trie->enableResultCache(0);
+}
+
 /* Test the runtime of autocompelte using different prefix and number of
- * completions
+ * completions. numThreads is the thread count for the parallel build test.
  */
-void testRuntime(string filename) {
+void testRuntime(string filename, unsigned int numThreads) {
     const unsigned int NUM_COMP = 10;
 
     ifstream in;
@@ -19,20 +392,53 @@ void testRuntime(string filename) {
     // Testing student's trie
     cout << "\nLoading dictionary..." << endl;
 
-    DictionaryTrie* trie = new DictionaryTrie();
-    Utils::loadDict(*trie, in);
-
     Timer timer;
     vector<string> results;
     long long time = 0;
 
+    timer.begin_timer();
+    unique_ptr<Dictionary> dict = Dictionary::create(
+        Dictionary::defaultBackend());
+    Utils::loadDict(*dict, in);
+    time = timer.end_timer();
+    cout << "\tBackend: " << Dictionary::backendName(
+        Dictionary::defaultBackend()) << endl;
+    cout << "\tBuild time: " << time << " nanoseconds." << endl;
+    // the multiway trie, nullptr on any other backend
+    DictionaryTrie* trie = dynamic_cast<DictionaryTrie*>(dict.get());
+    if (trie != nullptr) {
+        cout << "\tArena memory: " << trie->arenaBytes() << " bytes."
+             << endl;
+    }
+
+    // Test 0: node memory and find() on every word of the dictionary
+    vector<string> words;
+    in.clear();
+    in.seekg(0, ios_base::beg);
+    Utils::loadDict(words, in);
+    cout << "\nTest 0: memory and lookup, words = " << words.size() << endl;
+    cout << "\tNode memory: " << dict->memoryBytes() << " bytes." << endl;
+    if (trie != nullptr) {
+        trie->trieStats().print(cout);
+    } else {
+        cout << "\tNodes: " << dict->nodeCount() << endl;
+    }
+    timer.begin_timer();
+    unsigned int found = 0;
+    for (unsigned int i = 0; i < words.size(); i++) {
+        found += dict->find(words[i]);
+    }
+    time = timer.end_timer();
+    cout << "\tTime taken: " << time << " nanoseconds." << endl;
+    cout << "\tWords found: " << found << endl;
+
     // Test 1: iterate through alphabet prefix
     cout << "\nTest 1: prefix = \"iterating through alphabet\", "
          << "numCompletions = " << NUM_COMP << endl;
     timer.begin_timer();
     unsigned int count = 0;
     for (char c = 'a'; c <= 'z'; c++) {
-        results = trie->predictCompletions(string(1, c), NUM_COMP);
+        results = dict->predictCompletions(string(1, c), NUM_COMP);
         count += results.size();
     }
     time = timer.end_timer();
@@ -42,34 +448,47 @@ void testRuntime(string filename) {
     // Test 2: "a" as prefix
     cout << "\nTest 2: prefix = \"a\", numCompletions = " << NUM_COMP << endl;
     timer.begin_timer();
-    results = trie->predictCompletions("a", NUM_COMP);
+    results = dict->predictCompletions("a", NUM_COMP);
     time = timer.end_timer();
     cout << "\tTime taken: " << time << " nanoseconds." << endl;
     cout << "\tResults found: " << results.size() << endl;
+    printProfile();
 
     // Test 3: "the" as prefix
     cout << "\nTest 3: prefix= \"the\", numCompletions = " << NUM_COMP << endl;
     timer.begin_timer();
-    results = trie->predictCompletions("the", NUM_COMP);
+    results = dict->predictCompletions("the", NUM_COMP);
     time = timer.end_timer();
     cout << "\tTime taken: " << time << " nanoseconds." << endl;
     cout << "\tResults found: " << results.size() << endl;
+    printProfile();
 
     // Test 4: "app" as prefix
     cout << "\nTest 4: prefix= \"app\", numCompletions = " << NUM_COMP << endl;
     timer.begin_timer();
-    results = trie->predictCompletions("app", NUM_COMP);
+    results = dict->predictCompletions("app", NUM_COMP);
     time = timer.end_timer();
     cout << "\tTime taken: " << time << " nanoseconds." << endl;
     cout << "\tResults found: " << results.size() << endl;
+    printProfile();
 
     // Test 5: "man" as prefix
     cout << "\nTest 5: prefix= \"man\", numCompletions = " << NUM_COMP << endl;
     timer.begin_timer();
-    results = trie->predictCompletions("man", NUM_COMP);
+    results = dict->predictCompletions("man", NUM_COMP);
     time = timer.end_timer();
     cout << "\tTime taken: " << time << " nanoseconds." << endl;
     cout << "\tResults found: " << results.size() << endl;
+    printProfile();
+
+    // Tests 6 and up use what only the multiway trie has
+    if (trie != nullptr) {
+        testTrieFeatures(trie, filename, words, numThreads);
+    } else {
+        cout << "\nTests 6-18 use multiway trie features, skipped on the "
+             << Dictionary::backendName(Dictionary::defaultBackend())
+             << " backend." << endl;
+    }
 
     // Addtional tests
     cout << "\nWould you like to run additional tests? (y/n) ";
@@ -90,14 +509,20 @@ void testRuntime(string filename) {
             cout << "\nUser Test: prefix = \"" << prefix
                  << "\", numCompletions = " << numCompletions << endl;
             timer.begin_timer();
-            results = trie->predictCompletions(prefix, numCompletions);
+            results = dict->predictCompletions(prefix, numCompletions);
             time = timer.end_timer();
             cout << "\tTime taken: " << time << " nanoseconds." << endl;
-            cout << "\tResults found: " << results.size() << "\n\n";
+            cout << "\tResults found: " << results.size() << endl;
+            printProfile();
+            cout << endl;
             cout << "Enter prefix: ";
         }
     }
-    delete trie;
+
+    timer.begin_timer();
+    dict.reset();
+    time = timer.end_timer();
+    cout << "\nTeardown time: " << time << " nanoseconds." << endl;
 }
 
 /* Check if a given data file is valid */
@@ -122,16 +547,25 @@ bool fileValid(const char* fileName) {
     return true;
 }
 
-/* The main function that drives the program */
+/* The main function that drives the program
+ *
+ * arg 1 - Input file name (in format like freq_dict.txt)
+ * arg 2 - (optional) number of threads for the parallel build test,
+ *         defaults to the number of cores
+ */
 int main(int argc, char* argv[]) {
-    const int NUM_ARG = 2;
+    const int MIN_ARG = 2;
+    const int MAX_ARG = 3;
 
-    if (argc != NUM_ARG) {
+    if (argc < MIN_ARG || argc > MAX_ARG) {
         cout << "Invalid number of arguments.\n"
-             << "Usage: ./benchtrie <dictionary filename>" << endl;
+             << "Usage: ./benchtrie <dictionary filename> [threads]" << endl;
         return -1;
     }
 
     if (!fileValid(argv[1])) return -1;
-    testRuntime(argv[1]);
+    unsigned int numThreads = thread::hardware_concurrency();
+    if (argc == MAX_ARG) numThreads = stoi(argv[2]);
+    if (numThreads == 0) numThreads = 1;
+    testRuntime(argv[1], numThreads);
 }
\ No newline at end of file
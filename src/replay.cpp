@@ -0,0 +1,270 @@
+/**
+ * This program replays a query log against a DictionaryTrie to measure
+ * latency on real traffic. Every line of the log is one query in the same
+ * layout as the dictionary: K, the number of completions, then the prefix
+ * or underscore pattern. A query with an underscore in it goes to
+ * predictUnderscores(), any other to predictCompletions().
+ *
+ * The log runs either at full speed or at a target rate, on any number of
+ * threads. At a target rate query i is due i / rate seconds after the
+ * start, and its latency is counted from then rather than from when a
+ * thread got to it. A stall therefore shows up in the latency of every
+ * query that had to wait, not just the one that stalled (the coordinated
+ * omission problem). Latencies are kept in LatencyHistograms, one per
+ * query type, and printed as percentile distributions.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: Gil Tene "How NOT to Measure Latency" (coordinated omission),
+ *          HdrHistogram documentation
+ */
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "DictionaryTrie.hpp"
+#include "util.hpp"
+
+using namespace std;
+
+/** One line of the query log */
+struct ReplayQuery {
+    // the prefix or pattern
+    string text;
+    // the number of completions asked for
+    unsigned int numCompletions;
+    // does the text have an underscore in it
+    bool pattern;
+};
+
+/** The histograms of one query type, or of all of them */
+struct TypeHistograms {
+    // from when the query was due to when it finished
+    LatencyHistogram response;
+    // from when a thread started the query to when it finished
+    LatencyHistogram service;
+
+    void add(const TypeHistograms& other) {
+        response.add(other.response);
+        service.add(other.service);
+    }
+};
+
+// the query types, in the order their histograms are kept
+static const int PREFIX = 0;
+static const int UNDERSCORE = 1;
+static const int NUM_TYPES = 2;
+static const char* TYPE_NAMES[NUM_TYPES] = {"prefix", "underscore"};
+
+/* Check if a given data file is valid */
+bool fileValid(const char* fileName) {
+    ifstream in;
+    in.open(fileName, ios::binary);
+
+    // Check if input file was actually opened
+    if (!in.is_open()) {
+        cout << "Invalid input file. No file was opened. Please try again.\n";
+        return false;
+    }
+
+    // Check for empty file
+    in.seekg(0, ios_base::end);
+    unsigned int len = in.tellg();
+    if (len == 0) {
+        cout << "The file is empty. \n";
+        return false;
+    }
+    in.close();
+    return true;
+}
+
+/* Reads the query log into queries, skipping lines without a K */
+void readLog(const char* fileName, vector<ReplayQuery>& queries) {
+    ifstream in(fileName, ios::binary);
+    string line;
+    string scratch;
+    unsigned int numCompletions;
+    string_view text;
+    while (getline(in, line)) {
+        if (!Utils::parseLine(line, numCompletions, text, scratch)) continue;
+        bool pattern = text.find('_') != string_view::npos;
+        queries.push_back(ReplayQuery{string(text), numCompletions, pattern});
+    }
+}
+
+/* Waits until clock, started when the replay did, reads due nanoseconds.
+ * It sleeps while the wait is long and spins for the last stretch, since
+ * a sleep can overshoot by tens of microseconds.
+ */
+void waitUntil(Timer& clock, long long due) {
+    const long long SPIN_NS = 100000;
+    long long now = clock.end_timer();
+    if (due - now > SPIN_NS) {
+        this_thread::sleep_for(chrono::nanoseconds(due - now - SPIN_NS));
+    }
+    while (clock.end_timer() < due) {
+        this_thread::yield();
+    }
+}
+
+/* Runs the queries on one thread, taking the next query off next until
+ * there are none left. rate is 0 for full speed.
+ */
+void replayThread(const DictionaryTrie& trie,
+                  const vector<ReplayQuery>& queries, atomic<size_t>& next,
+                  Timer clock, double rate, TypeHistograms* hists) {
+    while (true) {
+        size_t i = next.fetch_add(1);
+        if (i >= queries.size()) break;
+        const ReplayQuery& query = queries[i];
+
+        long long due = 0;
+        if (rate > 0) {
+            due = (long long)(i * 1e9 / rate);
+            waitUntil(clock, due);
+        }
+
+        long long start = clock.end_timer();
+        if (query.pattern) {
+            trie.predictUnderscores(query.text, query.numCompletions);
+        } else {
+            trie.predictCompletions(query.text, query.numCompletions);
+        }
+        long long done = clock.end_timer();
+
+        TypeHistograms& hist = hists[query.pattern ? UNDERSCORE : PREFIX];
+        hist.service.record(done - start);
+        hist.response.record(done - (rate > 0 ? due : start));
+    }
+}
+
+/* Prints the summary line of one histogram in microseconds */
+void printSummary(const string& name, const LatencyHistogram& hist) {
+    cout << "  " << name << ": " << hist.count() << " queries, mean "
+         << hist.mean() / 1000 << " us, p50 " << hist.valueAt(0.5) / 1000.0
+         << " us, p90 " << hist.valueAt(0.9) / 1000.0 << " us, p99 "
+         << hist.valueAt(0.99) / 1000.0 << " us, p99.9 "
+         << hist.valueAt(0.999) / 1000.0 << " us, max "
+         << hist.max() / 1000.0 << " us" << endl;
+}
+
+/* arg 1 - Input file name (in format like freq_dict.txt)
+ * arg 2 - Query log file name, "K query" on every line
+ * then any of:
+ *   --rate <n>      run at n queries per second instead of full speed
+ *   --threads <n>   threads the queries run on (default 1)
+ *   --dump <file>   write the percentile distributions to file
+ */
+int main(int argc, char** argv) {
+    const int MIN_ARG = 3;
+    double rate = 0;
+    unsigned int numThreads = 1;
+    string dumpFile;
+    bool valid = argc >= MIN_ARG && (argc - MIN_ARG) % 2 == 0;
+    for (int i = MIN_ARG; valid && i < argc; i += 2) {
+        string flag = argv[i];
+        char* end;
+        if (flag == "--rate") {
+            rate = strtod(argv[i + 1], &end);
+            valid = *end == '\0' && rate > 0;
+        } else if (flag == "--threads") {
+            numThreads = strtoul(argv[i + 1], &end, 10);
+            valid = *end == '\0' && numThreads > 0;
+        } else if (flag == "--dump") {
+            dumpFile = argv[i + 1];
+        } else {
+            valid = false;
+        }
+    }
+    if (!valid) {
+        cout << "Invalid arguments.\n"
+             << "Usage: ./replay <dictionary filename> <query log filename> "
+             << "[--rate <queries/s>] [--threads <n>] [--dump <file>]"
+             << endl;
+        return -1;
+    }
+    if (!fileValid(argv[1]) || !fileValid(argv[2])) return -1;
+
+    cout << "Reading file: " << argv[1] << endl;
+    DictionaryTrie trie;
+    ifstream in(argv[1], ios::binary);
+    Timer timer;
+    timer.begin_timer();
+    Utils::loadDict(trie, in);
+    cout << "Loaded in " << timer.end_timer() / 1000000 << " ms" << endl;
+
+    vector<ReplayQuery> queries;
+    readLog(argv[2], queries);
+    cout << "Replaying " << queries.size() << " queries on " << numThreads
+         << " threads at ";
+    if (rate > 0) {
+        cout << rate << " queries/s" << endl;
+    } else {
+        cout << "full speed" << endl;
+    }
+
+    // every thread keeps its own histograms, they are added up after
+    vector<vector<TypeHistograms>> perThread(
+        numThreads, vector<TypeHistograms>(NUM_TYPES));
+    atomic<size_t> next(0);
+    Timer clock;
+    clock.begin_timer();
+    vector<thread> threads;
+    for (unsigned int t = 0; t < numThreads; t++) {
+        threads.emplace_back(replayThread, cref(trie), cref(queries),
+                             ref(next), clock, rate, perThread[t].data());
+    }
+    for (thread& t : threads) t.join();
+    long long elapsed = clock.end_timer();
+
+    vector<TypeHistograms> byType(NUM_TYPES);
+    TypeHistograms all;
+    for (vector<TypeHistograms>& hists : perThread) {
+        for (int type = 0; type < NUM_TYPES; type++) {
+            byType[type].add(hists[type]);
+            all.add(hists[type]);
+        }
+    }
+
+    cout << "Finished in " << elapsed / 1000000 << " ms, "
+         << (elapsed == 0 ? 0 : queries.size() * 1e9 / elapsed)
+         << " queries/s" << endl;
+    cout << (rate > 0 ? "Response time (from when each query was due):"
+                      : "Latency:")
+         << endl;
+    printSummary("all", all.response);
+    for (int type = 0; type < NUM_TYPES; type++) {
+        printSummary(TYPE_NAMES[type], byType[type].response);
+    }
+    if (rate > 0) {
+        cout << "Service time (from when a thread started each query):"
+             << endl;
+        printSummary("all", all.service);
+        for (int type = 0; type < NUM_TYPES; type++) {
+            printSummary(TYPE_NAMES[type], byType[type].service);
+        }
+    }
+
+    cout << "\nDistribution of all queries in microseconds:" << endl;
+    all.response.printDistribution(cout, 1000.0);
+
+    if (!dumpFile.empty()) {
+        ofstream out(dumpFile);
+        if (!out.is_open()) {
+            cout << "Could not write distributions: " << dumpFile << endl;
+            return -1;
+        }
+        out << "# all, microseconds\n";
+        all.response.printDistribution(out, 1000.0);
+        for (int type = 0; type < NUM_TYPES; type++) {
+            out << "\n# " << TYPE_NAMES[type] << ", microseconds\n";
+            byType[type].response.printDistribution(out, 1000.0);
+        }
+        cout << "Wrote distributions to " << dumpFile << endl;
+    }
+    return 0;
+}
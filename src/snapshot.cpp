@@ -0,0 +1,69 @@
+/**
+ * This program builds a DictionaryTrie from a dictionary file and writes
+ * it out as a binary snapshot. autocomplete (and anything else using
+ * DictionarySnapshot) can then mmap the snapshot at startup instead of
+ * parsing the dictionary and rebuilding the trie.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: mmap(2) man page
+ */
+#include <fstream>
+#include <iostream>
+#include "DictionarySnapshot.hpp"
+#include "DictionaryTrie.hpp"
+#include "util.hpp"
+
+using namespace std;
+
+/* Check if a given data file is valid */
+bool fileValid(const char* fileName) {
+    ifstream in;
+    in.open(fileName, ios::binary);
+
+    // Check if input file was actually opened
+    if (!in.is_open()) {
+        cout << "Invalid input file. No file was opened. Please try again.\n";
+        return false;
+    }
+
+    // Check for empty file
+    in.seekg(0, ios_base::end);
+    unsigned int len = in.tellg();
+    if (len == 0) {
+        cout << "The file is empty. \n";
+        return false;
+    }
+    in.close();
+    return true;
+}
+
+/* arg 1 - Input file name (in format like freq_dict.txt)
+ * arg 2 - Output snapshot file name
+ */
+int main(int argc, char** argv) {
+    const int NUM_ARG = 3;
+    if (argc != NUM_ARG) {
+        cout << "Invalid number of arguments.\n"
+             << "Usage: ./snapshot <dictionary filename> <snapshot filename>"
+             << endl;
+        return -1;
+    }
+    if (!fileValid(argv[1])) return -1;
+
+    cout << "Reading file: " << argv[1] << endl;
+    DictionaryTrie* dt = new DictionaryTrie();
+    Utils::loadDictFile(*dt, argv[1]);
+
+    bool written = dt->writeSnapshot(argv[2]);
+    delete dt;
+
+    // Read it back once so a bad snapshot is caught here
+    DictionarySnapshot snapshot;
+    if (!written || !snapshot.open(argv[2])) {
+        cout << "Could not write snapshot: " << argv[2] << endl;
+        return -1;
+    }
+    cout << "Wrote " << snapshot.size() << " words to " << argv[2] << endl;
+    return 0;
+}
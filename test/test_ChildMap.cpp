@@ -0,0 +1,204 @@
+/**
+ * This file is a tester for the ChildMap class. The methods tested here
+ * are insert, append, find, replace, erase and iteration, in every layout
+ * the map goes through (Node4, Node16, Node48 and Node256) and across the
+ * moves between them.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources:
+ */
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "ChildMap.hpp"
+
+using namespace std;
+using namespace testing;
+
+/* Stand-in node type, the map only ever stores pointers to it */
+struct TestNode {
+    int id;
+};
+
+TEST(ChildMapTests, EMPTY_TEST) {
+    NodeArena arena;
+    ChildMap<TestNode> map;
+    ASSERT_EQ( map.empty(), true );
+    ASSERT_EQ( map.find('a'), nullptr );
+    ASSERT_EQ( map.begin() == map.end(), true );
+    ASSERT_EQ( map.bytes(), 0 );
+}
+
+TEST(ChildMapTests, SMALL_INSERT_FIND_TEST) {
+    NodeArena arena;
+    ChildMap<TestNode> map;
+    TestNode a{1}, m{2}, z{3};
+    map.insert('m', &m, arena);
+    map.insert('z', &z, arena);
+    map.insert('a', &a, arena);
+    ASSERT_EQ( map.size(), 3 );
+    ASSERT_EQ( map.find('a'), &a );
+    ASSERT_EQ( map.find('m'), &m );
+    ASSERT_EQ( map.find('z'), &z );
+    ASSERT_EQ( map.find('b'), nullptr );
+}
+
+TEST(ChildMapTests, ITERATION_ORDER_TEST) {
+    NodeArena arena;
+    ChildMap<TestNode> map;
+    vector<TestNode> nodes(4);
+    string keys = "d\xe9" "ab";
+    for( unsigned int i = 0; i < keys.size(); i++ ) {
+        map.insert(keys[i], &nodes[i], arena);
+    }
+    string order = "";
+    for( auto iterator = map.begin(); iterator != map.end(); iterator++ ) {
+        order += iterator->first;
+    }
+    //keys are ordered as unsigned bytes, so the accented key comes last
+    ASSERT_EQ( order, "abd\xe9" );
+}
+
+TEST(ChildMapTests, DENSE_SWITCH_TEST) {
+    NodeArena arena;
+    ChildMap<TestNode> map;
+    vector<TestNode> nodes(256);
+    for( int i = 255; i >= 0; i -= 3 ) {
+        map.insert((char) i, &nodes[i], arena);
+    }
+    ASSERT_EQ( map.size(), 86 );
+    for( int i = 0; i < 256; i++ ) {
+        ASSERT_EQ( map.find((char) i), (255 - i) % 3 == 0 ? &nodes[i] :
+                                                            nullptr );
+    }
+    int last = -1;
+    unsigned int seen = 0;
+    for( auto iterator = map.begin(); iterator != map.end(); iterator++ ) {
+        int key = (unsigned char) iterator->first;
+        ASSERT_GT( key, last );
+        ASSERT_EQ( iterator->second, &nodes[key] );
+        last = key;
+        seen++;
+    }
+    ASSERT_EQ( seen, map.size() );
+}
+
+TEST(ChildMapTests, REPLACE_TEST) {
+    NodeArena arena;
+    ChildMap<TestNode> map;
+    vector<TestNode> nodes(64);
+    map.insert('b', &nodes[0], arena);
+    map.insert('a', &nodes[1], arena);
+    map.replace('b', &nodes[2]);
+    ASSERT_EQ( map.find('b'), &nodes[2] );
+    ASSERT_EQ( map.find('a'), &nodes[1] );
+    ASSERT_EQ( map.size(), 2 );
+    //past the small arrays the same key is replaced in the dense table
+    for( int i = 0; i < 40; i++ ) {
+        map.insert((char) ('c' + i), &nodes[3 + i], arena);
+    }
+    map.replace('a', &nodes[63]);
+    ASSERT_EQ( map.find('a'), &nodes[63] );
+    ASSERT_EQ( map.size(), 42 );
+}
+
+/* Checks that map holds exactly the nodes whose keys are set in present,
+ * node i under key i, and iterates over them in key order.
+ */
+static void expectContents( const ChildMap<TestNode> & map,
+                            const vector<TestNode> & nodes,
+                            const vector<bool> & present ) {
+    unsigned int expected = 0;
+    for( int i = 0; i < 256; i++ ) {
+        ASSERT_EQ( map.find((char) i), present[i] ? &nodes[i] : nullptr )
+            << i;
+        expected += present[i];
+    }
+    ASSERT_EQ( map.size(), expected );
+    int last = -1;
+    unsigned int seen = 0;
+    for( auto iterator = map.begin(); iterator != map.end(); iterator++ ) {
+        int key = (unsigned char) iterator->first;
+        ASSERT_GT( key, last );
+        ASSERT_EQ( iterator->second, &nodes[key] );
+        last = key;
+        seen++;
+    }
+    ASSERT_EQ( seen, expected );
+}
+
+TEST(ChildMapTests, LAYOUT_GROWTH_TEST) {
+    NodeArena arena;
+    ChildMap<TestNode> map;
+    vector<TestNode> nodes(256);
+    vector<bool> present(256, false);
+    //keys spread over the whole byte range, so the SIMD search sees
+    //bytes above 127 too
+    for( unsigned int n = 1; n <= 256; n++ ) {
+        int key = ( n * 167 ) % 256;
+        map.insert((char) key, &nodes[key], arena);
+        present[key] = true;
+        expectContents( map, nodes, present );
+        if( n == 4 ) {
+            ASSERT_EQ( map.bytes(), 8 + 4 * sizeof(TestNode*) );
+        } else if( n == 16 ) {
+            ASSERT_EQ( map.bytes(), 16 + 16 * sizeof(TestNode*) );
+        } else if( n == 48 ) {
+            ASSERT_EQ( map.bytes(), 256 + 48 * sizeof(TestNode*) );
+        } else if( n == 49 ) {
+            ASSERT_EQ( map.bytes(), 256 * sizeof(TestNode*) );
+        }
+    }
+}
+
+TEST(ChildMapTests, APPEND_TEST) {
+    NodeArena arena;
+    ChildMap<TestNode> map;
+    vector<TestNode> nodes(256);
+    vector<bool> present(256, false);
+    for( int key = 0; key < 256; key += 2 ) {
+        map.append((char) key, &nodes[key], arena);
+        present[key] = true;
+    }
+    expectContents( map, nodes, present );
+}
+
+TEST(ChildMapTests, ERASE_SHRINK_TEST) {
+    NodeArena arena;
+    ChildMap<TestNode> map;
+    vector<TestNode> nodes(256);
+    vector<bool> present(256, true);
+    for( int key = 0; key < 256; key++ ) {
+        map.insert((char) key, &nodes[key], arena);
+    }
+    ASSERT_EQ( map.erase('a', arena), true );
+    ASSERT_EQ( map.erase('a', arena), false );
+    present['a'] = false;
+
+    //erase in a scattered order, through every layout back to empty
+    for( unsigned int n = 0; n < 256; n++ ) {
+        int key = ( n * 101 + 7 ) % 256;
+        if( !present[key] ) continue;
+        ASSERT_EQ( map.erase((char) key, arena), true );
+        present[key] = false;
+        expectContents( map, nodes, present );
+        if( map.size() == 40 ) {
+            ASSERT_EQ( map.bytes(), 256 + 48 * sizeof(TestNode*) );
+        }
+        if( map.size() == 12 ) {
+            ASSERT_EQ( map.bytes(), 16 + 16 * sizeof(TestNode*) );
+        }
+        if( map.size() == 3 ) {
+            ASSERT_EQ( map.bytes(), 8 + 4 * sizeof(TestNode*) );
+        }
+    }
+    ASSERT_EQ( map.empty(), true );
+    ASSERT_EQ( map.bytes(), 0 );
+
+    //the map can be filled again after being emptied
+    map.insert('q', &nodes['q'], arena);
+    ASSERT_EQ( map.find('q'), &nodes['q'] );
+}
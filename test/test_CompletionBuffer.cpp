@@ -0,0 +1,121 @@
+/**
+ * This file is a tester for the allocation free predictCompletions()
+ * that writes into a DictionaryTrie::CompletionBuffer. It replaces the
+ * global operator new with one that counts calls, so it checks both that
+ * the buffer gets the same words as the vector version and that queries
+ * stop allocating once the buffer has grown.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources: cppreference "replaceable allocation functions"
+ */
+
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "DictionaryTrie.hpp"
+
+using namespace std;
+using namespace testing;
+
+//number of times operator new has been called
+static unsigned long long allocations = 0;
+
+//the replacements pair up with each other, but once g++ inlines them it
+//only sees malloc memory going to operator delete and warns
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void* operator new( size_t size ) {
+    allocations++;
+    void* memory = malloc( size == 0 ? 1 : size );
+    if( memory == nullptr ) {
+        throw bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete( void* memory ) noexcept {
+    free( memory );
+}
+
+void operator delete( void* memory, size_t ) noexcept {
+    free( memory );
+}
+
+#pragma GCC diagnostic pop
+
+/* Fills dict with a dictionary big enough for a real frontier */
+static void fillDict( DictionaryTrie & dict ) {
+    string word = "aaaa";
+    for( unsigned int i = 0; i < 2000; i++ ) {
+        unsigned int x = i;
+        for( unsigned int j = 0; j < word.size(); j++ ) {
+            word[j] = 'a' + x % 6;
+            x /= 6;
+        }
+        dict.insert( word.substr( 0, 2 + i % 3 ), ( i * 37 ) % 101 );
+    }
+    dict.insert("a really long word that does not fit small strings", 5);
+}
+
+/* Returns the words of buffer as strings */
+static vector<string> toStrings( const DictionaryTrie::CompletionBuffer & b ) {
+    vector<string> words;
+    for( size_t i = 0; i < b.size(); i++ ) {
+        words.push_back( string( b[i] ) );
+    }
+    return words;
+}
+
+TEST(CompletionBufferTests, SAME_AS_VECTOR_TEST) {
+    DictionaryTrie dict;
+    fillDict( dict );
+    DictionaryTrie::CompletionBuffer buffer;
+    vector<string> prefixes = {"", "a", "ab", "fe", "a r", "zz", "abc"};
+    for( auto & prefix : prefixes ) {
+        for( unsigned int k = 0; k <= 12; k++ ) {
+            dict.predictCompletions( prefix, k, buffer );
+            ASSERT_EQ( toStrings( buffer ), dict.predictCompletions(prefix,
+                                                                    k) );
+        }
+    }
+
+    dict.enableTopKCache(4);
+    dict.predictCompletions( "b", 3, buffer );
+    ASSERT_EQ( toStrings( buffer ), dict.predictCompletions("b", 3) );
+}
+
+TEST(CompletionBufferTests, NO_ALLOCATION_TEST) {
+    DictionaryTrie dict;
+    fillDict( dict );
+    DictionaryTrie::CompletionBuffer buffer;
+    vector<string> prefixes = {"", "a", "ab", "fe", "a r", "zz", "abc"};
+
+    //the first round grows the buffer to fit
+    for( auto & prefix : prefixes ) {
+        dict.predictCompletions( prefix, 20, buffer );
+    }
+
+    unsigned long long before = allocations;
+    size_t found = 0;
+    for( unsigned int round = 0; round < 10; round++ ) {
+        for( auto & prefix : prefixes ) {
+            dict.predictCompletions( prefix, 20, buffer );
+            found += buffer.size();
+        }
+    }
+    ASSERT_EQ( allocations - before, 0 );
+    ASSERT_GT( found, 0 );
+
+    //the top-K cache path copies words without allocating either
+    dict.enableTopKCache(20);
+    dict.predictCompletions( "", 20, buffer );
+    before = allocations;
+    dict.predictCompletions( "", 20, buffer );
+    ASSERT_EQ( allocations - before, 0 );
+    ASSERT_EQ( buffer.size(), 20 );
+}
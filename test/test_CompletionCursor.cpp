@@ -0,0 +1,107 @@
+/**
+ * This file is a tester for the CompletionCursor class. The tests type
+ * and backspace through a small dictionary and check that the cursor
+ * always gives the same list as predictCompletions() on the typed
+ * prefix, with and without the top-K cache.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources:
+ */
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "CompletionCursor.hpp"
+#include "DictionaryTrie.hpp"
+
+using namespace std;
+using namespace testing;
+
+/* Fills dict with a small dictionary shared by the tests */
+static void fillDict( DictionaryTrie & dict ) {
+    dict.insert("a", 4);
+    dict.insert("an", 1000);
+    dict.insert("and", 800);
+    dict.insert("animal", 100);
+    dict.insert("animation", 100);
+    dict.insert("anagram", 10);
+    dict.insert("anarchy", 5);
+    dict.insert("annihilate", 50);
+    dict.insert("apple", 300);
+    dict.insert("application", 40);
+    dict.insert("apply", 60);
+    dict.insert("beauty", 20);
+}
+
+TEST(CompletionCursorTests, TYPING_TEST) {
+    DictionaryTrie dict;
+    fillDict( dict );
+    CompletionCursor cursor( dict );
+    ASSERT_EQ( cursor.text(), "" );
+    ASSERT_EQ( cursor.topK(3), dict.predictCompletions("", 3) );
+
+    string typed = "animation";
+    for( unsigned int i = 0; i < typed.size(); i++ ) {
+        ASSERT_TRUE( cursor.push( typed[i] ) );
+        ASSERT_EQ( cursor.text(), typed.substr(0, i + 1) );
+        for( unsigned int k = 0; k <= 12; k++ ) {
+            ASSERT_EQ( cursor.topK(k), dict.predictCompletions(cursor.text(),
+                                                               k) );
+        }
+    }
+}
+
+TEST(CompletionCursorTests, BACKSPACE_TEST) {
+    DictionaryTrie dict;
+    fillDict( dict );
+    CompletionCursor cursor( dict );
+    ASSERT_FALSE( cursor.pop() );
+
+    //rank a few words for "an" before going deeper, then come back
+    cursor.push('a');
+    cursor.push('n');
+    ASSERT_EQ( cursor.topK(2), dict.predictCompletions("an", 2) );
+    cursor.push('i');
+    ASSERT_EQ( cursor.topK(5), dict.predictCompletions("ani", 5) );
+    ASSERT_TRUE( cursor.pop() );
+    ASSERT_EQ( cursor.text(), "an" );
+    ASSERT_EQ( cursor.topK(10), dict.predictCompletions("an", 10) );
+    cursor.push('a');
+    ASSERT_EQ( cursor.topK(10), dict.predictCompletions("ana", 10) );
+    ASSERT_TRUE( cursor.pop() );
+    ASSERT_TRUE( cursor.pop() );
+    cursor.push('p');
+    ASSERT_EQ( cursor.topK(10), dict.predictCompletions("ap", 10) );
+}
+
+TEST(CompletionCursorTests, MISSING_PREFIX_TEST) {
+    DictionaryTrie dict;
+    fillDict( dict );
+    CompletionCursor cursor( dict );
+    cursor.push('b');
+    ASSERT_FALSE( cursor.push('x') );
+    ASSERT_FALSE( cursor.push('y') );
+    ASSERT_EQ( cursor.topK(10).size(), 0 );
+    cursor.pop();
+    ASSERT_EQ( cursor.topK(10).size(), 0 );
+    cursor.pop();
+    ASSERT_EQ( cursor.text(), "b" );
+    ASSERT_EQ( cursor.topK(10)[0], "beauty" );
+}
+
+TEST(CompletionCursorTests, TOPK_CACHE_TEST) {
+    DictionaryTrie dict;
+    fillDict( dict );
+    dict.enableTopKCache(3);
+    CompletionCursor cursor( dict );
+    string typed = "appl";
+    for( unsigned int i = 0; i < typed.size(); i++ ) {
+        cursor.push( typed[i] );
+        for( unsigned int k = 0; k <= 6; k++ ) {
+            ASSERT_EQ( cursor.topK(k), dict.predictCompletions(cursor.text(),
+                                                               k) );
+        }
+    }
+}
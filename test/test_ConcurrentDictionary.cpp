@@ -0,0 +1,111 @@
+/**
+ * This file is a tester for the ConcurrentDictionary class. The tests
+ * check that readers see a published trie, that retired tries are only
+ * reclaimed once no reader can be using them, and that readers running
+ * against a publishing writer always get a complete answer from one of
+ * the versions.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources:
+ */
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "ConcurrentDictionary.hpp"
+#include "DictionaryTrie.hpp"
+
+using namespace std;
+using namespace testing;
+
+/* Returns a trie holding the word "v<n>" and "version", which is always
+ * the more frequent one
+ */
+static DictionaryTrie* makeVersion( unsigned int n ) {
+    DictionaryTrie* dict = new DictionaryTrie();
+    dict->insert("version", n + 2);
+    dict->insert("v" + to_string(n), n + 1);
+    return dict;
+}
+
+TEST(ConcurrentDictTests, PUBLISH_TEST) {
+    ConcurrentDictionary dict( makeVersion(0) );
+    ConcurrentDictionary::Reader reader( dict );
+
+    ASSERT_TRUE( reader.find("v0") );
+    ASSERT_FALSE( reader.find("v1") );
+
+    dict.publish( makeVersion(1) );
+    ASSERT_TRUE( reader.find("v1") );
+    ASSERT_FALSE( reader.find("v0") );
+    ASSERT_EQ( dict.publishes(), 1 );
+
+    vector<string> vec = reader.predictCompletions("v", 10);
+    ASSERT_EQ( vec.size(), 2 );
+    ASSERT_EQ( vec[1], "v1" );
+    vec = reader.predictUnderscores("__", 5);
+    ASSERT_EQ( vec.size(), 1 );
+    ASSERT_EQ( vec[0], "v1" );
+}
+
+TEST(ConcurrentDictTests, RECLAIM_TEST) {
+    ConcurrentDictionary dict( makeVersion(0) );
+
+    //no reader is inside a query, so the old version goes right away
+    dict.publish( makeVersion(1) );
+    ASSERT_EQ( dict.pendingReclaim(), 0 );
+
+    {
+        ConcurrentDictionary::Reader reader( dict );
+        ASSERT_TRUE( reader.find("v1") );
+        dict.publish( makeVersion(2) );
+        ASSERT_EQ( dict.pendingReclaim(), 0 );
+    }
+    ASSERT_EQ( dict.pendingReclaim(), 0 );
+}
+
+TEST(ConcurrentDictTests, READERS_WITH_WRITER_TEST) {
+    const unsigned int NUM_VERSIONS = 200;
+    const unsigned int NUM_READERS = 3;
+
+    ConcurrentDictionary dict( makeVersion(0) );
+    atomic<bool> done( false );
+    atomic<unsigned int> bad( 0 );
+
+    vector<thread> readers;
+    for( unsigned int r = 0; r < NUM_READERS; r++ ) {
+        readers.push_back( thread( [&]() {
+            ConcurrentDictionary::Reader reader( dict );
+            while( !done.load() ) {
+                //every version has exactly two words starting with v
+                vector<string> vec = reader.predictCompletions("v", 10);
+                if( vec.size() != 2 || vec[0] != "version" ) {
+                    bad++;
+                }
+                if( !reader.find("version") ) {
+                    bad++;
+                }
+            }
+        } ) );
+    }
+
+    for( unsigned int n = 1; n <= NUM_VERSIONS; n++ ) {
+        dict.publish( makeVersion(n) );
+    }
+    done.store( true );
+    for( unsigned int r = 0; r < NUM_READERS; r++ ) {
+        readers[r].join();
+    }
+
+    ASSERT_EQ( bad.load(), 0 );
+    ASSERT_EQ( dict.publishes(), NUM_VERSIONS );
+    dict.reclaim();
+    ASSERT_EQ( dict.pendingReclaim(), 0 );
+
+    ConcurrentDictionary::Reader reader( dict );
+    ASSERT_TRUE( reader.find("v" + to_string(NUM_VERSIONS)) );
+}
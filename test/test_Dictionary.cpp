@@ -0,0 +1,232 @@
+/**
+ * This file is a tester for the Dictionary interface. Every test runs on
+ * every backend, and the last ones build the same random dictionary in a
+ * DictionaryTrie, a TernarySearchTree and a RadixTrie and check that
+ * every query gets the same answer from all of them.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources:
+ */
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "Dictionary.hpp"
+#include "RadixTrie.hpp"
+#include "TernarySearchTree.hpp"
+
+using namespace std;
+using namespace testing;
+
+//every backend the tests run on
+static const DictionaryBackend BACKENDS[] = { DictionaryBackend::MWT,
+                                              DictionaryBackend::TST,
+                                              DictionaryBackend::RADIX };
+
+/* Fills dict with a few words that share prefixes */
+static void insertSmall( Dictionary & dict ) {
+    dict.insert("a", 1);
+    dict.insert("an", 7);
+    dict.insert("and", 20);
+    dict.insert("ant", 20);
+    dict.insert("anteater", 3);
+    dict.insert("apple", 15);
+    dict.insert("bat", 9);
+    dict.insert("cat", 12);
+    dict.insert("cut", 12);
+}
+
+/* Returns n random words over a small alphabet so they share prefixes */
+static vector<string> randomWords( unsigned int n, unsigned int seed ) {
+    mt19937 gen(seed);
+    uniform_int_distribution<int> len(1, 8);
+    uniform_int_distribution<int> letter(0, 4);
+    vector<string> words;
+    for (unsigned int i = 0; i < n; i++) {
+        string word;
+        int l = len(gen);
+        for (int j = 0; j < l; j++) {
+            word.push_back((char)('a' + letter(gen)));
+        }
+        words.push_back(word);
+    }
+    return words;
+}
+
+TEST(DictionaryTests, PARSE_BACKEND_TEST) {
+    DictionaryBackend backend = DictionaryBackend::MWT;
+    ASSERT_TRUE(Dictionary::parseBackend("tst", backend));
+    ASSERT_EQ(backend, DictionaryBackend::TST);
+    ASSERT_TRUE(Dictionary::parseBackend("mwt", backend));
+    ASSERT_EQ(backend, DictionaryBackend::MWT);
+    ASSERT_TRUE(Dictionary::parseBackend("radix", backend));
+    ASSERT_EQ(backend, DictionaryBackend::RADIX);
+    ASSERT_FALSE(Dictionary::parseBackend("art", backend));
+    ASSERT_EQ(backend, DictionaryBackend::RADIX);
+    ASSERT_EQ(string(Dictionary::backendName(DictionaryBackend::TST)), "tst");
+}
+
+TEST(DictionaryTests, INSERT_FIND_TEST) {
+    for (DictionaryBackend backend : BACKENDS) {
+        unique_ptr<Dictionary> dict = Dictionary::create(backend);
+        ASSERT_FALSE(dict->find("ant"));
+        ASSERT_FALSE(dict->insert("", 5));
+        insertSmall(*dict);
+        ASSERT_TRUE(dict->find("ant"));
+        ASSERT_TRUE(dict->find("a"));
+        ASSERT_FALSE(dict->find("ante"));
+        ASSERT_FALSE(dict->find("apples"));
+        ASSERT_FALSE(dict->find(""));
+        ASSERT_FALSE(dict->insert("ant", 50));
+        ASSERT_GT(dict->memoryBytes(), 0u);
+    }
+}
+
+TEST(DictionaryTests, PREDICT_COMPLETIONS_TEST) {
+    for (DictionaryBackend backend : BACKENDS) {
+        unique_ptr<Dictionary> dict = Dictionary::create(backend);
+        insertSmall(*dict);
+        vector<string> expected = {"and", "ant", "an", "anteater"};
+        ASSERT_EQ(dict->predictCompletions("an", 10), expected);
+        expected = {"and", "ant"};
+        ASSERT_EQ(dict->predictCompletions("a", 2), expected);
+        expected = {"cat", "cut"};
+        ASSERT_EQ(dict->predictCompletions("c", 10), expected);
+        ASSERT_TRUE(dict->predictCompletions("d", 10).empty());
+        ASSERT_TRUE(dict->predictCompletions("an", 0).empty());
+    }
+}
+
+TEST(DictionaryTests, PREDICT_UNDERSCORES_TEST) {
+    for (DictionaryBackend backend : BACKENDS) {
+        unique_ptr<Dictionary> dict = Dictionary::create(backend);
+        insertSmall(*dict);
+        vector<string> expected = {"and", "ant", "cat", "cut", "bat"};
+        ASSERT_EQ(dict->predictUnderscores("___", 10), expected);
+        expected = {"cat", "cut"};
+        ASSERT_EQ(dict->predictUnderscores("c_t", 10), expected);
+        expected = {"and"};
+        ASSERT_EQ(dict->predictUnderscores("_n_", 1), expected);
+        ASSERT_TRUE(dict->predictUnderscores("____", 10).empty());
+        ASSERT_TRUE(dict->predictUnderscores("", 10).empty());
+    }
+}
+
+TEST(DictionaryTests, LONG_WORD_TEST) {
+    string longWord(100000, 'q');
+    for (DictionaryBackend backend : BACKENDS) {
+        unique_ptr<Dictionary> dict = Dictionary::create(backend);
+        ASSERT_TRUE(dict->insert(longWord, 4));
+        ASSERT_TRUE(dict->find(longWord));
+        vector<string> expected = {longWord};
+        ASSERT_EQ(dict->predictCompletions("qq", 5), expected);
+    }
+}
+
+TEST(DictionaryTests, TST_NODE_COUNT_TEST) {
+    TernarySearchTree tst;
+    tst.insert("cat", 1);
+    tst.insert("cut", 1);
+    tst.insert("car", 1);
+    //c, a, t, u, t, r
+    ASSERT_EQ(tst.nodeCount(), 6u);
+}
+
+TEST(DictionaryTests, RADIX_SPLIT_TEST) {
+    RadixTrie radix;
+    radix.insert("international", 5);
+    //the root and one leaf holding the whole word
+    ASSERT_EQ(radix.nodeCount(), 2u);
+    radix.insert("internet", 9);
+    //"intern" is split off, "ational" and "et" hang below it
+    ASSERT_EQ(radix.nodeCount(), 4u);
+    radix.insert("intern", 2);
+    ASSERT_EQ(radix.nodeCount(), 4u);
+    radix.insert("in", 1);
+    ASSERT_EQ(radix.nodeCount(), 5u);
+    ASSERT_TRUE(radix.find("intern"));
+    ASSERT_TRUE(radix.find("in"));
+    ASSERT_FALSE(radix.find("int"));
+    ASSERT_FALSE(radix.find("internets"));
+
+    //prefixes that end in the middle of an edge
+    vector<string> expected = {"internet", "international", "intern"};
+    ASSERT_EQ(radix.predictCompletions("int", 10), expected);
+    expected = {"international"};
+    ASSERT_EQ(radix.predictCompletions("internat", 10), expected);
+    ASSERT_TRUE(radix.predictCompletions("internav", 10).empty());
+    expected = {"internet"};
+    ASSERT_EQ(radix.predictUnderscores("in_er_e_", 10), expected);
+    expected = {"intern"};
+    ASSERT_EQ(radix.predictUnderscores("i___r_", 10), expected);
+}
+
+TEST(DictionaryTests, BACKENDS_AGREE_TEST) {
+    vector<string> words = randomWords(3000, 7);
+    unique_ptr<Dictionary> mwt = Dictionary::create(DictionaryBackend::MWT);
+    vector<unique_ptr<Dictionary>> others;
+    others.push_back(Dictionary::create(DictionaryBackend::TST));
+    others.push_back(Dictionary::create(DictionaryBackend::RADIX));
+    mt19937 gen(11);
+    uniform_int_distribution<unsigned int> freq(1, 50);
+    for (const string& word : words) {
+        unsigned int f = freq(gen);
+        bool inserted = mwt->insert(word, f);
+        for (unique_ptr<Dictionary>& other : others) {
+            ASSERT_EQ(other->insert(word, f), inserted);
+        }
+    }
+
+    vector<string> queries = randomWords(500, 13);
+    for (const string& query : queries) {
+        string pattern = query;
+        for (size_t i = 0; i < pattern.size(); i += 2) {
+            pattern[i] = '_';
+        }
+        for (unique_ptr<Dictionary>& other : others) {
+            ASSERT_EQ(mwt->find(query), other->find(query)) << query;
+            for (unsigned int k : {1u, 5u, 40u}) {
+                ASSERT_EQ(mwt->predictCompletions(query.substr(0, 3), k),
+                          other->predictCompletions(query.substr(0, 3), k))
+                    << query;
+                ASSERT_EQ(mwt->predictUnderscores(pattern, k),
+                          other->predictUnderscores(pattern, k))
+                    << pattern;
+            }
+        }
+    }
+}
+
+TEST(DictionaryTests, RADIX_FEWER_NODES_TEST) {
+    unique_ptr<Dictionary> mwt = Dictionary::create(DictionaryBackend::MWT);
+    unique_ptr<Dictionary> radix =
+        Dictionary::create(DictionaryBackend::RADIX);
+    for (const string& word : randomWords(2000, 17)) {
+        mwt->insert(word + " and the rest of the phrase", 1);
+        radix->insert(word + " and the rest of the phrase", 1);
+    }
+    //every long shared tail is one node in the radix trie
+    ASSERT_LT(radix->nodeCount() * 5, mwt->nodeCount());
+}
+
+TEST(DictionaryTests, INSERT_KEEPS_QUERY_STATS_TEST) {
+    for (DictionaryBackend backend : BACKENDS) {
+        unique_ptr<Dictionary> dict = Dictionary::create(backend);
+        insertSmall(*dict);
+        dict->predictCompletions("an", 2);
+        QueryStats before = Dictionary::lastQueryStats();
+        //new words and duplicates alike are not queries
+        for (unsigned int i = 0; i < 100; i++) {
+            ASSERT_FALSE(dict->insert("anteater", 40));
+        }
+        ASSERT_TRUE(dict->insert("antelope", 4));
+        QueryStats after = Dictionary::lastQueryStats();
+        ASSERT_EQ(after.nodesVisited, before.nodesVisited);
+        ASSERT_EQ(after.childLookups, before.childLookups);
+        ASSERT_EQ(after.candidatesCollected, before.candidatesCollected);
+    }
+}
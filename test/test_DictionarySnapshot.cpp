@@ -0,0 +1,169 @@
+/**
+ * This file is a tester for the DictionarySnapshot class. Each test
+ * builds a DictionaryTrie, writes it out with writeSnapshot() and checks
+ * that the mapped snapshot answers find, predictCompletions and
+ * predictUnderscores the same way as the trie.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources:
+ */
+
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "DictionarySnapshot.hpp"
+#include "DictionaryTrie.hpp"
+
+using namespace std;
+using namespace testing;
+
+static const string SNAPSHOT_FILE = "test_DictionarySnapshot.bin";
+
+/* Fills dict with a small dictionary shared by the tests */
+static void fillDict( DictionaryTrie & dict ) {
+    dict.insert("animal", 100);
+    dict.insert("acme", 90);
+    dict.insert("coffee", 10);
+    dict.insert("animation", 100);
+    dict.insert("anarchy", 5);
+    dict.insert("beauty", 20);
+    dict.insert("an", 1000);
+    dict.insert("annihilate", 50);
+    dict.insert("anagram", 10);
+    dict.insert("band", 100);
+    dict.insert("hand", 90);
+    dict.insert("land", 90);
+    dict.insert("a b", 7);
+}
+
+TEST(DictSnapshotTests, MISSING_FILE_TEST) {
+    DictionarySnapshot snapshot;
+    ASSERT_EQ( snapshot.open("no_such_snapshot.bin"), false );
+    ASSERT_EQ( snapshot.find("an"), false );
+    ASSERT_EQ( snapshot.predictCompletions("a", 3).size(), 0 );
+}
+
+TEST(DictSnapshotTests, NOT_A_SNAPSHOT_TEST) {
+    ofstream out( SNAPSHOT_FILE, ios::binary );
+    out << "10 not a snapshot at all" << endl;
+    out.close();
+    DictionarySnapshot snapshot;
+    ASSERT_EQ( DictionarySnapshot::isSnapshot(SNAPSHOT_FILE), false );
+    ASSERT_EQ( snapshot.open(SNAPSHOT_FILE), false );
+    remove( SNAPSHOT_FILE.c_str() );
+}
+
+/* Writes dict's snapshot, lets corrupt change its bytes and returns
+ * whether the result still opens
+ */
+template <typename Corrupt>
+static bool opensCorrupted( const DictionaryTrie & dict, Corrupt corrupt ) {
+    dict.writeSnapshot( SNAPSHOT_FILE );
+    ifstream in( SNAPSHOT_FILE, ios::binary );
+    string image( ( istreambuf_iterator<char>( in ) ),
+                  istreambuf_iterator<char>() );
+    in.close();
+    corrupt( image );
+    ofstream out( SNAPSHOT_FILE, ios::binary | ios::trunc );
+    out.write( image.data(), image.size() );
+    out.close();
+    DictionarySnapshot snapshot;
+    bool opened = snapshot.open( SNAPSHOT_FILE );
+    remove( SNAPSHOT_FILE.c_str() );
+    return opened;
+}
+
+TEST(DictSnapshotTests, CORRUPT_FILE_TEST) {
+    DictionaryTrie dict;
+    fillDict( dict );
+    ASSERT_EQ( opensCorrupted( dict, []( string & ) {} ), true );
+
+    //cut off in the middle of the node array
+    ASSERT_EQ( opensCorrupted( dict, []( string & image ) {
+        image.resize( sizeof(SnapshotHeader) + 3 * sizeof(SnapshotNode) );
+    } ), false );
+
+    //an offset so big that adding the array size wraps around
+    ASSERT_EQ( opensCorrupted( dict, []( string & image ) {
+        SnapshotHeader* header = (SnapshotHeader*) &image[0];
+        header->keysOffset = UINT64_MAX - 2;
+    } ), false );
+
+    //the root pointing back at itself, and a child range past the end
+    ASSERT_EQ( opensCorrupted( dict, []( string & image ) {
+        SnapshotHeader* header = (SnapshotHeader*) &image[0];
+        SnapshotNode* nodes = (SnapshotNode*) &image[header->nodesOffset];
+        nodes[0].firstChild = 0;
+    } ), false );
+    ASSERT_EQ( opensCorrupted( dict, []( string & image ) {
+        SnapshotHeader* header = (SnapshotHeader*) &image[0];
+        SnapshotNode* nodes = (SnapshotNode*) &image[header->nodesOffset];
+        nodes[1].childCount = header->nodeCount;
+    } ), false );
+}
+
+TEST(DictSnapshotTests, FIND_TEST) {
+    DictionaryTrie dict;
+    fillDict( dict );
+    ASSERT_EQ( dict.writeSnapshot(SNAPSHOT_FILE), true );
+    DictionarySnapshot snapshot;
+    ASSERT_EQ( DictionarySnapshot::isSnapshot(SNAPSHOT_FILE), true );
+    ASSERT_EQ( snapshot.open(SNAPSHOT_FILE), true );
+    ASSERT_EQ( snapshot.size(), 13 );
+    ASSERT_EQ( snapshot.find("animal"), true );
+    ASSERT_EQ( snapshot.find("a b"), true );
+    ASSERT_EQ( snapshot.find("anim"), false );
+    ASSERT_EQ( snapshot.find(""), false );
+    ASSERT_EQ( snapshot.find("zebra"), false );
+    remove( SNAPSHOT_FILE.c_str() );
+}
+
+TEST(DictSnapshotTests, MATCHES_TRIE_TEST) {
+    DictionaryTrie dict;
+    fillDict( dict );
+    ASSERT_EQ( dict.writeSnapshot(SNAPSHOT_FILE), true );
+    DictionarySnapshot snapshot;
+    ASSERT_EQ( snapshot.open(SNAPSHOT_FILE), true );
+    vector<string> prefixes = {"", "a", "an", "ani", "b", "z", "a "};
+    vector<string> patterns = {"_and", "an_", "____", "a_b", "_", "______",
+                               "_______", "a______", "an____"};
+    for( unsigned int k = 0; k <= 6; k++ ) {
+        for( auto & p : prefixes ) {
+            ASSERT_EQ( snapshot.predictCompletions(p, k),
+                       dict.predictCompletions(p, k) );
+        }
+        for( auto & p : patterns ) {
+            ASSERT_EQ( snapshot.predictUnderscores(p, k),
+                       dict.predictUnderscores(p, k) );
+        }
+    }
+    remove( SNAPSHOT_FILE.c_str() );
+}
+
+TEST(DictSnapshotTests, LONG_KEY_TEST) {
+    string phrase;
+    while( phrase.size() < 200000 ) {
+        phrase += "word ";
+    }
+    DictionaryTrie dict;
+    dict.insert(phrase + "a", 30);
+    dict.insert(phrase + "b", 20);
+    dict.insert("wore", 5);
+    ASSERT_EQ( dict.writeSnapshot(SNAPSHOT_FILE), true );
+    DictionarySnapshot snapshot;
+    ASSERT_EQ( snapshot.open(SNAPSHOT_FILE), true );
+    ASSERT_EQ( snapshot.predictCompletions("wo", 5),
+               dict.predictCompletions("wo", 5) );
+    string blanks = string( phrase.size() + 1, '_' );
+    ASSERT_EQ( snapshot.predictUnderscores(blanks, 5),
+               dict.predictUnderscoresRecursive(blanks, 5) );
+    ASSERT_EQ( snapshot.predictUnderscores(blanks, 5).size(), 2 );
+    snapshot.close();
+    remove( SNAPSHOT_FILE.c_str() );
+}
@@ -8,6 +8,7 @@
  */
 
 #include <algorithm>
+#include <climits>
 #include <fstream>
 #include <iostream>
 #include <set>
@@ -16,6 +17,7 @@
 
 #include <gtest/gtest.h>
 #include "DictionaryTrie.hpp"
+#include "Utf8.hpp"
 #include "util.hpp"
 
 using namespace std;
@@ -181,3 +183,520 @@ TEST(DictTrieTests, PREDICT_UNDERSCORES_ALPH_ORDER_TEST) {
     ASSERT_EQ( list[1], "hand" );
 }
 
+
+TEST(DictTrieTests, PREDICT_UNDERSCORES_LENGTH_TEST) {
+    vector<pair<string, unsigned int>> words = {
+        {"sing", 10}, {"song", 30}, {"singing", 5}, {"sting", 50},
+        {"swing", 40}, {"s", 7}, {"king", 20}, {"kingdom", 60}};
+    DictionaryTrie dict;
+    DictionaryTrie sorted;
+    vector<pair<string, unsigned int>> inOrder = words;
+    std::sort( inOrder.begin(), inOrder.end() );
+    sorted.beginSorted();
+    for( auto & w : inOrder ) {
+        dict.insert( w.first, w.second );
+        sorted.appendSorted( w.first, w.second );
+    }
+    sorted.endSorted();
+
+    for( DictionaryTrie* d : { &dict, &sorted } ) {
+        vector<string> list = d->predictUnderscores("__ing", 10);
+        ASSERT_EQ( list.size(), 2 );
+        ASSERT_EQ( list[0], "sting" );
+        ASSERT_EQ( list[1], "swing" );
+        list = d->predictUnderscores("___ing", 10);
+        ASSERT_EQ( list.size(), 0 );
+        list = d->predictUnderscores("_", 10);
+        ASSERT_EQ( list.size(), 1 );
+        ASSERT_EQ( list[0], "s" );
+        ASSERT_EQ( d->predictUnderscores("________", 10).size(), 0 );
+        ASSERT_EQ( d->predictUnderscores("", 10).size(), 0 );
+    }
+}
+
+TEST(DictTrieTests, PREDICT_UNDERSCORES_BOUNDED_TEST) {
+    DictionaryTrie dict;
+    dict.insert("aa", 1);
+    dict.insert("ab", 5);
+    dict.insert("ac", 5);
+    dict.insert("ba", 9);
+    dict.insert("bb", 1);
+    dict.insert("ca", 5);
+    vector<string> list = dict.predictUnderscores("__", 3);
+    ASSERT_EQ( list.size(), 3 );
+    ASSERT_EQ( list[0], "ba" );
+    ASSERT_EQ( list[1], "ab" );
+    ASSERT_EQ( list[2], "ac" );
+    list = dict.predictUnderscores("__", 1);
+    ASSERT_EQ( list.size(), 1 );
+    ASSERT_EQ( list[0], "ba" );
+    ASSERT_EQ( dict.predictUnderscores("__", 0).size(), 0 );
+}
+
+TEST(DictTrieTests, PREDICT_COMPLETIONS_DEEP_SUBTREE_TEST) {
+    DictionaryTrie dict;
+    dict.insert("a", 1);
+    dict.insert("ab", 2);
+    dict.insert("abcdefgh", 500);
+    dict.insert("abd", 3);
+    dict.insert("az", 500);
+    dict.insert("b", 1000);
+    vector<string> list = dict.predictCompletions("a", 3);
+    ASSERT_EQ( list.size(), 3 );
+    ASSERT_EQ( list[0], "abcdefgh" );
+    ASSERT_EQ( list[1], "az" );
+    ASSERT_EQ( list[2], "abd" );
+}
+
+TEST(DictTrieTests, PREDICT_COMPLETIONS_PREFIX_TIE_TEST) {
+    DictionaryTrie dict;
+    dict.insert("bat", 7);
+    dict.insert("ba", 7);
+    dict.insert("batch", 7);
+    dict.insert("bb", 7);
+    vector<string> list = dict.predictCompletions("b", 4);
+    ASSERT_EQ( list[0], "ba" );
+    ASSERT_EQ( list[1], "bat" );
+    ASSERT_EQ( list[2], "batch" );
+    ASSERT_EQ( list[3], "bb" );
+}
+
+TEST(DictTrieTests, PREDICT_COMPLETIONS_REINSERT_FREQ_TEST) {
+    DictionaryTrie dict;
+    dict.insert("cat", 5);
+    dict.insert("car", 10);
+    dict.insert("cat", 100);
+    vector<string> list = dict.predictCompletions("ca", 1);
+    ASSERT_EQ( list[0], "car" );
+    ASSERT_EQ( dict.predictCompletions("ca", 0).size(), 0 );
+}
+
+TEST(DictTrieTests, PREDICT_FUZZY_TYPO_TEST) {
+    DictionaryTrie dict;
+    dict.insert("hello", 10);
+    dict.insert("help", 50);
+    dict.insert("helmet", 20);
+    dict.insert("yellow", 100);
+    dict.insert("jello", 5);
+    dict.insert("world", 30);
+    vector<string> list = dict.predictFuzzy("hwl", 10, 1);
+    vector<string> expected = {"help", "helmet", "hello"};
+    ASSERT_EQ( list, expected );
+    list = dict.predictFuzzy("helo", 10, 2);
+    expected = {"help", "helmet", "hello", "yellow", "jello"};
+    ASSERT_EQ( list, expected );
+    ASSERT_EQ( dict.predictFuzzy("helo", 0, 2).size(), 0 );
+    ASSERT_EQ( dict.predictFuzzy("zzzz", 10, 2).size(), 0 );
+}
+
+TEST(DictTrieTests, PREDICT_FUZZY_DISTANCE_ORDER_TEST) {
+    DictionaryTrie dict;
+    dict.insert("card", 100);
+    dict.insert("cart", 5);
+    dict.insert("cartoon", 1);
+    //a closer word wins over a more frequent one, and the words under
+    //both "car" and "cart" only come out once
+    vector<string> list = dict.predictFuzzy("cart", 10, 1);
+    vector<string> expected = {"cart", "cartoon", "card"};
+    ASSERT_EQ( list, expected );
+}
+
+TEST(DictTrieTests, PREDICT_FUZZY_ZERO_DISTANCE_TEST) {
+    DictionaryTrie dict;
+    dict.insert("bat", 7);
+    dict.insert("ba", 7);
+    dict.insert("batch", 7);
+    dict.insert("bb", 7);
+    dict.insert("cab", 3);
+    dict.insert("abc", 9);
+    vector<string> prefixes = {"", "b", "ba", "bat", "c", "x", "abcd"};
+    for( auto & prefix : prefixes ) {
+        for( unsigned int k = 0; k <= 7; k++ ) {
+            ASSERT_EQ( dict.predictFuzzy(prefix, k, 0),
+                       dict.predictCompletions(prefix, k) );
+        }
+    }
+}
+
+TEST(DictTrieTests, TOPK_CACHE_MATCHES_SEARCH_TEST) {
+    DictionaryTrie dict;
+    DictionaryTrie cached;
+    vector<pair<string, unsigned int>> words = {
+        {"animal", 100}, {"acme", 90},     {"coffee", 10}, {"animation", 100},
+        {"anarchy", 5},  {"beauty", 20},   {"an", 1000},   {"annihilate", 50},
+        {"anagram", 10}, {"ant", 10},      {"a", 10}};
+    for( auto & w : words ) {
+        dict.insert( w.first, w.second );
+        cached.insert( w.first, w.second );
+    }
+    cached.enableTopKCache(3);
+    ASSERT_GT( cached.topKCacheBytes(), 0 );
+    vector<string> prefixes = {"", "a", "an", "ani", "b", "z"};
+    for( auto & p : prefixes ) {
+        for( unsigned int k = 1; k <= 5; k++ ) {
+            ASSERT_EQ( cached.predictCompletions(p, k),
+                       dict.predictCompletions(p, k) );
+        }
+    }
+}
+
+TEST(DictTrieTests, TOPK_CACHE_INSERT_TEST) {
+    DictionaryTrie dict;
+    dict.enableTopKCache(2);
+    dict.insert("tea", 5);
+    dict.insert("ten", 5);
+    dict.insert("tee", 5);
+    vector<string> list = dict.predictCompletions("te", 2);
+    ASSERT_EQ( list[0], "tea" );
+    ASSERT_EQ( list[1], "tee" );
+    dict.insert("te", 50);
+    dict.insert("tent", 20);
+    list = dict.predictCompletions("t", 2);
+    ASSERT_EQ( list[0], "te" );
+    ASSERT_EQ( list[1], "tent" );
+    dict.enableTopKCache(0);
+    ASSERT_EQ( dict.topKCacheBytes(), 0 );
+    ASSERT_EQ( dict.predictCompletions("t", 2)[1], "tent" );
+}
+
+TEST(DictTrieTests, UPDATE_FREQUENCY_TEST) {
+    DictionaryTrie dict;
+    DictionaryTrie cached;
+    cached.enableTopKCache(2);
+    vector<pair<string, unsigned int>> words = {
+        {"tea", 5}, {"ten", 30}, {"tee", 20}, {"te", 10}, {"tent", 40}};
+    for( auto & w : words ) {
+        dict.insert( w.first, w.second );
+        cached.insert( w.first, w.second );
+    }
+
+    //lower the best word below everything else
+    ASSERT_TRUE( dict.updateFrequency("tent", 1) );
+    ASSERT_TRUE( cached.updateFrequency("tent", 1) );
+    vector<string> list = dict.predictCompletions("t", 2);
+    ASSERT_EQ( list[0], "ten" );
+    ASSERT_EQ( list[1], "tee" );
+    ASSERT_EQ( cached.predictCompletions("t", 2), list );
+    ASSERT_EQ( dict.predictCompletions("tent", 1)[0], "tent" );
+
+    //raise a word to the top and tie it with another
+    ASSERT_TRUE( dict.updateFrequency("tea", 30) );
+    ASSERT_TRUE( cached.updateFrequency("tea", 30) );
+    list = dict.predictCompletions("t", 2);
+    ASSERT_EQ( list[0], "tea" );
+    ASSERT_EQ( list[1], "ten" );
+    ASSERT_EQ( cached.predictCompletions("t", 2), list );
+    ASSERT_EQ( dict.predictUnderscores("te_", 1)[0], "tea" );
+
+    //prefixes and missing words are not updated
+    ASSERT_FALSE( dict.updateFrequency("t", 100) );
+    ASSERT_FALSE( dict.updateFrequency("tenth", 100) );
+    ASSERT_FALSE( dict.updateFrequency("", 100) );
+    ASSERT_FALSE( dict.find("t") );
+}
+
+TEST(DictTrieTests, INCREMENT_FREQUENCY_TEST) {
+    DictionaryTrie dict;
+    dict.enableTopKCache(1);
+    dict.insert("cat", 5);
+    dict.insert("car", 10);
+    ASSERT_TRUE( dict.incrementFrequency("cat") );
+    ASSERT_EQ( dict.predictCompletions("ca", 1)[0], "car" );
+    ASSERT_TRUE( dict.incrementFrequency("cat", 4) );
+    ASSERT_EQ( dict.predictCompletions("ca", 1)[0], "car" );
+    ASSERT_TRUE( dict.incrementFrequency("cat", 1) );
+    ASSERT_EQ( dict.predictCompletions("ca", 1)[0], "cat" );
+    ASSERT_FALSE( dict.incrementFrequency("ca") );
+
+    //the frequency stops at the largest value instead of wrapping
+    ASSERT_TRUE( dict.incrementFrequency("car", UINT_MAX) );
+    ASSERT_TRUE( dict.incrementFrequency("car", UINT_MAX) );
+    ASSERT_EQ( dict.predictCompletions("c", 1)[0], "car" );
+}
+
+TEST(DictTrieTests, RESULT_CACHE_HIT_TEST) {
+    DictionaryTrie dict;
+    dict.insert("an", 1000);
+    dict.insert("animal", 100);
+    dict.insert("anagram", 10);
+    dict.insert("beauty", 20);
+    dict.enableResultCache(4);
+    vector<string> expected = dict.predictCompletions("an", 2);
+    ASSERT_EQ( dict.predictCompletions("an", 2), expected );
+    ASSERT_EQ( dict.predictCompletions("an", 3).size(), 3 );
+    ASSERT_EQ( dict.predictCompletions("zz", 3).size(), 0 );
+    ASSERT_EQ( dict.predictCompletions("zz", 3).size(), 0 );
+    ResultCacheStats stats = dict.resultCacheStats();
+    ASSERT_EQ( stats.hits, 2 );
+    ASSERT_EQ( stats.misses, 3 );
+    ASSERT_EQ( stats.evictions, 0 );
+    ASSERT_EQ( stats.entries, 3 );
+
+    dict.enableResultCache(0);
+    dict.predictCompletions("an", 2);
+    ASSERT_EQ( dict.resultCacheStats().hits, 2 );
+    ASSERT_EQ( dict.resultCacheStats().entries, 0 );
+}
+
+TEST(DictTrieTests, RESULT_CACHE_EVICTION_TEST) {
+    DictionaryTrie dict;
+    dict.insert("apple", 10);
+    dict.insert("banana", 20);
+    dict.insert("cherry", 30);
+    dict.enableResultCache(2);
+    dict.predictCompletions("a", 1);
+    dict.predictCompletions("b", 1);
+    //using "a" again makes "b" the least recently used
+    dict.predictCompletions("a", 1);
+    dict.predictCompletions("c", 1);
+    ResultCacheStats stats = dict.resultCacheStats();
+    ASSERT_EQ( stats.evictions, 1 );
+    ASSERT_EQ( stats.entries, 2 );
+    dict.predictCompletions("a", 1);
+    ASSERT_EQ( dict.resultCacheStats().hits, 2 );
+    ASSERT_EQ( dict.predictCompletions("b", 1)[0], "banana" );
+    ASSERT_EQ( dict.resultCacheStats().misses, 4 );
+}
+
+TEST(DictTrieTests, RESULT_CACHE_INVALIDATE_TEST) {
+    DictionaryTrie dict;
+    dict.insert("card", 10);
+    dict.insert("care", 20);
+    dict.insert("dog", 5);
+    dict.enableResultCache(10);
+    ASSERT_EQ( dict.predictCompletions("ca", 1)[0], "care" );
+    ASSERT_EQ( dict.predictCompletions("", 1)[0], "care" );
+    ASSERT_EQ( dict.predictCompletions("d", 1)[0], "dog" );
+    ASSERT_EQ( dict.predictCompletions("cars", 1).size(), 0 );
+
+    //only the prefixes of the new word are dropped
+    dict.insert("cars", 50);
+    ASSERT_EQ( dict.resultCacheStats().invalidations, 3 );
+    ASSERT_EQ( dict.predictCompletions("ca", 1)[0], "cars" );
+    ASSERT_EQ( dict.predictCompletions("", 1)[0], "cars" );
+    ASSERT_EQ( dict.predictCompletions("cars", 1)[0], "cars" );
+    ASSERT_EQ( dict.predictCompletions("d", 1)[0], "dog" );
+    ASSERT_EQ( dict.resultCacheStats().hits, 1 );
+
+    dict.updateFrequency("dog", 100);
+    ASSERT_EQ( dict.predictCompletions("", 1)[0], "dog" );
+    dict.incrementFrequency("card", 200);
+    ASSERT_EQ( dict.predictCompletions("ca", 1)[0], "card" );
+}
+
+TEST(DictTrieTests, TRIE_STATS_TEST) {
+    DictionaryTrie dict;
+    dict.insert("an", 1000);
+    dict.insert("ant", 10);
+    dict.insert("and", 20);
+    dict.insert("be", 5);
+    TrieStats stats = dict.trieStats();
+    //root, a, n, t, d, b, e
+    ASSERT_EQ( stats.nodes, 7 );
+    ASSERT_EQ( stats.words, 4 );
+    vector<size_t> depths = {1, 2, 2, 2};
+    ASSERT_EQ( stats.depthHistogram, depths );
+    vector<size_t> fanOut = {3, 2, 2};
+    ASSERT_EQ( stats.fanOutHistogram, fanOut );
+    ASSERT_EQ( stats.nodeBytes + stats.childMapBytes, dict.memoryBytes() );
+    ASSERT_EQ( stats.arenaBytes, dict.arenaBytes() );
+    ASSERT_EQ( stats.resultCacheBytes, 0 );
+
+    dict.enableResultCache(4);
+    dict.predictCompletions("a", 2);
+    ASSERT_GT( dict.trieStats().resultCacheBytes, 0 );
+}
+
+TEST(DictTrieTests, QUERY_STATS_TEST) {
+    DictionaryTrie dict;
+    dict.insert("an", 1000);
+    dict.insert("ant", 10);
+    dict.insert("and", 20);
+    dict.insert("be", 5);
+
+    dict.predictCompletions("an", 2);
+    QueryStats stats = DictionaryTrie::lastQueryStats();
+    if( !QueryStats::ENABLED ) {
+        ASSERT_EQ( stats.nodesVisited, 0 );
+        ASSERT_EQ( stats.childLookups, 0 );
+        return;
+    }
+    ASSERT_EQ( stats.childLookups, 2 );
+    ASSERT_GE( stats.nodesVisited, 3 );
+    ASSERT_GE( stats.candidatesCollected, 2 );
+    ASSERT_FALSE( stats.topKCacheHit );
+
+    //a missing prefix stops at the first lookup that fails
+    dict.predictCompletions("bz", 2);
+    stats = DictionaryTrie::lastQueryStats();
+    ASSERT_EQ( stats.childLookups, 2 );
+    ASSERT_EQ( stats.candidatesCollected, 0 );
+
+    dict.predictUnderscores("a_d", 2);
+    stats = DictionaryTrie::lastQueryStats();
+    ASSERT_EQ( stats.candidatesCollected, 1 );
+    ASSERT_GE( stats.nodesVisited, 3 );
+
+    dict.enableTopKCache(2);
+    dict.predictCompletions("an", 2);
+    ASSERT_TRUE( DictionaryTrie::lastQueryStats().topKCacheHit );
+
+    DictionaryTrie::CompletionBuffer out;
+    dict.predictCompletions("", 3, out);
+    ASSERT_GT( DictionaryTrie::lastQueryStats().bytesAllocated, 0 );
+    //the buffer is big enough the second time round
+    dict.predictCompletions("", 3, out);
+    ASSERT_EQ( DictionaryTrie::lastQueryStats().bytesAllocated, 0 );
+}
+
+TEST(DictTrieTests, LONG_KEY_TEST) {
+    //a phrase far deeper than a recursive walk's stack could go
+    string phrase;
+    while( phrase.size() < 200000 ) {
+        phrase += "word ";
+    }
+    string longA = phrase + "a";
+    string longB = phrase + "b";
+    string half = phrase.substr( 0, 100000 );
+    DictionaryTrie dict;
+    dict.insert(longA, 30);
+    dict.insert(longB, 20);
+    dict.insert(half, 10);
+    dict.insert("wore", 5);
+    dict.insert("zebra", 1);
+
+    ASSERT_TRUE( dict.find(longA) );
+    ASSERT_FALSE( dict.find(phrase) );
+    vector<string> expected = {longA, longB, half, "wore"};
+    ASSERT_EQ( dict.predictCompletions("wo", 10), expected );
+    DictionaryTrie::CompletionBuffer buffer;
+    dict.predictCompletions( "wo", 3, buffer );
+    ASSERT_EQ( buffer.size(), 3 );
+    ASSERT_EQ( buffer[1], longB );
+
+    //the pattern engine steps a state set as long as the pattern, so
+    //its deep walks are checked with short patterns
+    string blanks = string( longA.size(), '_' );
+    expected = {longA, longB};
+    ASSERT_EQ( dict.predictUnderscoresRecursive(blanks, 5), expected );
+    ASSERT_EQ( dict.predictWildcards("*b", 5)[0], longB );
+    ASSERT_EQ( dict.predictWildcards("w*", 2)[1], longB );
+
+    expected = {longA, longB, half};
+    ASSERT_EQ( dict.predictFuzzy("wprd", 3, 1), expected );
+
+    ASSERT_GT( dict.memoryBytes(), 300000 * sizeof(void*) );
+    dict.enableTopKCache(2);
+    ASSERT_EQ( dict.predictCompletions(phrase, 2)[1], longB );
+    ASSERT_EQ( dict.predictCompletions(half, 3)[2], half );
+}
+
+TEST(DictTrieTests, ARENA_BYTES_TEST) {
+    DictionaryTrie dict;
+    size_t empty = dict.arenaBytes();
+    for( char c = 'a'; c <= 'z'; c++ ) {
+        dict.insert(string(100, c), 1);
+    }
+    ASSERT_GT( dict.arenaBytes(), empty );
+    ASSERT_GE( dict.arenaBytes(), dict.memoryBytes() );
+    ASSERT_EQ( dict.find(string(100, 'q')), true );
+}
+
+TEST(DictTrieTests, ABSORB_TEST) {
+    DictionaryTrie dict;
+    DictionaryTrie shard;
+    dict.insert("apple", 10);
+    shard.insert("banana", 20);
+    shard.insert("bandana", 5);
+    ASSERT_EQ( dict.absorb(shard), true );
+    ASSERT_EQ( dict.find("banana"), true );
+    ASSERT_EQ( shard.find("banana"), false );
+    ASSERT_EQ( dict.predictCompletions("", 1)[0], "banana" );
+
+    DictionaryTrie clash;
+    clash.insert("avocado", 1);
+    ASSERT_EQ( dict.absorb(clash), false );
+    ASSERT_EQ( clash.find("avocado"), true );
+    ASSERT_EQ( dict.find("avocado"), false );
+}
+
+TEST(DictTrieTests, SORTED_BULK_LOAD_TEST) {
+    vector<pair<string, unsigned int>> words = {
+        {"a", 10},      {"acme", 90},    {"an", 1000},      {"anagram", 10},
+        {"anarchy", 5}, {"animal", 100}, {"animation", 100}, {"ant", 10},
+        {"beauty", 20}, {"coffee", 10}};
+    DictionaryTrie dict;
+    DictionaryTrie bulk;
+    bulk.beginSorted();
+    for( auto & w : words ) {
+        dict.insert( w.first, w.second );
+        ASSERT_EQ( bulk.appendSorted( w.first, w.second ), true );
+    }
+    ASSERT_EQ( bulk.appendSorted( "coffee", 1 ), false );
+    ASSERT_EQ( bulk.endSorted(), true );
+    ASSERT_EQ( bulk.memoryBytes(), dict.memoryBytes() );
+    for( string prefix : {"", "a", "an", "ani", "b", "z"} ) {
+        ASSERT_EQ( bulk.predictCompletions(prefix, 4),
+                   dict.predictCompletions(prefix, 4) );
+    }
+}
+
+TEST(DictTrieTests, SORTED_BULK_LOAD_FALLBACK_TEST) {
+    DictionaryTrie bulk;
+    bulk.enableTopKCache(2);
+    bulk.beginSorted();
+    bulk.appendSorted( "bee", 5 );
+    bulk.appendSorted( "beetle", 50 );
+    //out of order, the rest goes through insert()
+    ASSERT_EQ( bulk.appendSorted( "ant", 7 ), true );
+    bulk.appendSorted( "bear", 60 );
+    ASSERT_EQ( bulk.endSorted(), false );
+    ASSERT_EQ( bulk.find("bee"), true );
+    ASSERT_EQ( bulk.find("ant"), true );
+    vector<string> list = bulk.predictCompletions("be", 2);
+    ASSERT_EQ( list[0], "bear" );
+    ASSERT_EQ( list[1], "beetle" );
+    ASSERT_EQ( bulk.predictCompletions("", 1)[0], "bear" );
+}
+
+TEST(DictTrieTests, UTF8_VALID_TEST) {
+    ASSERT_TRUE( validUtf8("") );
+    ASSERT_TRUE( validUtf8("plain") );
+    ASSERT_TRUE( validUtf8("\xce\xbb\xe4\xb8\xad\xf0\x9f\x98\x80") );
+    //a stray continuation, a cut off letter, an overlong '/', a surrogate
+    //and a code point past U+10FFFF
+    ASSERT_FALSE( validUtf8("a\xbb") );
+    ASSERT_FALSE( validUtf8("a\xce") );
+    ASSERT_FALSE( validUtf8("\xc0\xaf") );
+    ASSERT_FALSE( validUtf8("\xed\xa0\x80") );
+    ASSERT_FALSE( validUtf8("\xf4\x90\x80\x80") );
+
+    string text;
+    appendUtf8( text, 'a' );
+    appendUtf8( text, 0x3bb );
+    appendUtf8( text, 0x4e2d );
+    appendUtf8( text, 0x1f600 );
+    appendUtf8( text, 0xd800 );
+    ASSERT_EQ( text, "a\xce\xbb\xe4\xb8\xad\xf0\x9f\x98\x80" );
+    ASSERT_EQ( utf8Length( text ), 4 );
+}
+
+TEST(DictTrieTests, UTF8_MODE_INSERT_TEST) {
+    DictionaryTrie dict;
+    ASSERT_EQ( dict.isUtf8(), false );
+    ASSERT_EQ( dict.insert( "a\xce", 1 ), true );
+
+    DictionaryTrie utf8;
+    utf8.setUtf8( true );
+    ASSERT_EQ( utf8.isUtf8(), true );
+    ASSERT_EQ( utf8.insert( "a\xce", 1 ), false );
+    ASSERT_EQ( utf8.insert( "\xce\xbb", 1 ), true );
+    ASSERT_EQ( utf8.find( "\xce\xbb" ), true );
+
+    utf8.beginSorted();
+    ASSERT_EQ( utf8.appendSorted( "\xce\xbc", 2 ), true );
+    ASSERT_EQ( utf8.appendSorted( "\xce\xbd\xff", 2 ), false );
+    utf8.endSorted();
+    ASSERT_EQ( utf8.find( "\xce\xbd\xff" ), false );
+    ASSERT_EQ( utf8.predictCompletions( "\xce", 5 ).size(), 2 );
+}
@@ -0,0 +1,54 @@
+/**
+ * This file is a tester for the NodeArena class. The methods tested here
+ * are allocate, release and the byte counters.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources:
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <set>
+
+#include <gtest/gtest.h>
+#include "NodeArena.hpp"
+
+using namespace std;
+using namespace testing;
+
+TEST(NodeArenaTests, EMPTY_TEST) {
+    NodeArena arena;
+    ASSERT_EQ( arena.bytesAllocated(), 0 );
+    ASSERT_EQ( arena.bytesInUse(), 0 );
+}
+
+TEST(NodeArenaTests, ALIGNED_DISTINCT_TEST) {
+    NodeArena arena;
+    set<char*> blocks;
+    for( unsigned int i = 1; i < 2000; i++ ) {
+        char* block = (char*) arena.allocate( i % 37 + 1 );
+        ASSERT_EQ( (uintptr_t) block % sizeof(void*), 0 );
+        memset( block, 0xab, i % 37 + 1 );
+        ASSERT_EQ( blocks.count(block), 0 );
+        blocks.insert( block );
+    }
+    ASSERT_GE( arena.bytesAllocated(), arena.bytesInUse() );
+}
+
+TEST(NodeArenaTests, RELEASE_REUSE_TEST) {
+    NodeArena arena;
+    void* first = arena.allocate( 40 );
+    size_t inUse = arena.bytesInUse();
+    arena.release( first, 40 );
+    ASSERT_LT( arena.bytesInUse(), inUse );
+    ASSERT_EQ( arena.allocate( 40 ), first );
+    ASSERT_NE( arena.allocate( 40 ), first );
+}
+
+TEST(NodeArenaTests, LARGE_BLOCK_TEST) {
+    NodeArena arena;
+    char* block = (char*) arena.allocate( 1 << 20 );
+    memset( block, 0, 1 << 20 );
+    ASSERT_GE( arena.bytesAllocated(), (size_t) 1 << 20 );
+}
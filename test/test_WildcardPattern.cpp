@@ -0,0 +1,334 @@
+/**
+ * This file is a tester for the WildcardPattern class and the pattern
+ * queries of DictionaryTrie that run on it. The tests check the compiler
+ * against whole words, then check predictWildcards() on a small
+ * dictionary and that predictUnderscores() still gives the same answers
+ * as the old recursive matcher. The last ones do the same for UTF-8 mode,
+ * where a wildcard is a whole code point.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources:
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "DictionaryTrie.hpp"
+#include "Utf8.hpp"
+#include "WildcardPattern.hpp"
+
+using namespace std;
+using namespace testing;
+
+/* Fills dict with a small dictionary shared by the tests */
+static void fillDict( DictionaryTrie & dict ) {
+    dict.insert("sing", 10);
+    dict.insert("song", 30);
+    dict.insert("singing", 5);
+    dict.insert("sting", 50);
+    dict.insert("swing", 40);
+    dict.insert("king", 20);
+    dict.insert("kingdom", 60);
+    dict.insert("action", 25);
+    dict.insert("station", 35);
+    dict.insert("a*b", 3);
+    dict.insert("s", 7);
+}
+
+TEST(WildcardPatternTests, MATCHES_TEST) {
+    WildcardPattern p;
+    ASSERT_FALSE( p.matches("") );
+    ASSERT_FALSE( p.matches("a") );
+
+    ASSERT_TRUE( p.compile("*ing") );
+    ASSERT_TRUE( p.matches("ing") );
+    ASSERT_TRUE( p.matches("singing") );
+    ASSERT_FALSE( p.matches("ingot") );
+
+    ASSERT_TRUE( p.compile("s?n_") );
+    ASSERT_TRUE( p.matches("sing") );
+    ASSERT_TRUE( p.matches("song") );
+    ASSERT_FALSE( p.matches("sting") );
+
+    ASSERT_TRUE( p.compile("[a-c]*[^aeiou]") );
+    ASSERT_TRUE( p.matches("cat") );
+    ASSERT_TRUE( p.matches("bt") );
+    ASSERT_TRUE( p.matches("cab") );
+    ASSERT_FALSE( p.matches("bee") );
+    ASSERT_FALSE( p.matches("dog") );
+
+    ASSERT_TRUE( p.compile("a**b*") );
+    ASSERT_TRUE( p.matches("ab") );
+    ASSERT_TRUE( p.matches("axxbyy") );
+    ASSERT_FALSE( p.matches("ba") );
+
+    ASSERT_TRUE( p.compile("a\\*b[]x]") );
+    ASSERT_TRUE( p.matches("a*b]") );
+    ASSERT_TRUE( p.matches("a*bx") );
+    ASSERT_FALSE( p.matches("axb]") );
+
+    ASSERT_TRUE( p.compile("") );
+    ASSERT_TRUE( p.matches("") );
+    ASSERT_FALSE( p.matches("a") );
+}
+
+TEST(WildcardPatternTests, MALFORMED_TEST) {
+    WildcardPattern p;
+    ASSERT_FALSE( p.compile("ab[cd") );
+    ASSERT_FALSE( p.matches("abc") );
+    ASSERT_FALSE( p.compile("ab\\") );
+    ASSERT_FALSE( p.matches("ab") );
+    ASSERT_FALSE( p.matches("ab\\") );
+
+    DictionaryTrie dict;
+    fillDict( dict );
+    ASSERT_EQ( dict.predictWildcards("[s", 10).size(), 0 );
+}
+
+TEST(WildcardPatternTests, LONG_PATTERN_TEST) {
+    //more steps than fit in one word of the state set
+    string word = string( 150, 'x' ) + "y";
+    WildcardPattern p;
+    p.compileUnderscores( string( 150, '_' ) + "y" );
+    ASSERT_TRUE( p.matches(word) );
+    ASSERT_FALSE( p.matches(word + "y") );
+    ASSERT_TRUE( p.compile( string( 70, '?' ) + "*y" ) );
+    ASSERT_TRUE( p.matches(word) );
+    ASSERT_FALSE( p.matches( string( 69, 'x' ) + "y" ) );
+
+    DictionaryTrie dict;
+    dict.insert( word, 5 );
+    ASSERT_EQ( dict.predictUnderscores( string( 150, '_' ) + "y", 1 )[0],
+               word );
+    ASSERT_EQ( dict.predictWildcards( "*" + string( 65, '?' ) + "y", 1 )[0],
+               word );
+}
+
+TEST(WildcardPatternTests, PREDICT_WILDCARDS_TEST) {
+    DictionaryTrie dict;
+    fillDict( dict );
+
+    vector<string> list = dict.predictWildcards("*ing", 10);
+    vector<string> expected = {"sting", "swing", "king", "sing", "singing"};
+    ASSERT_EQ( list, expected );
+
+    list = dict.predictWildcards("*ing", 2);
+    ASSERT_EQ( list.size(), 2 );
+    ASSERT_EQ( list[1], "swing" );
+
+    list = dict.predictWildcards("[ks]*", 3);
+    expected = {"kingdom", "sting", "swing"};
+    ASSERT_EQ( list, expected );
+
+    list = dict.predictWildcards("*tion", 10);
+    expected = {"station", "action"};
+    ASSERT_EQ( list, expected );
+
+    list = dict.predictWildcards("s[^t]*", 10);
+    expected = {"swing", "song", "sing", "singing"};
+    ASSERT_EQ( list, expected );
+
+    ASSERT_EQ( dict.predictWildcards("a\\*b", 10)[0], "a*b" );
+    ASSERT_EQ( dict.predictWildcards("a*b", 10).size(), 1 );
+    ASSERT_EQ( dict.predictWildcards("*", 0).size(), 0 );
+    ASSERT_EQ( dict.predictWildcards("*", 100).size(), 11 );
+}
+
+TEST(WildcardPatternTests, UNDERSCORES_MATCH_RECURSIVE_TEST) {
+    DictionaryTrie dict;
+    fillDict( dict );
+    vector<string> patterns = {"__ing", "_ing", "s___", "_", "", "a*_",
+                               "_______", "k__g___", "________"};
+    for( auto & p : patterns ) {
+        for( unsigned int k = 0; k <= 6; k++ ) {
+            ASSERT_EQ( dict.predictUnderscores(p, k),
+                       dict.predictUnderscoresRecursive(p, k) );
+        }
+    }
+}
+
+TEST(WildcardPatternTests, UTF8_MATCHES_TEST) {
+    WildcardPattern p;
+    //a byte wildcard only covers half of a two byte letter
+    ASSERT_TRUE( p.compile("a_b") );
+    ASSERT_FALSE( p.matches("aλb") );
+
+    //one wildcard per code point of 1, 2, 3 and 4 bytes
+    ASSERT_TRUE( p.compile("a_b", true) );
+    ASSERT_TRUE( p.matches("axb") );
+    ASSERT_TRUE( p.matches("aλb") );
+    ASSERT_TRUE( p.matches("a中b") );
+    ASSERT_TRUE( p.matches("a😀b") );
+    ASSERT_FALSE( p.matches("ab") );
+    ASSERT_FALSE( p.matches("aλλb") );
+
+    ASSERT_TRUE( p.compile("*_", true) );
+    ASSERT_TRUE( p.matches("中") );
+    ASSERT_TRUE( p.matches("xλ中") );
+    ASSERT_FALSE( p.matches("") );
+
+    ASSERT_TRUE( p.compile("_*λ", true) );
+    ASSERT_TRUE( p.matches("中λ") );
+    ASSERT_TRUE( p.matches("中xxλ") );
+    ASSERT_FALSE( p.matches("λ") );
+
+    ASSERT_TRUE( p.compile("[^ab]c", true) );
+    ASSERT_TRUE( p.matches("中c") );
+    ASSERT_TRUE( p.matches("xc") );
+    ASSERT_FALSE( p.matches("ac") );
+    ASSERT_TRUE( p.compile("[a-c]_", true) );
+    ASSERT_TRUE( p.matches("bλ") );
+    ASSERT_FALSE( p.matches("λb") );
+
+    //a class cannot list a multi byte letter in UTF-8 mode
+    ASSERT_FALSE( p.compile("[λ]", true) );
+    ASSERT_FALSE( p.matches("λ") );
+    ASSERT_TRUE( p.compile("[λ]") );
+
+    p.compileUnderscores("_λ_", true);
+    ASSERT_TRUE( p.matches("中λx") );
+    ASSERT_TRUE( p.matches("λλλ") );
+    ASSERT_FALSE( p.matches("λλ") );
+    ASSERT_FALSE( p.matches("*λ*x") );
+}
+
+TEST(WildcardPatternTests, UTF8_REMAINING_TEST) {
+    WildcardPattern p;
+    p.compileUnderscores("a__", true);
+    vector<uint64_t> set( p.setWords() );
+    p.start( set.data() );
+    size_t lo;
+    size_t hi;
+    //a code point is 1 to 4 bytes
+    p.remaining( set.data(), lo, hi );
+    ASSERT_EQ( lo, 3 );
+    ASSERT_EQ( hi, 9 );
+
+    ASSERT_TRUE( p.compile("_*", true) );
+    p.start( set.data() );
+    p.remaining( set.data(), lo, hi );
+    ASSERT_EQ( lo, 1 );
+    ASSERT_EQ( hi, SIZE_MAX );
+}
+
+TEST(WildcardPatternTests, UTF8_DICT_TEST) {
+    vector<pair<string, unsigned int>> words = {
+        {"γάτα", 30}, {"γίδα", 20}, {"γάλα", 25}, {"gata", 10},
+        {"中文", 40}, {"中国", 50}, {"日本", 15}, {"λ", 5}};
+    DictionaryTrie bytes;
+    DictionaryTrie dict;
+    dict.setUtf8( true );
+    for( auto & w : words ) {
+        bytes.insert( w.first, w.second );
+        ASSERT_TRUE( dict.insert( w.first, w.second ) );
+    }
+
+    //byte wildcards only find words of as many bytes
+    vector<string> expected = {"gata"};
+    ASSERT_EQ( bytes.predictUnderscores("____", 10), expected );
+    expected = {"λ"};
+    ASSERT_EQ( bytes.predictUnderscores("__", 10), expected );
+
+    expected = {"γάτα", "γάλα", "γίδα", "gata"};
+    ASSERT_EQ( dict.predictUnderscores("____", 10), expected );
+    expected = {"中国", "中文", "日本"};
+    ASSERT_EQ( dict.predictUnderscores("__", 10), expected );
+    expected = {"中国"};
+    ASSERT_EQ( dict.predictUnderscores("中_", 1), expected );
+    expected = {"λ"};
+    ASSERT_EQ( dict.predictUnderscores("_", 10), expected );
+    expected = {"γάτα"};
+    ASSERT_EQ( dict.predictUnderscores("γ_τα", 10), expected );
+
+    expected = {"γάτα", "γάλα", "γίδα"};
+    ASSERT_EQ( dict.predictWildcards("*α", 10), expected );
+    ASSERT_EQ( dict.predictWildcards("γ?[^x]α", 10), expected );
+    ASSERT_EQ( dict.predictWildcards("[γ]*", 10).size(), 0 );
+}
+
+TEST(WildcardPatternTests, UTF8_RANDOM_TEST) {
+    //words over letters of every width, so the code points of a pattern
+    //and of a word rarely line up byte for byte
+    const uint32_t letters[] = {'a', 'b', 0x3bb, 0x3bc, 0x4e2d, 0x1f600};
+    mt19937 gen(5);
+    uniform_int_distribution<int> len(1, 5);
+    uniform_int_distribution<int> letter(0, 5);
+    uniform_int_distribution<unsigned int> freq(1, 20);
+
+    DictionaryTrie dict;
+    dict.setUtf8( true );
+    vector<vector<uint32_t>> points;
+    vector<pair<string, unsigned int>> words;
+    for( unsigned int i = 0; i < 2000; i++ ) {
+        vector<uint32_t> cps;
+        string word;
+        for( int j = len(gen); j > 0; j-- ) {
+            cps.push_back( letters[letter(gen)] );
+            appendUtf8( word, cps.back() );
+        }
+        unsigned int f = freq(gen);
+        if( dict.insert( word, f ) ) {
+            points.push_back( cps );
+            words.push_back( {word, f} );
+        }
+    }
+
+    for( unsigned int q = 0; q < 300; q++ ) {
+        //a word of the dictionary with some of its letters blanked
+        vector<uint32_t> cps = points[gen() % points.size()];
+        string pattern;
+        for( uint32_t cp : cps ) {
+            if( gen() % 2 ) {
+                pattern.push_back('_');
+                cp = 0;
+            } else {
+                appendUtf8( pattern, cp );
+            }
+        }
+
+        vector<pair<string, unsigned int>> found;
+        for( unsigned int i = 0; i < words.size(); i++ ) {
+            bool match = points[i].size() == utf8Length( pattern );
+            size_t pos = 0;
+            for( unsigned int j = 0; j < points[i].size() && match; j++ ) {
+                string letter;
+                appendUtf8( letter, points[i][j] );
+                if( pattern[pos] == '_' ) {
+                    pos++;
+                } else {
+                    match = pattern.compare( pos, letter.size(), letter ) == 0;
+                    pos += letter.size();
+                }
+            }
+            if( match ) {
+                found.push_back( words[i] );
+            }
+        }
+        sort( found.begin(), found.end(),
+              []( const pair<string, unsigned int> & a,
+                  const pair<string, unsigned int> & b ) {
+                  if( a.second != b.second ) {
+                      return a.second > b.second;
+                  }
+                  return a.first < b.first;
+              } );
+
+        for( unsigned int k : {1u, 4u, 50u} ) {
+            vector<string> expected;
+            for( unsigned int i = 0; i < found.size() && i < k; i++ ) {
+                expected.push_back( found[i].first );
+            }
+            vector<string> list = dict.predictUnderscores( pattern, k );
+            ASSERT_EQ( list, expected ) << pattern;
+            for( auto & word : list ) {
+                ASSERT_TRUE( validUtf8( word ) );
+            }
+        }
+    }
+}
@@ -0,0 +1,103 @@
+/**
+ * This file is a tester for the WorkStealingPool class and the batch
+ * query API built on it. The tests check that parallelFor() runs every
+ * index exactly once, for any pool size and grain, that uneven work is
+ * spread over the threads, and that predictBatch() answers the same as
+ * single queries.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources:
+ */
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "DictionaryTrie.hpp"
+#include "WorkStealingPool.hpp"
+
+using namespace std;
+using namespace testing;
+
+TEST(WorkStealingPoolTests, COVERS_EVERY_INDEX_TEST) {
+    for( unsigned int threads = 1; threads <= 4; threads++ ) {
+        WorkStealingPool pool( threads );
+        ASSERT_EQ( pool.size(), threads );
+        for( size_t count : { 0, 1, 7, 100, 1001 } ) {
+            for( size_t grain : { 1, 3, 64 } ) {
+                vector<atomic<int>> hits( count );
+                for( size_t i = 0; i < count; i++ ) {
+                    hits[i].store( 0 );
+                }
+                pool.parallelFor( count, grain, [&]( size_t b, size_t e ) {
+                    ASSERT_LE( e - b, grain );
+                    for( size_t i = b; i < e; i++ ) {
+                        hits[i]++;
+                    }
+                } );
+                for( size_t i = 0; i < count; i++ ) {
+                    ASSERT_EQ( hits[i].load(), 1 );
+                }
+            }
+        }
+    }
+}
+
+TEST(WorkStealingPoolTests, UNEVEN_WORK_TEST) {
+    //all the slow items are dealt to the caller's queue, so another
+    //thread only runs one of them by stealing it
+    WorkStealingPool pool( 3 );
+    thread::id caller = this_thread::get_id();
+    atomic<int> stolen( 0 );
+    pool.parallelFor( 30, 1, [&]( size_t b, size_t e ) {
+        if( b < 10 ) {
+            this_thread::sleep_for( chrono::milliseconds(2) );
+            if( this_thread::get_id() != caller ) {
+                stolen++;
+            }
+        }
+        (void) e;
+    } );
+    ASSERT_GT( stolen.load(), 0 );
+}
+
+TEST(WorkStealingPoolTests, PREDICT_BATCH_TEST) {
+    DictionaryTrie dict;
+    vector<pair<string, unsigned int>> words = {
+        {"animal", 100}, {"acme", 90},     {"coffee", 10}, {"animation", 100},
+        {"anarchy", 5},  {"beauty", 20},   {"an", 1000},   {"annihilate", 50},
+        {"anagram", 10}, {"ant", 10},      {"a", 10}};
+    for( auto & w : words ) {
+        dict.insert( w.first, w.second );
+    }
+
+    vector<CompletionQuery> queries;
+    vector<string> texts = {"a", "an", "", "b", "z", "an_", "a___", "____"};
+    for( unsigned int i = 0; i < 200; i++ ) {
+        queries.push_back( CompletionQuery{ texts[i % texts.size()],
+                                            i % 5 } );
+    }
+
+    for( unsigned int threads = 1; threads <= 3; threads++ ) {
+        dict.setBatchThreads( threads );
+        vector<vector<string>> results =
+            dict.predictBatch( queries.data(), queries.size() );
+        ASSERT_EQ( results.size(), queries.size() );
+        for( unsigned int i = 0; i < queries.size(); i++ ) {
+            if( queries[i].text.find('_') != string::npos ) {
+                ASSERT_EQ( results[i],
+                           dict.predictUnderscores( queries[i].text,
+                                                    queries[i].numCompletions ) );
+            } else {
+                ASSERT_EQ( results[i],
+                           dict.predictCompletions( queries[i].text,
+                                                    queries[i].numCompletions ) );
+            }
+        }
+    }
+    ASSERT_EQ( dict.predictBatch( queries.data(), 0 ).size(), 0 );
+}
@@ -0,0 +1,186 @@
+/**
+ * This file is a tester for the dictionary parsing functions in Utils.
+ * The methods tested here are parseLine, the stream loaders and the
+ * in-place file loader. LatencyHistogram, used by the replay tool, is
+ * tested here too.
+ *
+ * Author: Christian Kouris
+ * Email: ckouris@ucsd.edu
+ * Sources:
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "DictionaryTrie.hpp"
+#include "util.hpp"
+
+using namespace std;
+using namespace testing;
+
+static const string DICT_FILE = "test_util_dict.txt";
+
+TEST(UtilTests, PARSE_LINE_TEST) {
+    unsigned int freq;
+    string_view word;
+    string scratch;
+    ASSERT_EQ( Utils::parseLine("42 hello world", freq, word, scratch), true );
+    ASSERT_EQ( freq, 42 );
+    ASSERT_EQ( word, "hello world" );
+    ASSERT_EQ( Utils::parseLine("", freq, word, scratch), false );
+    ASSERT_EQ( Utils::parseLine("no freq", freq, word, scratch), false );
+}
+
+TEST(UtilTests, PARSE_LINE_WHITESPACE_TEST) {
+    unsigned int freq;
+    string_view word;
+    string scratch;
+    ASSERT_EQ( Utils::parseLine("  7\t a   b\tc \r", freq, word, scratch),
+               true );
+    ASSERT_EQ( freq, 7 );
+    ASSERT_EQ( word, "a b c" );
+    Utils::parseLine("3 x . y", freq, word, scratch);
+    ASSERT_EQ( word, "x" );
+    Utils::parseLine("9", freq, word, scratch);
+    ASSERT_EQ( word, "" );
+}
+
+TEST(UtilTests, LOAD_DICT_FILE_TEST) {
+    ofstream out( DICT_FILE, ios::binary );
+    out << "100 animal\n90 acme\n10 coffee  cup\n\n5 anarchy";
+    out.close();
+
+    DictionaryTrie dict;
+    LoadStats stats;
+    ASSERT_EQ( Utils::loadDictFile(dict, DICT_FILE, UINT_MAX, &stats), true );
+    ASSERT_EQ( stats.lines, 5 );
+    ASSERT_EQ( dict.find("animal"), true );
+    ASSERT_EQ( dict.find("coffee cup"), true );
+    ASSERT_EQ( dict.find("anarchy"), true );
+
+    DictionaryTrie limited;
+    Utils::loadDictFile(limited, DICT_FILE, 2);
+    ASSERT_EQ( limited.find("acme"), true );
+    ASSERT_EQ( limited.find("coffee cup"), false );
+    remove( DICT_FILE.c_str() );
+
+    ASSERT_EQ( Utils::loadDictFile(dict, "no_such_dict.txt"), false );
+}
+
+TEST(UtilTests, STREAM_AND_FILE_AGREE_TEST) {
+    string text = "5 hello   world\n7\t a\tb \r\n 9  lead\n4 single\n";
+    ofstream out( DICT_FILE, ios::binary );
+    out << text;
+    out.close();
+
+    vector<string> fromStream;
+    istringstream in( text );
+    Utils::loadDict(fromStream, in);
+    vector<string> fromFile;
+    Utils::scanDictFile(DICT_FILE, UINT_MAX,
+                        [&fromFile](string_view word, unsigned int) {
+                            fromFile.push_back(string(word));
+                        });
+    ASSERT_EQ( fromStream, fromFile );
+    ASSERT_EQ( fromFile[1], "a b" );
+    remove( DICT_FILE.c_str() );
+}
+
+TEST(UtilTests, LOAD_DICT_PARALLEL_TEST) {
+    ofstream out( DICT_FILE, ios::binary );
+    out << "100 animal\n90 acme\n10 coffee  cup\n5 anarchy\n20 beauty\n"
+        << "1000 an\n50 annihilate\n7 acme\n10 anagram\n3 zebra\n8 band";
+    out.close();
+
+    DictionaryTrie serial;
+    Utils::loadDictFile(serial, DICT_FILE);
+    for( unsigned int threads = 1; threads <= 5; threads++ ) {
+        DictionaryTrie parallel;
+        LoadStats stats;
+        ASSERT_EQ( Utils::loadDictParallel(parallel, DICT_FILE, threads,
+                                           &stats), true );
+        ASSERT_EQ( stats.lines, 11 );
+        ASSERT_EQ( parallel.memoryBytes(), serial.memoryBytes() );
+        ASSERT_EQ( parallel.find("coffee cup"), true );
+        for( string prefix : {"", "a", "an", "b", "z"} ) {
+            ASSERT_EQ( parallel.predictCompletions(prefix, 20),
+                       serial.predictCompletions(prefix, 20) );
+        }
+    }
+    remove( DICT_FILE.c_str() );
+}
+
+TEST(UtilTests, LOAD_DICT_PARALLEL_UTF8_TEST) {
+    //the third word has a cut off two byte letter
+    ofstream out( DICT_FILE, ios::binary );
+    out << "100 \xce\xbb\xce\xb1\n90 acme\n10 b\xce\n5 band\n";
+    out.close();
+
+    for( unsigned int threads = 1; threads <= 3; threads++ ) {
+        DictionaryTrie parallel;
+        parallel.setUtf8(true);
+        ASSERT_EQ( Utils::loadDictParallel(parallel, DICT_FILE, threads),
+                   true );
+        ASSERT_EQ( parallel.find("\xce\xbb\xce\xb1"), true );
+        ASSERT_EQ( parallel.find("band"), true );
+        ASSERT_EQ( parallel.find("b\xce"), false );
+        ASSERT_EQ( parallel.predictUnderscores("__", 5).size(), 1 );
+    }
+
+    //a shard in the other mode is not stitched in
+    DictionaryTrie utf8;
+    utf8.setUtf8(true);
+    DictionaryTrie bytes;
+    bytes.insert("b\xce", 1);
+    ASSERT_EQ( utf8.absorb(bytes), false );
+    ASSERT_EQ( utf8.find("b\xce"), false );
+    remove( DICT_FILE.c_str() );
+}
+
+TEST(UtilTests, LATENCY_HISTOGRAM_TEST) {
+    LatencyHistogram hist;
+    ASSERT_EQ( hist.count(), 0 );
+    ASSERT_EQ( hist.valueAt(0.99), 0 );
+
+    //small values are exact
+    for( long long v = 1; v <= 100; v++ ) {
+        hist.record(v);
+    }
+    ASSERT_EQ( hist.count(), 100 );
+    ASSERT_EQ( hist.min(), 1 );
+    ASSERT_EQ( hist.max(), 100 );
+    ASSERT_EQ( hist.valueAt(0.5), 50 );
+    ASSERT_EQ( hist.valueAt(0.99), 99 );
+    ASSERT_EQ( hist.valueAt(1.0), 100 );
+    ASSERT_DOUBLE_EQ( hist.mean(), 50.5 );
+
+    //big values are within the precision of their bucket
+    LatencyHistogram big;
+    for( long long v : {1000000LL, 5000000LL, 123456789LL} ) {
+        big.record(v);
+        long long got = big.valueAt(1.0);
+        ASSERT_EQ( got, v );
+        LatencyHistogram one;
+        one.record(v);
+        one.record(v + 1);
+        ASSERT_GE( one.valueAt(0.5), v );
+        ASSERT_LE( one.valueAt(0.5), v + v / 64 );
+    }
+    big.record(-5);
+    ASSERT_EQ( big.min(), 0 );
+
+    //adding keeps the counts of both
+    hist.add(big);
+    ASSERT_EQ( hist.count(), 104 );
+    ASSERT_EQ( hist.min(), 0 );
+    ASSERT_EQ( hist.max(), 123456789LL );
+    ASSERT_EQ( hist.valueAt(0.5), 51 );
+
+    ostringstream out;
+    hist.printDistribution(out, 1.0);
+    ASSERT_NE( out.str().find("inf"), string::npos );
+}